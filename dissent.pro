@@ -87,6 +87,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Connections/RelayEdgeListener.hpp \
            src/Connections/RelayForwarder.hpp \
            src/Crypto/AsymmetricKey.hpp \
+           src/Crypto/CppCtrRandom.hpp \
            src/Crypto/CppDiffieHellman.hpp \
            src/Crypto/CppDsaPrivateKey.hpp \
            src/Crypto/CppDsaPublicKey.hpp \
@@ -100,7 +101,9 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Crypto/CryptoFactory.hpp \
            src/Crypto/DiffieHellman.hpp \
            src/Crypto/NullDiffieHellman.hpp \
+           src/Crypto/GroupNeffShuffle.hpp \
            src/Crypto/Hash.hpp \
+           src/Crypto/Hmac.hpp \
            src/Crypto/Integer.hpp \
            src/Crypto/IntegerData.hpp \
            src/Crypto/KeyShare.hpp \
@@ -126,9 +129,11 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Crypto/AbstractGroup/CppECGroup.hpp \
            src/Crypto/AbstractGroup/ECParams.hpp \
            src/Crypto/AbstractGroup/Element.hpp \
+           src/Crypto/AbstractGroup/FixedBase.hpp \
            src/Crypto/AbstractGroup/ElementData.hpp \
            src/Crypto/AbstractGroup/IntegerElementData.hpp \
            src/Crypto/AbstractGroup/IntegerGroup.hpp \
+           src/Crypto/AbstractGroup/MultiExponentiation.hpp \
            src/Crypto/AbstractGroup/OpenECElementData.hpp \
            src/Crypto/AbstractGroup/OpenECGroup.hpp \
            src/Crypto/AbstractGroup/PairingElementData.hpp \
@@ -145,6 +150,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Crypto/BlogDrop/ClientCiphertext.hpp \
            src/Crypto/BlogDrop/ElGamalClientCiphertext.hpp \
            src/Crypto/BlogDrop/ElGamalServerCiphertext.hpp \
+           src/Crypto/BlogDrop/HashedGeneratorCache.hpp \
            src/Crypto/BlogDrop/HashingGenClientCiphertext.hpp \
            src/Crypto/BlogDrop/HashingGenServerCiphertext.hpp \
            src/Crypto/BlogDrop/PairingClientCiphertext.hpp \
@@ -211,6 +217,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Transports/EdgeListenerFactory.hpp \
            src/Transports/TcpAddress.hpp \
            src/Transports/TcpEdge.hpp \
+           src/Transports/TcpEdgeWorker.hpp \
            src/Transports/TcpEdgeListener.hpp \
            src/Tunnel/EntryTunnel.hpp \
            src/Tunnel/ExitTunnel.hpp \
@@ -231,6 +238,8 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Utils/Serialization.hpp \
            src/Utils/SignalCounter.hpp \
            src/Utils/Sleeper.hpp \
+           src/Utils/SpillFile.hpp \
+           src/Utils/SpscQueue.hpp \
            src/Utils/StartStop.hpp \
            src/Utils/StartStopSlots.hpp \
            src/Utils/Time.hpp \
@@ -240,6 +249,7 @@ HEADERS += ext/joyent-http-parser/http_parser.h \
            src/Utils/Triggerable.hpp \
            src/Utils/Triple.hpp \
            src/Utils/Utils.hpp \
+           src/Utils/XorEngine.hpp \
            src/Web/HttpRequest.hpp \
            src/Web/HttpResponse.hpp \
            src/Web/WebRequest.hpp \
@@ -309,6 +319,7 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Connections/RelayEdgeListener.cpp \
            src/Connections/RelayForwarder.cpp \
            src/Crypto/AsymmetricKey.cpp \
+           src/Crypto/CppCtrRandom.cpp \
            src/Crypto/CppDiffieHellman.cpp \
            src/Crypto/CppDsaPrivateKey.cpp \
            src/Crypto/CppDsaPublicKey.cpp \
@@ -319,6 +330,8 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Crypto/CppRandom.cpp \
            src/Crypto/CryptoFactory.cpp \
            src/Crypto/DiffieHellman.cpp \
+           src/Crypto/GroupNeffShuffle.cpp \
+           src/Crypto/Hmac.cpp \
            src/Crypto/KeyShare.cpp \
            src/Crypto/LRSPrivateKey.cpp \
            src/Crypto/LRSPublicKey.cpp \
@@ -347,6 +360,7 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Crypto/BlogDrop/ClientCiphertext.cpp \
            src/Crypto/BlogDrop/ElGamalClientCiphertext.cpp \
            src/Crypto/BlogDrop/ElGamalServerCiphertext.cpp \
+           src/Crypto/BlogDrop/HashedGeneratorCache.cpp \
            src/Crypto/BlogDrop/HashingGenClientCiphertext.cpp \
            src/Crypto/BlogDrop/HashingGenServerCiphertext.cpp \
            src/Crypto/BlogDrop/PairingClientCiphertext.cpp \
@@ -386,6 +400,7 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Transports/EdgeListenerFactory.cpp \
            src/Transports/TcpAddress.cpp \
            src/Transports/TcpEdge.cpp \
+           src/Transports/TcpEdgeWorker.cpp \
            src/Transports/TcpEdgeListener.cpp \
            src/Tunnel/EntryTunnel.cpp \
            src/Tunnel/ExitTunnel.cpp \
@@ -403,11 +418,13 @@ SOURCES += ext/joyent-http-parser/http_parser.c \
            src/Utils/Logging.cpp \
            src/Utils/Random.cpp \
            src/Utils/Sleeper.cpp \
+           src/Utils/SpillFile.cpp \
            src/Utils/StartStop.cpp \
            src/Utils/Time.cpp \
            src/Utils/Timer.cpp \
            src/Utils/TimerEvent.cpp \
            src/Utils/Utils.cpp \
+           src/Utils/XorEngine.cpp \
            src/Web/HttpRequest.cpp \
            src/Web/HttpResponse.cpp \
            src/Web/WebRequest.cpp \
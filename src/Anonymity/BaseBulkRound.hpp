@@ -75,6 +75,13 @@ namespace Anonymity {
        */
       static void Xor(QByteArray &dst, const QByteArray &t1, const QByteArray &t2);
 
+      /**
+       * Xors every source into dst in a single pass over dst
+       * @param dst the destination byte array
+       * @param sources the byte arrays to fold into dst
+       */
+      static void Xor(QByteArray &dst, const QList<QByteArray> &sources);
+
       inline virtual const QVector<int> &GetBadMembers() const
       {
         return _bad_members;
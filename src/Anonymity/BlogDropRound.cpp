@@ -209,7 +209,7 @@ namespace Anonymity {
   {
     Q_ASSERT(IsServer());
 
-    QByteArray msg = data + GetSigningKey()->Sign(data);
+    QByteArray msg = SignMessage(data);
     foreach(const PublicIdentity &pi, GetGroup().GetSubgroup()) {
       GetNetwork()->Send(pi.GetId(), msg);
     }
@@ -219,7 +219,7 @@ namespace Anonymity {
   {
     Q_ASSERT(IsServer());
 
-    QByteArray msg = data + GetSigningKey()->Sign(data);
+    QByteArray msg = SignMessage(data);
     foreach(const QSharedPointer<Connection> &con,
         GetNetwork()->GetConnectionManager()->
         GetConnectionTable().GetConnections())
@@ -269,6 +269,9 @@ namespace Anonymity {
     if(_server_state) {
       _server_state->client_ciphertexts.clear();
       _server_state->server_ciphertexts.clear();
+      _server_state->unfolded_clients.clear();
+      _server_state->unfolded_servers.clear();
+      _server_state->bins_closed = false;
 
       for(int slot_idx=0; slot_idx<_state->n_clients; slot_idx++) {
         _server_state->blogdrop_servers[slot_idx]->ClearBin();
@@ -287,6 +290,9 @@ namespace Anonymity {
     for(int slot_idx=0; slot_idx<_state->n_clients; slot_idx++) {
       _state->blogdrop_clients[slot_idx]->NextPhase();
       //qDebug() << "Client slot" << slot_idx << "phase" << _state->blogdrop_clients[slot_idx]->GetPhase();
+      if(SlotIsOpen(slot_idx)) {
+        _state->blogdrop_clients[slot_idx]->PrecomputeGenerators();
+      }
     }
 
     _state->blogdrop_author->NextPhase();
@@ -558,6 +564,8 @@ namespace Anonymity {
     stream >> payload;
 
     _server_state->client_ciphertexts[from] = payload;
+    _server_state->unfolded_clients.append(from);
+    FoldCiphertexts();
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
       ": received client ciphertext from" << GetGroup().GetIndex(from) <<
@@ -606,6 +614,8 @@ namespace Anonymity {
       }
 
       _server_state->client_ciphertexts.unite(remote_ctexts);
+      _server_state->unfolded_clients += remote_ctexts.keys();
+      FoldCiphertexts();
     }
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
@@ -613,9 +623,7 @@ namespace Anonymity {
       from.ToString() << "Have" << _server_state->handled_servers.count()
       << "expecting" << GetGroup().GetSubgroup().Count();
 
-    if(_server_state->handled_servers.count() == GetGroup().GetSubgroup().Count()) {
-      _state_machine.StateComplete();
-    }
+    CheckCiphertextsFolded();
   }
 
   void BlogDropRound::HandleServerCiphertext(const Id &from, QDataStream &stream)
@@ -636,16 +644,17 @@ namespace Anonymity {
     stream >> ciphertext;
 
     _server_state->handled_servers.insert(from);
-    _server_state->server_ciphertexts[GetGroup().GetSubgroup().GetIndex(from)] = ciphertext;
+    int server_idx = GetGroup().GetSubgroup().GetIndex(from);
+    _server_state->server_ciphertexts[server_idx] = ciphertext;
+    _server_state->unfolded_servers.append(server_idx);
+    FoldCiphertexts();
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
       ": received ciphertext from" << GetGroup().GetIndex(from) <<
       from.ToString() << "Have" << _server_state->handled_servers.count()
       << "expecting" << GetGroup().GetSubgroup().Count();
 
-    if(_server_state->handled_servers.count() == GetGroup().GetSubgroup().Count()) {
-      _state_machine.StateComplete();
-    }
+    CheckCiphertextsFolded();
   }
 
   void BlogDropRound::HandleServerValidation(const Id &from, QDataStream &stream)
@@ -909,7 +918,7 @@ namespace Anonymity {
     }
 
     _state->master_server_pk_set = QSharedPointer<const PublicKeySet>(
-        new PublicKeySet(_state->params, _state->master_server_pks.values()));
+        new PublicKeySet(_state->params, _state->master_server_pks.values(), true));
 
     _state->blogdrop_author = QSharedPointer<BlogDropAuthor>(
         new BlogDropAuthor(
@@ -941,6 +950,10 @@ namespace Anonymity {
       _state->master_server_pks_list.append(_state->master_server_pks[server_idx]);
     }
 
+    for(int slot_idx=0; slot_idx<_state->n_clients; slot_idx++) {
+      _state->blogdrop_clients[slot_idx]->PrecomputeGenerators();
+    }
+
     // Dont need to hold the keys once the BlogDropClients
     // are initialized
     _state->slot_pks.clear();
@@ -1090,6 +1103,8 @@ namespace Anonymity {
   void BlogDropRound::GenerateClientCiphertextDoneServer(QByteArray mycipher) {
     // Add my own ciphertext to the set
     _server_state->client_ciphertexts[GetLocalId()] = mycipher;
+    _server_state->unfolded_clients.append(GetLocalId());
+    FoldCiphertexts();
 
     QByteArray payload;
     QDataStream stream(&payload, QIODevice::WriteOnly);
@@ -1110,6 +1125,10 @@ namespace Anonymity {
 
   void BlogDropRound::GenerateServerCiphertextDone() 
   {
+    // Fold the server ciphertexts that arrived while closing the bins
+    _server_state->bins_closed = true;
+    FoldCiphertexts();
+
     QByteArray payload;
     QDataStream stream(&payload, QIODevice::WriteOnly);
     stream << SERVER_CIPHERTEXT << GetRoundId() <<
@@ -1137,6 +1156,88 @@ namespace Anonymity {
     VerifiableBroadcastToServers(payload);
   }
 
+  void BlogDropRound::FoldCiphertexts()
+  {
+    if(_server_state->folding) {
+      return;
+    }
+
+    QList<QByteArray> ctexts;
+    QList<QSharedPointer<const PublicKey> > pks;
+
+    if(!_server_state->unfolded_clients.isEmpty()) {
+      foreach(const Id &id, _server_state->unfolded_clients) {
+        if(!_state->master_client_pks.contains(id)) {
+          qWarning() << "Missing client pk";
+          continue;
+        }
+
+        ctexts.append(_server_state->client_ciphertexts[id]);
+        pks.append(_state->master_client_pks[id]);
+      }
+      _server_state->unfolded_clients.clear();
+
+      BlogDropPrivate::FoldClientCiphertexts *fold =
+        new BlogDropPrivate::FoldClientCiphertexts(this, ctexts, pks);
+      QObject::connect(fold, SIGNAL(Finished(bool)),
+          this, SLOT(FoldCiphertextsDone(bool)));
+      _server_state->folding = true;
+      QThreadPool::globalInstance()->start(fold);
+    } else if(_server_state->bins_closed &&
+        !_server_state->unfolded_servers.isEmpty())
+    {
+      foreach(int server_idx, _server_state->unfolded_servers) {
+        ctexts.append(_server_state->server_ciphertexts[server_idx]);
+        pks.append(_state->master_server_pks_list[server_idx]);
+      }
+      _server_state->unfolded_servers.clear();
+
+      BlogDropPrivate::FoldServerCiphertexts *fold =
+        new BlogDropPrivate::FoldServerCiphertexts(this, ctexts, pks);
+      QObject::connect(fold, SIGNAL(Finished(bool)),
+          this, SLOT(FoldCiphertextsDone(bool)));
+      _server_state->folding = true;
+      QThreadPool::globalInstance()->start(fold);
+    }
+  }
+
+  void BlogDropRound::FoldCiphertextsDone(bool valid)
+  {
+    _server_state->folding = false;
+    if(Stopped()) {
+      return;
+    }
+
+    if(!valid) {
+      Stop("Server submitted invalid ciphertext");
+      return;
+    }
+
+    FoldCiphertexts();
+    CheckCiphertextsFolded();
+  }
+
+  void BlogDropRound::CheckCiphertextsFolded()
+  {
+    if(_server_state->folding ||
+        !_server_state->unfolded_clients.isEmpty() ||
+        !_server_state->unfolded_servers.isEmpty())
+    {
+      return;
+    }
+
+    int state = _state_machine.GetState();
+    if(state != SERVER_WAIT_FOR_CLIENT_LISTS &&
+        state != SERVER_WAIT_FOR_SERVER_CIPHERTEXT)
+    {
+      return;
+    }
+
+    if(_server_state->handled_servers.count() == GetGroup().GetSubgroup().Count()) {
+      _state_machine.StateComplete();
+    }
+  }
+
   void BlogDropRound::PushCleartext()
   {
     QByteArray payload;
@@ -1227,57 +1328,15 @@ namespace BlogDropPrivate {
 
   void GenerateServerCiphertext::run() 
   {
-    QList<QList<QByteArray> > by_slot;
-    QList<QSharedPointer<const Crypto::BlogDrop::PublicKey> > client_pks;
-
-    for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
-      by_slot.append(QList<QByteArray>());
-    }
-
     qDebug() << _round->ToString() << "generating ciphertext for" <<
       _round->_server_state->client_ciphertexts.count() << "out of" << _round->GetGroup().Count();
 
-    // For each user
-    foreach(const Connections::Id& id, _round->_server_state->client_ciphertexts.keys()) {
-
-      QList<QByteArray> ctexts;
-      QDataStream stream(_round->_server_state->client_ciphertexts[id]);
-      stream >> ctexts;
-
-      if(ctexts.count() != _round->_state->n_clients) {
-        qWarning() << "Ciphertext vector has invalid length";
-        emit Finished();
-        return;
-      }
-
-      if(!_round->_state->client_pks.contains(id)) {
-        qWarning() << "Missing client pk";
-        emit Finished();
-        return;
-      }
-
-      // For each slot
-      for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
-        if(_round->SlotIsOpen(slot_idx)) {
-          by_slot[slot_idx].append(ctexts[slot_idx]);
-        } else {
-          //qDebug() << "Not adding client ciphertext to closed slot" << slot_idx;
-        }
-      }
-
-      client_pks.append(_round->_state->master_client_pks[id]);
-      Q_ASSERT(!_round->_state->master_client_pks[id].isNull());
-    }
-
+    // The client ciphertexts have already been folded into the bins
     QList<QByteArray> server_ctexts;
     for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
       QByteArray c;
       if(_round->SlotIsOpen(slot_idx)) {
-        Q_ASSERT(by_slot[slot_idx].count() == _round->_state->n_clients);
-
         //qDebug() << "Creating server ciphertext for slot" << slot_idx;
-        _round->_server_state->blogdrop_servers[slot_idx]->AddClientCiphertexts(by_slot[slot_idx], 
-            client_pks, _round->VerifyAllProofs);
         c = _round->_server_state->blogdrop_servers[slot_idx]->CloseBin();
       } 
 
@@ -1294,39 +1353,7 @@ namespace BlogDropPrivate {
 
   void GenerateServerValidation::run() 
   {
-    QList<QList<QByteArray> > by_slot;
-    for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
-      by_slot.append(QList<QByteArray>());
-    }
-
-    for(int server_idx=0; server_idx<_round->GetGroup().GetSubgroup().Count(); server_idx++) {
-      QList<QByteArray> server_list;
-      QDataStream stream(_round->_server_state->server_ciphertexts[server_idx]);
-      stream >> server_list;
-
-      if(server_list.count() != _round->_state->n_clients) {
-        _round->Stop("Server submitted ciphertext list of wrong length");
-        return;
-      }
-
-      for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
-        by_slot[slot_idx].append(server_list[slot_idx]);
-      }
-    }
-
-    for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
-      if(_round->SlotIsOpen(slot_idx)) {
-        if(!_round->_server_state->blogdrop_servers[slot_idx]->AddServerCiphertexts(
-                by_slot[slot_idx],
-                _round->_state->master_server_pks_list)) {
-              _round->Stop("Server submitted invalid ciphertext");
-              return;
-          }
-      } else {
-        //qDebug() << "Not adding server ciphertext to closed slot" << slot_idx;
-      }
-    }
-
+    // The server ciphertexts have already been folded into the bins
     QList<QByteArray> plaintexts;
     for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
       QByteArray plain;
@@ -1374,6 +1401,79 @@ namespace BlogDropPrivate {
 
     emit Finished(_round->GetPrivateIdentity().GetSigningKey()->Sign(_round->_state->cleartext));
   }
+
+  void FoldClientCiphertexts::run()
+  {
+    QList<QList<QByteArray> > by_slot;
+    for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
+      by_slot.append(QList<QByteArray>());
+    }
+
+    QList<QSharedPointer<const BlogDropRound::PublicKey> > client_pks;
+    for(int idx=0; idx<_ciphertexts.count(); idx++) {
+      QList<QByteArray> ctexts;
+      QDataStream stream(_ciphertexts[idx]);
+      stream >> ctexts;
+
+      if(ctexts.count() != _round->_state->n_clients) {
+        qWarning() << "Ciphertext vector has invalid length";
+        continue;
+      }
+
+      for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
+        if(_round->SlotIsOpen(slot_idx)) {
+          by_slot[slot_idx].append(ctexts[slot_idx]);
+        }
+      }
+
+      client_pks.append(_pks[idx]);
+    }
+
+    for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
+      if(_round->SlotIsOpen(slot_idx) && by_slot[slot_idx].count()) {
+        _round->_server_state->blogdrop_servers[slot_idx]->AddClientCiphertexts(
+            by_slot[slot_idx], client_pks, _round->VerifyAllProofs);
+      }
+    }
+
+    emit Finished(true);
+  }
+
+  void FoldServerCiphertexts::run()
+  {
+    QList<QList<QByteArray> > by_slot;
+    for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
+      by_slot.append(QList<QByteArray>());
+    }
+
+    for(int idx=0; idx<_ciphertexts.count(); idx++) {
+      QList<QByteArray> server_list;
+      QDataStream stream(_ciphertexts[idx]);
+      stream >> server_list;
+
+      if(server_list.count() != _round->_state->n_clients) {
+        qWarning() << "Server submitted ciphertext list of wrong length";
+        emit Finished(false);
+        return;
+      }
+
+      for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
+        by_slot[slot_idx].append(server_list[slot_idx]);
+      }
+    }
+
+    for(int slot_idx=0; slot_idx<_round->_state->n_clients; slot_idx++) {
+      if(_round->SlotIsOpen(slot_idx) &&
+          !_round->_server_state->blogdrop_servers[slot_idx]->AddServerCiphertexts(
+            by_slot[slot_idx], _pks))
+      {
+        emit Finished(false);
+        return;
+      }
+    }
+
+    emit Finished(true);
+  }
 }
 
 }
@@ -26,6 +26,8 @@ namespace BlogDropPrivate {
   class GenerateClientCiphertext;
   class GenerateServerCiphertext;
   class GenerateServerValidation;
+  class FoldClientCiphertexts;
+  class FoldServerCiphertexts;
 }
 
   class BlogDropRound : public BaseBulkRound
@@ -200,6 +202,8 @@ namespace BlogDropPrivate {
       friend class BlogDropPrivate::GenerateClientCiphertext;
       friend class BlogDropPrivate::GenerateServerCiphertext;
       friend class BlogDropPrivate::GenerateServerValidation;
+      friend class BlogDropPrivate::FoldClientCiphertexts;
+      friend class BlogDropPrivate::FoldServerCiphertexts;
 
       /**
        * Holds the internal state for this round
@@ -282,7 +286,9 @@ namespace BlogDropPrivate {
           ServerState(QSharedPointer<const Parameters> round_params) :
             State(round_params),
             server_sk(new PrivateKey(params)),
-            server_pk(new PublicKey(server_sk)) {}
+            server_pk(new PublicKey(server_sk)),
+            folding(false),
+            bins_closed(false) {}
 
           virtual ~ServerState() {}
 
@@ -311,6 +317,17 @@ namespace BlogDropPrivate {
 
           QSet<Id> handled_servers;
           QHash<int, QByteArray> server_ciphertexts;
+
+          /* Ciphertexts received but not yet folded into the bins.  Only
+           * one fold runs at a time, so a bin is never used by two threads,
+           * and ciphertexts arriving meanwhile are folded together next.
+           */
+          QList<Id> unfolded_clients;
+          QList<int> unfolded_servers;
+          bool folding;
+
+          /* Server ciphertexts can only be folded once CloseBin is done */
+          bool bins_closed;
       };
 
       /**
@@ -440,6 +457,18 @@ namespace BlogDropPrivate {
       void ProcessCleartext();
       void ConcludeClientCiphertextSubmission(const int &);
 
+      /**
+       * Starts folding any received but unfolded ciphertexts into the
+       * bins, unless a fold is already running
+       */
+      void FoldCiphertexts();
+
+      /**
+       * Completes the current state once every expected ciphertext has
+       * been received and folded
+       */
+      void CheckCiphertextsFolded();
+
       inline bool SlotIsOpen(int slot_idx);
 
       QSharedPointer<Parameters> _params;
@@ -453,6 +482,7 @@ namespace BlogDropPrivate {
       void GenerateClientCiphertextDoneServer(QByteArray mycipher);
       void GenerateServerCiphertextDone();
       void GenerateServerValidationDone(QByteArray signature);
+      void FoldCiphertextsDone(bool valid);
 
   };
 
@@ -551,6 +581,54 @@ namespace BlogDropPrivate {
     private:
       BlogDropRound *_round;
   };
+
+  /**
+   * Verifies and folds a batch of client ciphertext vectors into the bins
+   */
+  class FoldClientCiphertexts : public QObject, public QRunnable {
+    Q_OBJECT
+
+    public:
+      FoldClientCiphertexts(BlogDropRound *round,
+          const QList<QByteArray> &ciphertexts,
+          const QList<QSharedPointer<const BlogDropRound::PublicKey> > &pks) :
+        _round(round), _ciphertexts(ciphertexts), _pks(pks) { }
+
+      virtual ~FoldClientCiphertexts() { }
+      virtual void run();
+
+    signals:
+      void Finished(bool);
+
+    private:
+      BlogDropRound *_round;
+      QList<QByteArray> _ciphertexts;
+      QList<QSharedPointer<const BlogDropRound::PublicKey> > _pks;
+  };
+
+  /**
+   * Verifies and folds a batch of server ciphertext vectors into the bins
+   */
+  class FoldServerCiphertexts : public QObject, public QRunnable {
+    Q_OBJECT
+
+    public:
+      FoldServerCiphertexts(BlogDropRound *round,
+          const QList<QByteArray> &ciphertexts,
+          const QList<QSharedPointer<const BlogDropRound::PublicKey> > &pks) :
+        _round(round), _ciphertexts(ciphertexts), _pks(pks) { }
+
+      virtual ~FoldServerCiphertexts() { }
+      virtual void run();
+
+    signals:
+      void Finished(bool);
+
+    private:
+      BlogDropRound *_round;
+      QList<QByteArray> _ciphertexts;
+      QList<QSharedPointer<const BlogDropRound::PublicKey> > _pks;
+  };
 }
 }
 }
@@ -8,6 +8,7 @@
 #include "Utils/QRunTimeError.hpp"
 #include "Utils/Random.hpp"
 #include "Utils/Serialization.hpp"
+#include "Utils/XorEngine.hpp"
 
 #include "BulkRound.hpp"
 #include "ShuffleRound.hpp"
@@ -64,13 +65,11 @@ namespace Anonymity {
 
   void Xor(QByteArray &dst, const QByteArray &t1, const QByteArray &t2)
   {
-    /// @todo use qint64 or qint32 depending on architecture
     int count = std::min(dst.size(), t1.size());
     count = std::min(count, t2.size());
 
-    for(int idx = 0; idx < count; idx++) {
-      dst[idx] = t1[idx] ^ t2[idx];
-    }
+    char *cdst = dst.data();
+    Utils::XorEngine::Xor(cdst, t1.constData(), t2.constData(), count);
   }
 
   void BulkRound::OnStart()
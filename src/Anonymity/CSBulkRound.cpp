@@ -6,15 +6,22 @@
  * Consider how to have server exchange ciphertext bits ... already know both colluding parties one needs to submit the shared secret
  */
 
+#include <string.h>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
 #include "Crypto/Hash.hpp"
 #include "Identity/PublicIdentity.hpp"
 #include "Utils/Random.hpp"
 #include "Utils/QRunTimeError.hpp"
 #include "Utils/Serialization.hpp"
+#include "Utils/SpillFile.hpp"
 #include "Utils/Time.hpp"
 #include "Utils/Timer.hpp"
 #include "Utils/TimerCallback.hpp"
 #include "Utils/Utils.hpp"
+#include "Utils/XorEngine.hpp"
 
 #include "NeffShuffle.hpp"
 #include "NeffKeyShuffle.hpp"
@@ -31,14 +38,74 @@ namespace Dissent {
   using Utils::Serialization;
 
 namespace Anonymity {
+namespace {
+  /**
+   * Zero runs shorter than this stay inside a sparse cleartext run, since
+   * starting a new run costs two ints
+   */
+  const int SPARSE_MIN_ZERO_RUN = 8;
+
+  /**
+   * The subset of the pad generators expanded by a single worker
+   */
+  struct PadJob {
+    QList<QSharedPointer<Utils::Random> > rngs;
+    QList<int> gidxs;
+    int length;
+    bool log_pads;
+  };
+
+  /**
+   * The xor of all pads in a PadJob and, if requested, the pads themselves
+   * indexed by group index
+   */
+  struct PadResult {
+    QByteArray partial;
+    QHash<int, QByteArray> pads;
+  };
+
+  PadResult ExpandPads(const PadJob &job)
+  {
+    PadResult result;
+    result.partial = QByteArray(job.length, 0);
+
+    for(int idx = 0; idx < job.rngs.count(); idx++) {
+      if(!job.log_pads) {
+        job.rngs[idx]->XorBlock(result.partial);
+        continue;
+      }
+
+      QByteArray pad(job.length, 0);
+      job.rngs[idx]->GenerateBlock(pad);
+      result.pads[job.gidxs[idx]] = pad;
+      BaseBulkRound::Xor(result.partial, result.partial, pad);
+    }
+    return result;
+  }
+}
+
   CSBulkRound::CSBulkRound(const Group &group, const PrivateIdentity &ident,
       const Id &round_id, QSharedPointer<Network> network,
-      GetDataCallback &get_data, CreateRound create_shuffle) :
+      GetDataCallback &get_data, CreateRound create_shuffle,
+      Library::RngType pad_rng) :
     BaseBulkRound(group, ident, round_id, network, get_data, create_shuffle),
     _state_machine(this),
     _stop_next(false),
+    _pad_rng_type(pad_rng),
+    _accusations_enabled(true),
+    _compact_blame_logs(false),
+    _pad_pipeline_depth(1),
+    _reduce_scatter(false),
     _get_blame_data(this, &CSBulkRound::GetBlameData)
   {
+    // Ciphertexts and the messages servers exchange to combine them are
+    // never shown to a third party, so per-link MACs suffice; commits and
+    // everything used as blame evidence remain signed
+    QSet<int> mac_types;
+    mac_types << CLIENT_CIPHERTEXT << SERVER_CLIENT_LIST <<
+      SERVER_CIPHERTEXT << SERVER_AGGREGATE << SERVER_VALIDATION;
+    SetMacMessageTypes(mac_types);
+
     _state_machine.AddState(OFFLINE);
     _state_machine.AddState(SHUFFLING, -1, 0, &CSBulkRound::StartShuffle);
     _state_machine.AddState(PREPARE_FOR_BULK, -1, 0,
@@ -106,7 +173,7 @@ namespace Anonymity {
 
     _server_state->current_phase_log =
       QSharedPointer<PhaseLog>(
-          new PhaseLog(_state_machine.GetPhase(), GetGroup().Count()));
+          new PhaseLog(_state_machine.GetPhase()));
     _server_state->phase_logs[_state_machine.GetPhase()] =
       _server_state->current_phase_log;
 
@@ -138,9 +205,15 @@ namespace Anonymity {
     _state_machine.AddState(SERVER_WAIT_FOR_SERVER_CIPHERTEXT,
         SERVER_CIPHERTEXT, &CSBulkRound::HandleServerCiphertext,
         &CSBulkRound::SubmitServerCiphertext);
+    _state_machine.AddState(SERVER_WAIT_FOR_SERVER_AGGREGATE,
+        SERVER_AGGREGATE, &CSBulkRound::HandleServerAggregate,
+        &CSBulkRound::SubmitAggregate);
     _state_machine.AddState(SERVER_WAIT_FOR_SERVER_VALIDATION,
         SERVER_VALIDATION, &CSBulkRound::HandleServerValidation,
         &CSBulkRound::SubmitValidation);
+    _state_machine.AddState(SERVER_WAIT_FOR_SERVER_AUDIT,
+        SERVER_AUDIT, &CSBulkRound::HandleServerAudit,
+        &CSBulkRound::SubmitAudit);
     _state_machine.AddState(SERVER_PUSH_CLEARTEXT, -1, 0,
         &CSBulkRound::PushCleartext);
     _state_machine.AddState(SERVER_TRANSMIT_BLAME_BITS, -1, 0,
@@ -167,6 +240,8 @@ namespace Anonymity {
     _state_machine.AddTransition(SERVER_WAIT_FOR_SERVER_COMMITS,
         SERVER_WAIT_FOR_SERVER_CIPHERTEXT);
     _state_machine.AddTransition(SERVER_WAIT_FOR_SERVER_CIPHERTEXT,
+        SERVER_WAIT_FOR_SERVER_AGGREGATE);
+    _state_machine.AddTransition(SERVER_WAIT_FOR_SERVER_AGGREGATE,
         SERVER_WAIT_FOR_SERVER_VALIDATION);
     _state_machine.AddTransition(SERVER_WAIT_FOR_SERVER_VALIDATION,
         SERVER_PUSH_CLEARTEXT);
@@ -225,13 +300,21 @@ namespace Anonymity {
   {
   }
 
-  void CSBulkRound::VerifiableBroadcastToServers(const QByteArray &data)
+  void CSBulkRound::VerifiableBroadcastToServers(const QByteArray &data,
+      bool transferable)
   {
     Q_ASSERT(IsServer());
 
-    QByteArray msg = data + GetSigningKey()->Sign(data);
+    if(transferable || !AllowsMac(data)) {
+      QByteArray msg = SignMessage(data);
+      foreach(const PublicIdentity &pi, GetGroup().GetSubgroup()) {
+        GetNetwork()->Send(pi.GetId(), msg);
+      }
+      return;
+    }
+
     foreach(const PublicIdentity &pi, GetGroup().GetSubgroup()) {
-      GetNetwork()->Send(pi.GetId(), msg);
+      GetNetwork()->Send(pi.GetId(), AuthenticateMessage(pi.GetId(), data));
     }
   }
 
@@ -239,7 +322,7 @@ namespace Anonymity {
   {
     Q_ASSERT(IsServer());
 
-    QByteArray msg = data + GetSigningKey()->Sign(data);
+    QByteArray msg = SignMessage(data);
     foreach(const QSharedPointer<Connection> &con,
         GetNetwork()->GetConnectionManager()->
         GetConnectionTable().GetConnections())
@@ -266,6 +349,7 @@ namespace Anonymity {
       _server_state->client_ciphertext_period.Stop();
     }
 
+    _pad_pipeline.clear();
     _state_machine.SetState(FINISHED);
     Utils::PrintResourceUsage(ToString() + " " + "finished bulk");
     Round::OnStop();
@@ -280,6 +364,22 @@ namespace Anonymity {
 #ifndef CSBR_RECONNECTS
     if(IsServer() && GetGroup().Contains(id)) {
       _server_state->allowed_clients.remove(id);
+
+      int idx = GetGroup().GetIndex(id);
+      if(_server_state->client_offsets.contains(idx)) {
+        if(!DropClientCiphertext(idx)) {
+          Stop("Unable to remove an incomplete client ciphertext");
+          return;
+        }
+
+        if(_state_machine.GetState() == SERVER_WAIT_FOR_CLIENT_CIPHERTEXT &&
+            _server_state->submission_closed &&
+            _server_state->client_offsets.isEmpty())
+        {
+          _state_machine.StateComplete();
+          return;
+        }
+      }
     }
 #endif
 
@@ -308,8 +408,21 @@ namespace Anonymity {
   {
     if(_server_state) {
       _server_state->handled_clients.fill(false, GetGroup().Count());
-      _server_state->client_ciphertexts.clear();
-      _server_state->server_ciphertexts.clear();
+      _server_state->client_accumulator.clear();
+      _server_state->client_partials.clear();
+      _server_state->client_offsets.clear();
+      _server_state->received_clients = 0;
+      _server_state->submission_closed = false;
+      _server_state->server_accumulator.clear();
+      _server_state->server_offsets.clear();
+      _server_state->server_hashes.clear();
+      _server_state->audit_requested = false;
+      _server_state->audited = false;
+
+      // Only accusations audit past phases
+      if(!_accusations_enabled) {
+        _server_state->current_phase_log->my_ciphertext.clear();
+      }
 
       int nphase = _state_machine.GetPhase() + 1;
       if(nphase > 5) {
@@ -317,7 +430,7 @@ namespace Anonymity {
       }
       _server_state->current_phase_log =
         QSharedPointer<PhaseLog>(
-            new PhaseLog(nphase, GetGroup().Count()));
+            new PhaseLog(nphase));
       _server_state->phase_logs[nphase] = _server_state->current_phase_log;
     }
 
@@ -338,10 +451,16 @@ namespace Anonymity {
     }
 
     QHash<int, QByteArray> signatures;
+    bool sparse;
     QByteArray cleartext;
-    stream >> signatures >> cleartext;
+    stream >> signatures >> sparse >> cleartext;
 
-    if(cleartext.size() != _state->msg_length) {
+    if(sparse) {
+      QByteArray compressed = cleartext;
+      if(!ExpandCleartext(compressed, _state->msg_length, cleartext)) {
+        throw QRunTimeError("Invalid sparse cleartext");
+      }
+    } else if(cleartext.size() != _state->msg_length) {
       throw QRunTimeError("Cleartext size mismatch: " +
           QString::number(cleartext.size()) + " :: " +
           QString::number(_state->msg_length));
@@ -382,29 +501,52 @@ namespace Anonymity {
       throw QRunTimeError("Already have ciphertext");
     }
 
-    QByteArray payload;
-    stream >> payload;
+    int offset;
+    QByteArray chunk;
+    stream >> offset >> chunk;
 
-    if(payload.size() != _server_state->msg_length) {
-      throw QRunTimeError("Incorrect message length, got " +
-          QString::number(payload.size()) + " expected " +
-          QString::number(_server_state->msg_length));
+    if(_server_state->submission_closed &&
+        !_server_state->client_offsets.contains(idx))
+    {
+      throw QRunTimeError("Client submission window has closed");
     }
 
+    QByteArray &accumulator = _server_state->client_accumulator;
+    if(accumulator.isEmpty()) {
+      accumulator.fill(0, _state->msg_length);
+    }
+
+    bool complete = AccumulateChunk(accumulator.data(), _state->msg_length,
+        _server_state->client_offsets, idx, offset, chunk);
+    bool logged = _accusations_enabled && LogClientChunk(idx, chunk, complete);
+
+    if(!complete) {
+      // Kept only so the ciphertext can be xored back out should the client
+      // stall, the blame log already holds logged chunks
+      if(!logged) {
+        _server_state->client_partials[idx].append(chunk);
+      }
+      return;
+    }
+    _server_state->client_partials.remove(idx);
+
     _server_state->handled_clients[idx] = true;
-    _server_state->client_ciphertexts.append(payload);
-    _server_state->current_phase_log->messages[idx] = payload;
+    _server_state->received_clients++;
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
       ": received client ciphertext from" << GetGroup().GetIndex(from) <<
-      from.ToString() << "Have" << _server_state->client_ciphertexts.count()
+      from.ToString() << "Have" << _server_state->received_clients
       << "expecting" << _server_state->allowed_clients.count();
 
     if(_server_state->allowed_clients.count() ==
-        _server_state->client_ciphertexts.count())
+        _server_state->received_clients)
     {
       _state_machine.StateComplete();
-    } else if(_server_state->client_ciphertexts.count() ==
+    } else if(_server_state->submission_closed) {
+      if(_server_state->client_offsets.isEmpty()) {
+        _state_machine.StateComplete();
+      }
+    } else if(_server_state->received_clients ==
         _server_state->expected_clients)
     {
       // Start the flexible deadline
@@ -474,11 +616,22 @@ namespace Anonymity {
       throw QRunTimeError("Already have commit");
     }
 
-    QByteArray commit;
-    stream >> commit;
+    QList<QByteArray> commits;
+    stream >> commits;
 
+    int expected = _reduce_scatter ? GetGroup().GetSubgroup().Count() : 1;
+    if(commits.count() != expected) {
+      throw QRunTimeError("Incorrect number of segment commits, got " +
+          QString::number(commits.count()) + " expected " +
+          QString::number(expected));
+    }
+
+    int sidx = GetGroup().GetSubgroup().GetIndex(from);
     _server_state->handled_servers.insert(from);
-    _server_state->server_commits[GetGroup().GetSubgroup().GetIndex(from)] = commit;
+    _server_state->server_commits[sidx] = commits;
+    if(_reduce_scatter) {
+      _server_state->current_phase_log->server_commits[sidx] = commits;
+    }
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
       ": received commit from" << GetGroup().GetIndex(from) <<
@@ -504,27 +657,40 @@ namespace Anonymity {
       throw QRunTimeError("Already have ciphertext");
     }
 
-    QByteArray ciphertext;
-    stream >> ciphertext;
+    int offset;
+    QByteArray chunk;
+    stream >> offset >> chunk;
 
-    if(ciphertext.size() != _server_state->msg_length) {
-      throw QRunTimeError("Incorrect message length, got " +
-          QString::number(ciphertext.size()) + " expected " +
-          QString::number(_server_state->msg_length));
+    int sidx = GetGroup().GetSubgroup().GetIndex(from);
+    int my_sidx = GetGroup().GetSubgroup().GetIndex(GetLocalId());
+    int length = GetServerSegment(my_sidx).second;
+    if(_server_state->server_accumulator.isEmpty()) {
+      _server_state->server_accumulator.fill(0, length);
     }
 
-    Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-    QByteArray commit = hashalgo->ComputeHash(ciphertext);
+    bool complete = AccumulateChunk(_server_state->server_accumulator.data(),
+        length, _server_state->server_offsets, sidx, offset, chunk);
 
-    if(commit != _server_state->server_commits[
-        GetGroup().GetSubgroup().GetIndex(from)])
-    {
+    QSharedPointer<Hash> &hashalgo = _server_state->server_hashes[sidx];
+    if(!hashalgo) {
+      Library *lib = CryptoFactory::GetInstance().GetLibrary();
+      hashalgo = QSharedPointer<Hash>(lib->GetHashAlgorithm());
+    }
+    hashalgo->Update(chunk);
+
+    if(!complete) {
+      return;
+    }
+
+    QByteArray commit = hashalgo->ComputeHash();
+    _server_state->server_hashes.remove(sidx);
+
+    int cidx = _reduce_scatter ? my_sidx : 0;
+    if(commit != _server_state->server_commits[sidx].at(cidx)) {
       throw QRunTimeError("Does not match commit.");
     }
 
     _server_state->handled_servers.insert(from);
-    _server_state->server_ciphertexts[GetGroup().GetSubgroup().GetIndex(from)] = ciphertext;
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
       ": received ciphertext from" << GetGroup().GetIndex(from) <<
@@ -536,6 +702,80 @@ namespace Anonymity {
     }
   }
 
+  void CSBulkRound::HandleServerAggregate(const Id &from, QDataStream &stream)
+  {
+    if(!IsServer()) {
+      throw QRunTimeError("Not a server");
+    } else if(!GetGroup().GetSubgroup().Contains(from)) {
+      throw QRunTimeError("Not a server");
+    }
+
+    Q_ASSERT(_server_state);
+
+    if(_server_state->handled_servers.contains(from)) {
+      throw QRunTimeError("Already have aggregate");
+    }
+
+    int offset;
+    QByteArray chunk;
+    stream >> offset >> chunk;
+
+    // The first chunk carries the owner's signed commit to its aggregate
+    QByteArray commit, signature;
+    if(offset == 0) {
+      stream >> commit >> signature;
+    }
+
+    int sidx = GetGroup().GetSubgroup().GetIndex(from);
+    QPair<int, int> segment = GetServerSegment(sidx);
+    bool complete = AccumulateChunk(_state->cleartext.data() + segment.first,
+        segment.second, _server_state->server_offsets, sidx, offset, chunk);
+
+    QSharedPointer<PhaseLog> phase_log = _server_state->current_phase_log;
+    if(offset == 0) {
+      QByteArray statement = AggregateStatement(_state_machine.GetPhase(),
+          sidx, commit, phase_log->server_commits);
+      if(GetGroup().GetSubgroup().GetKey(sidx)->Verify(statement, signature)) {
+        phase_log->aggregate_commits[sidx] =
+          QPair<QByteArray, QByteArray>(commit, signature);
+      } else {
+        qWarning() << "Aggregate commit from" << sidx <<
+          "does not match the segment commits";
+        _server_state->audit_requested = true;
+      }
+    }
+
+    QSharedPointer<Hash> &hashalgo = _server_state->server_hashes[sidx];
+    if(!hashalgo) {
+      Library *lib = CryptoFactory::GetInstance().GetLibrary();
+      hashalgo = QSharedPointer<Hash>(lib->GetHashAlgorithm());
+    }
+    hashalgo->Update(chunk);
+
+    if(!complete) {
+      return;
+    }
+
+    if(!phase_log->aggregate_commits.contains(sidx) ||
+        hashalgo->ComputeHash() != phase_log->aggregate_commits[sidx].first)
+    {
+      qWarning() << "Aggregate from" << sidx << "does not match its commit";
+      _server_state->audit_requested = true;
+    }
+    _server_state->server_hashes.remove(sidx);
+
+    _server_state->handled_servers.insert(from);
+
+    qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
+      ": received aggregate from" << GetGroup().GetIndex(from) <<
+      from.ToString() << "Have" << _server_state->handled_servers.count()
+      << "expecting" << GetGroup().GetSubgroup().Count();
+
+    if(_server_state->handled_servers.count() == GetGroup().GetSubgroup().Count()) {
+      _state_machine.StateComplete();
+    }
+  }
+
   void CSBulkRound::HandleServerValidation(const Id &from, QDataStream &stream)
   {
     if(!IsServer()) {
@@ -550,15 +790,27 @@ namespace Anonymity {
       throw QRunTimeError("Already have signature.");
     }
 
+    bool audit;
     QByteArray signature;
-    stream >> signature;
-
-    if(!GetGroup().GetSubgroup().GetKey(from)->
+    stream >> audit >> signature;
+
+    // Under reduce-scatter differing cleartexts mean an owner sent
+    // differing aggregates, so the phase is audited once
+    bool can_audit = _reduce_scatter && !_server_state->audited;
+    if(audit) {
+      if(!can_audit) {
+        throw QRunTimeError("Unexpected audit request.");
+      }
+    } else if(!GetGroup().GetSubgroup().GetKey(from)->
         Verify(_state->cleartext, signature))
     {
-      throw QRunTimeError("Signature doesn't match.");
+      if(!can_audit) {
+        throw QRunTimeError("Signature doesn't match.");
+      }
+      audit = true;
     }
 
+    _server_state->audit_requested |= audit;
     _server_state->handled_servers.insert(from);
     _server_state->signatures[GetGroup().GetSubgroup().GetIndex(from)] = signature;
 
@@ -567,11 +819,117 @@ namespace Anonymity {
       from.ToString() << "Have" << _server_state->handled_servers.count()
       << "expecting" << GetGroup().GetSubgroup().Count();
 
-    if(_server_state->handled_servers.count() == GetGroup().GetSubgroup().Count()) {
+    if(_server_state->handled_servers.count() < GetGroup().GetSubgroup().Count()) {
+      return;
+    }
+
+    if(_server_state->audit_requested && !_server_state->audited) {
+      _server_state->audit_phase = _state_machine.GetPhase();
+      _state_machine.StateComplete(SERVER_WAIT_FOR_SERVER_AUDIT);
+    } else {
       _state_machine.StateComplete();
     }
   }
 
+  void CSBulkRound::HandleServerAudit(const Id &from, QDataStream &stream)
+  {
+    if(!IsServer()) {
+      throw QRunTimeError("Not a server");
+    } else if(!GetGroup().GetSubgroup().Contains(from)) {
+      throw QRunTimeError("Not a server");
+    }
+
+    Q_ASSERT(_server_state);
+
+    if(_server_state->handled_servers.contains(from)) {
+      throw QRunTimeError("Already have audit");
+    }
+
+    int offset;
+    QByteArray chunk;
+    stream >> offset >> chunk;
+
+    // The first chunk relays the aggregate commits the sender received
+    QHash<int, QPair<QByteArray, QByteArray> > commits;
+    if(offset == 0) {
+      stream >> commits;
+    }
+
+    int sidx = GetGroup().GetSubgroup().GetIndex(from);
+    int servers = GetGroup().GetSubgroup().Count();
+    QSharedPointer<PhaseLog> phase_log =
+      _server_state->phase_logs[_server_state->audit_phase];
+    int length = phase_log->my_ciphertext.size();
+
+    QByteArray &accumulator = _server_state->audit_accumulator;
+    if(accumulator.isEmpty()) {
+      accumulator.fill(0, length);
+    }
+
+    bool complete = AccumulateChunk(accumulator.data(), length,
+        _server_state->server_offsets, sidx, offset, chunk);
+
+    QHash<int, QPair<QByteArray, QByteArray> >::const_iterator it;
+    for(it = commits.constBegin(); it != commits.constEnd(); ++it) {
+      if(it.key() < 0 || it.key() >= servers) {
+        continue;
+      }
+
+      QByteArray statement = AggregateStatement(_server_state->audit_phase,
+          it.key(), it.value().first, phase_log->server_commits);
+      if(GetGroup().GetSubgroup().GetKey(it.key())->
+          Verify(statement, it.value().second))
+      {
+        _server_state->audit_commits.append(
+            QPair<int, QByteArray>(it.key(), it.value().first));
+      }
+    }
+
+    // Each segment of the ciphertext must match the sender's segment commit
+    QSharedPointer<Hash> &hashalgo = _server_state->server_hashes[sidx];
+    if(!hashalgo) {
+      Library *lib = CryptoFactory::GetInstance().GetLibrary();
+      hashalgo = QSharedPointer<Hash>(lib->GetHashAlgorithm());
+    }
+
+    int pos = offset;
+    int end = offset + chunk.size();
+    int &seg = _server_state->audit_segments[sidx];
+    while(seg < servers) {
+      QPair<int, int> segment = GetServerSegment(seg, length);
+      int seg_end = segment.first + segment.second;
+      int count = qMin(seg_end, end) - pos;
+      hashalgo->Update(QByteArray::fromRawData(
+            chunk.constData() + pos - offset, count));
+      pos += count;
+      if(pos < seg_end) {
+        break;
+      }
+
+      QByteArray hash = hashalgo->ComputeHash();
+      hashalgo->Restart();
+      if(hash != phase_log->server_commits.value(sidx).value(seg)) {
+        throw QRunTimeError("Audited ciphertext does not match commit.");
+      }
+      seg++;
+    }
+
+    if(!complete) {
+      return;
+    }
+
+    _server_state->handled_servers.insert(from);
+
+    qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId().ToString() <<
+      ": received audit from" << GetGroup().GetIndex(from) <<
+      from.ToString() << "Have" << _server_state->handled_servers.count()
+      << "expecting" << servers;
+
+    if(_server_state->handled_servers.count() == servers) {
+      ConcludeAudit();
+    }
+  }
+
   void CSBulkRound::HandleBlameBits(const Id &from, QDataStream &stream)
   {
     if(!IsServer()) {
@@ -628,17 +986,8 @@ namespace Anonymity {
       throw QRunTimeError("Invalid server claim");
     }
 
-    Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-    hashalgo->Update(shared_secret);
-
-    QByteArray bphase(4, 0);
-    Serialization::WriteInt(_server_state->current_blame.third, bphase, 0);
-    hashalgo->Update(bphase);
-
-    hashalgo->Update(GetRoundId().GetByteArray());
-    QByteArray seed = hashalgo->ComputeHash();
-    QSharedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
+    QSharedPointer<Random> rng(CreatePadRng(shared_secret,
+          _server_state->current_blame.third));
     int byte_idx = _server_state->current_blame.second / 8;
     int bit_idx = _server_state->current_blame.second % 8;
     QByteArray tmp(byte_idx + 1, 0);
@@ -869,24 +1218,157 @@ namespace Anonymity {
     }
   }
 
-  void CSBulkRound::SetupRngs()
+  bool CSBulkRound::LogClientChunk(int idx, const QByteArray &chunk,
+      bool complete)
+  {
+    QSharedPointer<PhaseLog> phase_log = _server_state->current_phase_log;
+    if(!_compact_blame_logs) {
+      phase_log->messages[idx].append(chunk);
+      return true;
+    } else if(phase_log->unloggable.contains(idx)) {
+      return false;
+    }
+
+    if(!phase_log->spill) {
+      phase_log->spill = QSharedPointer<Utils::SpillFile>(
+          new Utils::SpillFile());
+    }
+
+    qint64 position = phase_log->spill->Append(chunk);
+    if(position < 0) {
+      qWarning() << "Unable to log ciphertext from" << idx <<
+        "accusations against it will fail";
+      // Later chunks must not restart the log, or a truncated ciphertext
+      // would hash correctly.  The chunks already spilled are kept, they
+      // are needed to xor the ciphertext back out if it is dropped.
+      phase_log->unloggable.insert(idx);
+      phase_log->message_hashers.remove(idx);
+      return false;
+    }
+    phase_log->message_chunks[idx].append(
+        QPair<qint64, int>(position, chunk.size()));
+
+    QSharedPointer<Hash> &hashalgo = phase_log->message_hashers[idx];
+    if(!hashalgo) {
+      Library *lib = CryptoFactory::GetInstance().GetLibrary();
+      hashalgo = QSharedPointer<Hash>(lib->GetHashAlgorithm());
+    }
+    hashalgo->Update(chunk);
+
+    if(complete) {
+      phase_log->message_hashes[idx] = hashalgo->ComputeHash();
+      phase_log->message_hashers.remove(idx);
+    }
+    return true;
+  }
+
+  bool CSBulkRound::GetLoggedMessage(const QSharedPointer<PhaseLog> &phase_log,
+      int idx, QByteArray &message)
   {
+    if(phase_log->messages.contains(idx)) {
+      message = phase_log->messages[idx];
+      return true;
+    } else if(phase_log->unloggable.contains(idx) ||
+        !phase_log->message_hashes.contains(idx))
+    {
+      return false;
+    }
+
+    message.clear();
+    typedef QPair<qint64, int> Chunk;
+    foreach(const Chunk &chunk, phase_log->message_chunks[idx]) {
+      QByteArray data = phase_log->spill->Read(chunk.first, chunk.second);
+      if(data.size() != chunk.second) {
+        return false;
+      }
+      message.append(data);
+    }
+
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
     QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
+    if(hashalgo->ComputeHash(message) != phase_log->message_hashes[idx]) {
+      qWarning() << "Logged ciphertext from" << idx << "has been modified";
+      return false;
+    }
+    return true;
+  }
+
+  QPair<QBitArray, QBitArray> CSBulkRound::GetBitsAtIndex(
+      const QSharedPointer<PhaseLog> &phase_log, int msg_idx)
+  {
+    int byte_idx = msg_idx / 8;
+    int bit_idx = msg_idx % 8;
+    int count = GetGroup().Count();
+
+    QList<int> senders = phase_log->messages.keys() +
+      phase_log->message_hashes.keys();
+    QBitArray clients(count, false);
+    foreach(int idx, senders) {
+      if(phase_log->unloggable.contains(idx)) {
+        continue;
+      }
+
+      QByteArray message;
+      if(!GetLoggedMessage(phase_log, idx, message) ||
+          byte_idx >= message.size())
+      {
+        continue;
+      }
+      clients[idx] = (message[byte_idx] & bit_masks[bit_idx]) > 0;
+    }
 
-    QByteArray phase(4, 0);
-    Serialization::WriteInt(_state_machine.GetPhase(), phase, 0);
+    QBitArray mine(count, false);
+    if(!_compact_blame_logs) {
+      foreach(int idx, phase_log->my_sub_ciphertexts.keys()) {
+        mine[idx] = (phase_log->my_sub_ciphertexts[idx][byte_idx] &
+            bit_masks[bit_idx]) > 0;
+      }
+      return QPair<QBitArray, QBitArray>(clients, mine);
+    }
 
+    // Pads are regenerated from the shared secrets
+    foreach(int idx, phase_log->pad_clients) {
+      QScopedPointer<Random> rng(CreatePadRng(_state->base_seeds[idx],
+            phase_log->phase));
+      QByteArray pad(byte_idx + 1, 0);
+      rng->GenerateBlock(pad);
+      mine[idx] = (pad[byte_idx] & bit_masks[bit_idx]) > 0;
+    }
+    return QPair<QBitArray, QBitArray>(clients, mine);
+  }
+
+  Utils::Random *CSBulkRound::CreatePadRng(const QByteArray &base_seed,
+      int phase) const
+  {
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
+
+    QByteArray bphase(4, 0);
+    Serialization::WriteInt(phase, bphase, 0);
+
+    hashalgo->Update(base_seed);
+    hashalgo->Update(bphase);
+    hashalgo->Update(GetRoundId().GetByteArray());
+    QByteArray seed = hashalgo->ComputeHash();
+    return lib->GetRandomNumberGenerator(seed, 0, _pad_rng_type);
+  }
+
+  void CSBulkRound::SetupRngs()
+  {
     _state->anonymous_rngs.clear();
 
     QList<QByteArray> seeds = _state->base_seeds;
     if(IsServer()) {
       seeds = QList<QByteArray>();
       _server_state->rng_to_gidx.clear();
+      _server_state->current_phase_log->pad_clients.clear();
       for(int idx = 0; idx < _server_state->handled_clients.size(); idx++) {
         if(_server_state->handled_clients.at(idx)) {
           _server_state->rng_to_gidx[seeds.size()] = idx;
           seeds.append(_state->base_seeds[idx]);
+          if(!_state->base_seeds[idx].isEmpty()) {
+            _server_state->current_phase_log->pad_clients.append(idx);
+          }
         }
       }
 
@@ -909,11 +1391,8 @@ namespace Anonymity {
       if(base_seed.isEmpty()) {
         continue;
       }
-      hashalgo->Update(base_seed);
-      hashalgo->Update(phase);
-      hashalgo->Update(GetRoundId().GetByteArray());
-      QByteArray seed = hashalgo->ComputeHash();
-      QSharedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
+      QSharedPointer<Random> rng(CreatePadRng(base_seed,
+            _state_machine.GetPhase()));
       _state->anonymous_rngs.append(rng);
     }
   }
@@ -922,29 +1401,370 @@ namespace Anonymity {
   {
     SetupRngs();
 
-    QByteArray payload;
-    QDataStream stream(&payload, QIODevice::WriteOnly);
-    stream << CLIENT_CIPHERTEXT << GetRoundId() << _state_machine.GetPhase()
-      << GenerateCiphertext();
+    foreach(const QByteArray &payload,
+        BuildCiphertextChunks(CLIENT_CIPHERTEXT, GenerateCiphertext()))
+    {
+      VerifiableSend(_state->my_server, payload);
+    }
+  }
 
-    VerifiableSend(_state->my_server, payload);
+  QList<QByteArray> CSBulkRound::BuildCiphertextChunks(MessageType mtype,
+      const QByteArray &ciphertext)
+  {
+    QList<QByteArray> chunks;
+    int offset = 0;
+    do {
+      int length = qMin(CIPHERTEXT_CHUNK_SIZE, ciphertext.size() - offset);
+      QByteArray payload;
+      QDataStream stream(&payload, QIODevice::WriteOnly);
+      stream << mtype << GetRoundId() << _state_machine.GetPhase() <<
+        offset << QByteArray::fromRawData(ciphertext.constData() + offset, length);
+      chunks.append(payload);
+      offset += length;
+    } while(offset < ciphertext.size());
+    return chunks;
   }
 
-  QByteArray CSBulkRound::GenerateCiphertext()
+  bool CSBulkRound::AccumulateChunk(char *dst, int length,
+      QHash<int, int> &offsets, int idx, int offset, const QByteArray &chunk)
   {
-    QByteArray xor_msg(_state->msg_length, 0);
-    QByteArray tmsg(_state->msg_length, 0);
-    
-    int idx = 0;
-    foreach(const QSharedPointer<Random> &rng, _state->anonymous_rngs) {
-      rng->GenerateBlock(tmsg);
-      if(IsServer()) {
-        int gidx = _server_state->rng_to_gidx[idx++];
-        _server_state->current_phase_log->my_sub_ciphertexts[gidx] = tmsg;
+    if(offset != offsets.value(idx, 0)) {
+      throw QRunTimeError("Out of order chunk, got offset " +
+          QString::number(offset) + " expected " +
+          QString::number(offsets.value(idx, 0)));
+    } else if(chunk.size() > length - offset ||
+        (chunk.isEmpty() && length > 0))
+    {
+      throw QRunTimeError("Incorrect chunk length, got " +
+          QString::number(chunk.size()) + " at offset " +
+          QString::number(offset) + " expected " +
+          QString::number(length));
+    }
+
+    Utils::XorEngine::Xor(dst + offset, dst + offset, chunk.constData(),
+        chunk.size());
+
+    offset += chunk.size();
+    if(offset < length) {
+      offsets[idx] = offset;
+      return false;
+    }
+
+    offsets.remove(idx);
+    return true;
+  }
+
+  QByteArray CSBulkRound::CompressCleartext(const QByteArray &cleartext)
+  {
+    const char *data = cleartext.constData();
+    const int size = cleartext.size();
+
+    QByteArray compressed;
+    int pos = 0;
+    while(pos < size) {
+      int start = pos;
+      while(start < size && !data[start]) {
+        start++;
+      }
+      if(start == size) {
+        break;
+      }
+
+      int end = start;
+      int zeros = 0;
+      for(int idx = start; idx < size; idx++) {
+        if(data[idx]) {
+          zeros = 0;
+          end = idx + 1;
+        } else if(++zeros == SPARSE_MIN_ZERO_RUN) {
+          break;
+        }
+      }
+
+      int header = compressed.size();
+      compressed.resize(header + 8);
+      Serialization::WriteInt(start - pos, compressed, header);
+      Serialization::WriteInt(end - start, compressed, header + 4);
+      compressed.append(data + start, end - start);
+      pos = end;
+    }
+    return compressed;
+  }
+
+  bool CSBulkRound::ExpandCleartext(const QByteArray &compressed, int length,
+      QByteArray &cleartext)
+  {
+    cleartext = QByteArray(length, 0);
+    int in = 0;
+    int out = 0;
+    while(in < compressed.size()) {
+      if(compressed.size() - in < 8) {
+        return false;
+      }
+
+      int skip = Serialization::ReadInt(compressed, in);
+      int count = Serialization::ReadInt(compressed, in + 4);
+      in += 8;
+      if(skip < 0 || count < 0 || skip > length - out ||
+          count > length - out - skip || count > compressed.size() - in)
+      {
+        return false;
+      }
+
+      out += skip;
+      memcpy(cleartext.data() + out, compressed.constData() + in, count);
+      out += count;
+      in += count;
+    }
+    return true;
+  }
+
+  QPair<int, int> CSBulkRound::GetServerSegment(int sidx) const
+  {
+    if(!_reduce_scatter) {
+      return QPair<int, int>(0, _state->msg_length);
+    }
+    return GetServerSegment(sidx, _state->msg_length);
+  }
+
+  QPair<int, int> CSBulkRound::GetServerSegment(int sidx, int length) const
+  {
+    int servers = GetGroup().GetSubgroup().Count();
+    int base = length / servers;
+    int extra = length % servers;
+    return QPair<int, int>(sidx * base + qMin(sidx, extra),
+        base + (sidx < extra ? 1 : 0));
+  }
+
+  QByteArray CSBulkRound::GeneratePads()
+  {
+    int phase = _state_machine.GetPhase();
+    QByteArray xor_msg;
+    if(_pad_pipeline.contains(phase)) {
+      xor_msg = ApplyPrecomputedPads(_pad_pipeline.take(phase).result());
+    } else {
+      xor_msg = ExpandCurrentPads();
+    }
+
+    SchedulePadPrecompute();
+    return xor_msg;
+  }
+
+  QByteArray CSBulkRound::ExpandCurrentPads()
+  {
+    bool log_pads = LogPads();
+    int rng_count = _state->anonymous_rngs.count();
+
+    int workers = 1;
+    if(CryptoFactory::GetInstance().GetThreadingType() ==
+        CryptoFactory::MultiThreaded)
+    {
+      workers = qMax(1, qMin(QThread::idealThreadCount(), rng_count));
+    }
+
+    QList<PadJob> jobs;
+    for(int idx = 0; idx < workers; idx++) {
+      PadJob job;
+      job.length = _state->msg_length;
+      job.log_pads = log_pads;
+      jobs.append(job);
+    }
+
+    for(int idx = 0; idx < rng_count; idx++) {
+      PadJob &job = jobs[idx % workers];
+      job.rngs.append(_state->anonymous_rngs[idx]);
+      job.gidxs.append(log_pads ? _server_state->rng_to_gidx[idx] : -1);
+    }
+
+    QList<PadResult> results;
+    if(workers == 1) {
+      results.append(ExpandPads(jobs[0]));
+    } else {
+      results = QtConcurrent::blockingMapped(jobs, ExpandPads);
+    }
+
+    QByteArray xor_msg = results[0].partial;
+    QList<QByteArray> partials;
+    for(int idx = 0; idx < results.count(); idx++) {
+      const PadResult &result = results[idx];
+      if(idx > 0) {
+        partials.append(result.partial);
+      }
+
+      if(!log_pads) {
+        continue;
+      }
+
+      QHash<int, QByteArray>::const_iterator it = result.pads.constBegin();
+      for(; it != result.pads.constEnd(); it++) {
+        _server_state->current_phase_log->my_sub_ciphertexts[it.key()] =
+          it.value();
+      }
+    }
+    Xor(xor_msg, partials);
+    return xor_msg;
+  }
+
+  void CSBulkRound::SchedulePadPrecompute()
+  {
+    // Without worker threads the expansion would only compete with the
+    // protocol for the same core
+    if(CryptoFactory::GetInstance().GetThreadingType() !=
+        CryptoFactory::MultiThreaded)
+    {
+      _pad_pipeline.clear();
+      return;
+    }
+
+    int phase = _state_machine.GetPhase();
+    foreach(int pphase, _pad_pipeline.keys()) {
+      if(pphase <= phase) {
+        _pad_pipeline.remove(pphase);
+      }
+    }
+
+    // Servers expect the clients of this phase to return, the pads of any
+    // other client would only be removed again by ApplyPrecomputedPads
+    QList<int> members;
+    if(IsServer()) {
+      members = _server_state->rng_to_gidx.values();
+    } else {
+      for(int idx = 0; idx < _state->base_seeds.count(); idx++) {
+        members.append(idx);
+      }
+    }
+
+    bool keep_pads = LogPads();
+    for(int nphase = phase + 1; nphase <= phase + _pad_pipeline_depth;
+        nphase++)
+    {
+      if(_pad_pipeline.contains(nphase)) {
+        continue;
+      }
+
+      QHash<int, QSharedPointer<Random> > rngs;
+      foreach(int idx, members) {
+        if(_state->base_seeds[idx].isEmpty()) {
+          continue;
+        }
+        rngs[idx] = QSharedPointer<Random>(
+            CreatePadRng(_state->base_seeds[idx], nphase));
+      }
+
+      _pad_pipeline[nphase] = QtConcurrent::run(&CSBulkRound::ExpandFuturePads,
+          rngs, nphase, _state->msg_length, keep_pads);
+    }
+  }
+
+  CSBulkRound::PrecomputedPads CSBulkRound::ExpandFuturePads(
+      const QHash<int, QSharedPointer<Random> > &rngs, int phase, int length,
+      bool keep_pads)
+  {
+    PrecomputedPads precomputed;
+    precomputed.phase = phase;
+    precomputed.length = length;
+    precomputed.keep_pads = keep_pads;
+    precomputed.rngs = rngs;
+
+    if(!keep_pads) {
+      precomputed.combined = QByteArray(length, 0);
+    }
+
+    QHash<int, QSharedPointer<Random> >::const_iterator it = rngs.constBegin();
+    for(; it != rngs.constEnd(); it++) {
+      if(!keep_pads) {
+        it.value()->XorBlock(precomputed.combined);
+        continue;
+      }
+
+      QByteArray pad(length, 0);
+      it.value()->GenerateBlock(pad);
+      precomputed.pads[it.key()] = pad;
+    }
+    return precomputed;
+  }
+
+  QByteArray CSBulkRound::ApplyPrecomputedPads(
+      const PrecomputedPads &precomputed)
+  {
+    bool log_pads = LogPads();
+    if(log_pads && !precomputed.keep_pads) {
+      return ExpandCurrentPads();
+    }
+
+    int length = _state->msg_length;
+    int prefix = qMin(length, precomputed.length);
+
+    QList<int> used;
+    QList<int> late;
+    if(IsServer()) {
+      foreach(int gidx, _server_state->rng_to_gidx.values()) {
+        if(precomputed.rngs.contains(gidx)) {
+          used.append(gidx);
+        } else if(!_state->base_seeds[gidx].isEmpty()) {
+          late.append(gidx);
+        }
+      }
+    } else {
+      used = precomputed.rngs.keys();
+    }
+
+    QByteArray xor_msg(length, 0);
+    if(!precomputed.keep_pads) {
+      Utils::XorEngine::Xor(xor_msg.data(), xor_msg.constData(),
+          precomputed.combined.constData(), prefix);
+
+      // Remove the pads of members that did not participate in this phase
+      QSet<int> absent = precomputed.rngs.keys().toSet() - used.toSet();
+      foreach(int idx, absent) {
+        QSharedPointer<Random> rng(CreatePadRng(_state->base_seeds[idx],
+              precomputed.phase));
+        QByteArray pad(prefix, 0);
+        rng->GenerateBlock(pad);
+        Xor(xor_msg, xor_msg, pad);
+      }
+    }
+
+    // The rngs are positioned after the prefix, extend if the phase grew
+    foreach(int idx, used) {
+      QByteArray tail;
+      if(prefix < length) {
+        tail = QByteArray(length - prefix, 0);
+        precomputed.rngs[idx]->GenerateBlock(tail);
+      }
+
+      if(!precomputed.keep_pads) {
+        Utils::XorEngine::Xor(xor_msg.data() + prefix,
+            xor_msg.constData() + prefix, tail.constData(), tail.size());
+        continue;
+      }
+
+      QByteArray pad = precomputed.pads[idx].left(prefix) + tail;
+      if(log_pads) {
+        _server_state->current_phase_log->my_sub_ciphertexts[idx] = pad;
       }
-      Xor(xor_msg, xor_msg, tmsg);
+      Xor(xor_msg, xor_msg, pad);
     }
 
+    // Clients that were absent when the phase was scheduled
+    foreach(int idx, late) {
+      QSharedPointer<Random> rng(CreatePadRng(_state->base_seeds[idx],
+            precomputed.phase));
+      QByteArray pad(length, 0);
+      rng->GenerateBlock(pad);
+      if(log_pads) {
+        _server_state->current_phase_log->my_sub_ciphertexts[idx] = pad;
+      }
+      Xor(xor_msg, xor_msg, pad);
+    }
+
+    return xor_msg;
+  }
+
+  QByteArray CSBulkRound::GenerateCiphertext()
+  {
+    QByteArray xor_msg = GeneratePads();
+
     if(_state->slot_open) {
       int offset = _state->base_msg_length;
       foreach(int owner, _state->next_messages.keys()) {
@@ -1074,11 +1894,89 @@ namespace Anonymity {
 
   void CSBulkRound::ConcludeClientCiphertextSubmission(const int &)
   {
-    qDebug() << "Client window has closed, unfortunately some client may not"
-      << "have transmitted in time.";
+    if(_server_state->client_offsets.isEmpty()) {
+      qDebug() << "Client window has closed, unfortunately some client may not"
+        << "have transmitted in time.";
+      _state_machine.StateComplete();
+      return;
+    }
+
+    // Give ciphertexts already in progress one more window to finish
+    if(!_server_state->submission_closed) {
+      qDebug() << "Client window has closed, waiting on" <<
+        _server_state->client_offsets.count() << "incomplete ciphertexts";
+      _server_state->submission_closed = true;
+      Utils::TimerCallback *cb = new Utils::TimerMethod<CSBulkRound, int>(
+          this, &CSBulkRound::ConcludeClientCiphertextSubmission, 0);
+      _server_state->client_ciphertext_period =
+        Utils::Timer::GetInstance().QueueCallback(cb, CLIENT_SUBMISSION_WINDOW);
+      return;
+    }
+
+    qDebug() << "Dropping" << _server_state->client_offsets.count() <<
+      "incomplete client ciphertexts";
+    foreach(int idx, _server_state->client_offsets.keys()) {
+      if(!DropClientCiphertext(idx)) {
+        Stop("Unable to remove an incomplete client ciphertext");
+        return;
+      }
+    }
     _state_machine.StateComplete();
   }
 
+  bool CSBulkRound::DropClientCiphertext(int idx)
+  {
+    QSharedPointer<PhaseLog> phase_log = _server_state->current_phase_log;
+
+    // The received prefix is the chunks in the blame log followed by those
+    // retained after logging stopped or when there is no log
+    char *accumulator = _server_state->client_accumulator.data();
+    int offset = 0;
+    if(_accusations_enabled && phase_log && _compact_blame_logs) {
+      typedef QPair<qint64, int> Chunk;
+      foreach(const Chunk &chunk, phase_log->message_chunks.value(idx)) {
+        QByteArray data = phase_log->spill->Read(chunk.first, chunk.second);
+        if(data.size() != chunk.second) {
+          qCritical() << "Unable to read the logged ciphertext from" << idx;
+          return false;
+        }
+        Utils::XorEngine::Xor(accumulator + offset, accumulator + offset,
+            data.constData(), data.size());
+        offset += data.size();
+      }
+    } else if(_accusations_enabled && phase_log) {
+      QByteArray data = phase_log->messages.value(idx);
+      Utils::XorEngine::Xor(accumulator, accumulator, data.constData(),
+          data.size());
+      offset += data.size();
+    }
+
+    foreach(const QByteArray &chunk, _server_state->client_partials.value(idx)) {
+      Utils::XorEngine::Xor(accumulator + offset, accumulator + offset,
+          chunk.constData(), chunk.size());
+      offset += chunk.size();
+    }
+
+    if(offset != _server_state->client_offsets.value(idx)) {
+      qCritical() << "Received" << _server_state->client_offsets.value(idx) <<
+        "bytes from" << idx << "but could only remove" << offset;
+      return false;
+    }
+
+    _server_state->client_partials.remove(idx);
+    _server_state->client_offsets.remove(idx);
+    _server_state->handled_clients[idx] = false;
+
+    if(phase_log) {
+      phase_log->messages.remove(idx);
+      phase_log->message_chunks.remove(idx);
+      phase_log->message_hashers.remove(idx);
+      phase_log->message_hashes.remove(idx);
+      phase_log->unloggable.remove(idx);
+    }
+    return true;
+  }
+
   void CSBulkRound::SubmitClientList()
   {
     QByteArray payload;
@@ -1101,60 +1999,205 @@ namespace Anonymity {
     QByteArray payload;
     QDataStream stream(&payload, QIODevice::WriteOnly);
     stream << SERVER_COMMIT << GetRoundId() <<
-      _state_machine.GetPhase() << _server_state->my_commit;
+      _state_machine.GetPhase() << _server_state->my_commits;
 
-    VerifiableBroadcastToServers(payload);
+    VerifiableBroadcastToServers(payload, true);
   }
 
   void CSBulkRound::GenerateServerCiphertext()
   {
     QByteArray ciphertext = GenerateCiphertext();
-    foreach(const QByteArray &text, _server_state->client_ciphertexts) {
-      Xor(ciphertext, ciphertext, text);
+    if(!_server_state->client_accumulator.isEmpty()) {
+      Xor(ciphertext, ciphertext, _server_state->client_accumulator);
     }
     _server_state->my_ciphertext = ciphertext;
 
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
     QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-    _server_state->my_commit = hashalgo->ComputeHash(ciphertext);
+    _server_state->my_commits.clear();
+    int segments = _reduce_scatter ? GetGroup().GetSubgroup().Count() : 1;
+    for(int sidx = 0; sidx < segments; sidx++) {
+      QPair<int, int> segment = GetServerSegment(sidx);
+      _server_state->my_commits.append(hashalgo->ComputeHash(
+            ciphertext.mid(segment.first, segment.second)));
+    }
+
+    if(_reduce_scatter) {
+      _server_state->current_phase_log->my_ciphertext = ciphertext;
+    }
   }
 
   void CSBulkRound::SubmitServerCiphertext()
   {
-    QByteArray payload;
-    QDataStream stream(&payload, QIODevice::WriteOnly);
-    stream << SERVER_CIPHERTEXT << GetRoundId() <<
-      _state_machine.GetPhase() << _server_state->my_ciphertext;
+    const QByteArray &ciphertext = _server_state->my_ciphertext;
+    if(!_reduce_scatter) {
+      foreach(const QByteArray &payload,
+          BuildCiphertextChunks(SERVER_CIPHERTEXT, ciphertext))
+      {
+        VerifiableBroadcastToServers(payload);
+      }
+      return;
+    }
 
-    VerifiableBroadcastToServers(payload);
+    for(int sidx = 0; sidx < GetGroup().GetSubgroup().Count(); sidx++) {
+      QPair<int, int> segment = GetServerSegment(sidx);
+      QByteArray data = QByteArray::fromRawData(
+          ciphertext.constData() + segment.first, segment.second);
+      Id to = GetGroup().GetSubgroup().GetId(sidx);
+      foreach(const QByteArray &payload,
+          BuildCiphertextChunks(SERVER_CIPHERTEXT, data))
+      {
+        VerifiableSend(to, payload);
+      }
+    }
   }
 
-  void CSBulkRound::SubmitValidation()
+  void CSBulkRound::SubmitAggregate()
   {
-    QByteArray cleartext(_state->msg_length, 0);
+    // Without reduce-scatter every server already holds the whole cleartext
+    if(!_reduce_scatter) {
+      _state->cleartext = _server_state->server_accumulator;
+      if(_state->cleartext.isEmpty()) {
+        _state->cleartext.fill(0, _state->msg_length);
+      }
+      _state_machine.StateComplete();
+      return;
+    }
 
-    foreach(const QByteArray &ciphertext, _server_state->server_ciphertexts) {
-      Xor(cleartext, cleartext, ciphertext);
+    _state->cleartext = QByteArray(_state->msg_length, 0);
+
+    int my_sidx = GetGroup().GetSubgroup().GetIndex(GetLocalId());
+    QByteArray aggregate = _server_state->server_accumulator;
+    if(aggregate.isEmpty()) {
+      aggregate.fill(0, GetServerSegment(my_sidx).second);
     }
 
-    _state->cleartext = cleartext;
-    QByteArray signature = GetPrivateIdentity().GetSigningKey()->
-      Sign(_state->cleartext);
+    // Commit to the aggregate in a form any server can later present
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
+    QByteArray commit = hashalgo->ComputeHash(aggregate);
+    QByteArray signature = GetPrivateIdentity().GetSigningKey()->Sign(
+        AggregateStatement(_state_machine.GetPhase(), my_sidx, commit,
+          _server_state->current_phase_log->server_commits));
+
+    QList<QByteArray> payloads =
+      BuildCiphertextChunks(SERVER_AGGREGATE, aggregate);
+    QDataStream stream(&payloads.first(), QIODevice::Append);
+    stream << commit << signature;
+
+    foreach(const QByteArray &payload, payloads) {
+      VerifiableBroadcastToServers(payload);
+    }
+  }
+
+  void CSBulkRound::SubmitValidation()
+  {
+    // A server that found a mismatching aggregate asks for an audit
+    // instead of signing the cleartext
+    bool audit = _server_state->audit_requested && !_server_state->audited;
+    QByteArray signature;
+    if(!audit) {
+      signature = GetPrivateIdentity().GetSigningKey()->Sign(_state->cleartext);
+    }
 
     QByteArray payload;
     QDataStream stream(&payload, QIODevice::WriteOnly);
     stream << SERVER_VALIDATION << GetRoundId() <<
-      _state_machine.GetPhase() << signature;
+      _state_machine.GetPhase() << audit << signature;
 
     VerifiableBroadcastToServers(payload);
   }
 
+  void CSBulkRound::SubmitAudit()
+  {
+    QSharedPointer<PhaseLog> phase_log =
+      _server_state->phase_logs[_server_state->audit_phase];
+
+    _server_state->audit_accumulator.clear();
+    _server_state->audit_segments.clear();
+    _server_state->audit_commits.clear();
+    _server_state->server_offsets.clear();
+    _server_state->server_hashes.clear();
+
+    // Fall back to broadcasting the whole ciphertext, relaying the signed
+    // aggregate commits so that every server judges the same set
+    QList<QByteArray> payloads =
+      BuildCiphertextChunks(SERVER_AUDIT, phase_log->my_ciphertext);
+    QDataStream stream(&payloads.first(), QIODevice::Append);
+    stream << phase_log->aggregate_commits;
+
+    foreach(const QByteArray &payload, payloads) {
+      VerifiableBroadcastToServers(payload);
+    }
+  }
+
+  void CSBulkRound::ConcludeAudit()
+  {
+    int length = _server_state->audit_accumulator.size();
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
+
+    QVector<QByteArray> aggregates;
+    for(int sidx = 0; sidx < GetGroup().GetSubgroup().Count(); sidx++) {
+      QPair<int, int> segment = GetServerSegment(sidx, length);
+      aggregates.append(hashalgo->ComputeHash(
+            _server_state->audit_accumulator.mid(segment.first,
+              segment.second)));
+    }
+
+    int bad_sidx = -1;
+    typedef QPair<int, QByteArray> Commit;
+    foreach(const Commit &commit, _server_state->audit_commits) {
+      if(commit.second != aggregates[commit.first] &&
+          (bad_sidx == -1 || commit.first < bad_sidx))
+      {
+        bad_sidx = commit.first;
+      }
+    }
+
+    if(bad_sidx != -1) {
+      qDebug() << "Server" << bad_sidx << "signed a forged aggregate";
+      _server_state->bad_dude = GetGroup().GetSubgroup().GetId(bad_sidx);
+      if(!_server_state->accuse_found) {
+        _server_state->current_blame =
+          Utils::Triple<int, int, int>(-1, -1, _server_state->audit_phase);
+      }
+      _state_machine.StateComplete(SERVER_EXCHANGE_VERDICT_SIGNATURE);
+    } else if(_server_state->accuse_found) {
+      qDebug() << "Audit found every aggregate matched its commit";
+      Stop("False accusation");
+    } else {
+      // No owner signed a forgery, so the cleartext is taken from the
+      // whole ciphertexts and signed again
+      _state->cleartext = _server_state->audit_accumulator;
+      _server_state->audited = true;
+      _state_machine.StateComplete(SERVER_WAIT_FOR_SERVER_VALIDATION);
+    }
+  }
+
+  QByteArray CSBulkRound::AggregateStatement(int phase, int sidx,
+      const QByteArray &commit,
+      const QHash<int, QList<QByteArray> > &server_commits) const
+  {
+    QByteArray statement;
+    QDataStream stream(&statement, QIODevice::WriteOnly);
+    stream << GetRoundId() << phase << sidx << commit;
+    for(int idx = 0; idx < GetGroup().GetSubgroup().Count(); idx++) {
+      stream << server_commits.value(idx).value(sidx);
+    }
+    return statement;
+  }
+
   void CSBulkRound::PushCleartext()
   {
+    QByteArray compressed = CompressCleartext(_server_state->cleartext);
+    bool sparse = compressed.size() < _server_state->cleartext.size();
+
     QByteArray payload;
     QDataStream stream(&payload, QIODevice::WriteOnly);
     stream << SERVER_CLEARTEXT << GetRoundId() << _state_machine.GetPhase()
-      << _server_state->signatures << _server_state->cleartext;
+      << _server_state->signatures << sparse
+      << (sparse ? compressed : _server_state->cleartext);
 
     VerifiableBroadcastToClients(payload);
     ProcessCleartext();
@@ -1233,9 +2276,9 @@ namespace Anonymity {
 
   void CSBulkRound::TransmitBlameBits()
   {
-    QPair<QBitArray, QBitArray> bits =
-      _server_state->phase_logs[_server_state->current_blame.third]->
-      GetBitsAtIndex(_server_state->current_blame.second);
+    QPair<QBitArray, QBitArray> bits = GetBitsAtIndex(
+        _server_state->phase_logs[_server_state->current_blame.third],
+        _server_state->current_blame.second);
 
     QByteArray payload;
     QDataStream stream(&payload, QIODevice::WriteOnly);
@@ -1249,7 +2292,13 @@ namespace Anonymity {
   {
     QPair<int, QBitArray> pair = FindMismatch();
     int gidx = pair.first;
-    if(gidx == -1) {
+    if(gidx == -1 && _reduce_scatter) {
+      // Every client and pad bit is accounted for, so an owner must have
+      // forged its aggregate
+      _server_state->audit_phase = _server_state->current_blame.third;
+      _state_machine.StateComplete(SERVER_WAIT_FOR_SERVER_AUDIT);
+      return;
+    } else if(gidx == -1) {
       qDebug() << "Did not find a mismatch";
       return;
     }
@@ -1535,6 +2584,9 @@ namespace Anonymity {
     }
 
     if(actual == expected) {
+      if(_reduce_scatter) {
+        return QPair<int, QBitArray>(-1, QBitArray());
+      }
       throw QRunTimeError("False accusation");
     }
     QBitArray mismatch = (actual ^ expected);
@@ -1567,23 +2619,13 @@ namespace Anonymity {
   QPair<int, QByteArray> CSBulkRound::GetRebuttal(int phase, int accuse_idx,
       const QBitArray &server_bits)
   {
-    Library *lib = CryptoFactory::GetInstance().GetLibrary();
-    QSharedPointer<Hash> hashalgo(lib->GetHashAlgorithm());
-
-    QByteArray bphase(4, 0);
-    Serialization::WriteInt(phase, bphase, 0);
-
     QVector<QSharedPointer<Random> > rngs;
     int msg_size = accuse_idx / 8 + (accuse_idx % 8 > 0 ? 1 : 0);
     int bidx = -1;
     QByteArray tmp(msg_size, 0);
     for(int idx = 0; idx < _state->base_seeds.size(); idx++) {
       const QByteArray &base_seed = _state->base_seeds[idx];
-      hashalgo->Update(base_seed);
-      hashalgo->Update(bphase);
-      hashalgo->Update(GetRoundId().GetByteArray());
-      QByteArray seed = hashalgo->ComputeHash();
-      QSharedPointer<Random> rng(lib->GetRandomNumberGenerator(seed));
+      QSharedPointer<Random> rng(CreatePadRng(base_seed, phase));
       rng->GenerateBlock(tmp);
       if(((tmp[accuse_idx / 8] & bit_masks[accuse_idx % 8]) != 0) != server_bits[idx]) {
         bidx = idx;
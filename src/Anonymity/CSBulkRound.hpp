@@ -1,8 +1,10 @@
 #ifndef DISSENT_ANONYMITY_CS_BULK_ROUND_H_GUARD
 #define DISSENT_ANONYMITY_CS_BULK_ROUND_H_GUARD
 
+#include <QFuture>
 #include <QMetaEnum>
 
+#include "Crypto/Hash.hpp"
 #include "Utils/TimerEvent.hpp"
 #include "Utils/Triple.hpp"
 #include "RoundStateMachine.hpp"
@@ -11,6 +13,7 @@
 namespace Dissent {
 namespace Utils {
   class Random;
+  class SpillFile;
 }
 
 namespace Anonymity {
@@ -37,6 +40,11 @@ namespace Anonymity {
    * and then distribute the final cleartext to all clients. RNGs are reset
    * each round to map to the shared secret between the client and server,
    * the RoundID (or nonce), and then the current phase.
+   *
+   * By default every server broadcasts its whole ciphertext to all servers
+   * and each recomputes the cleartext, so a single honest server suffices
+   * to catch a bad combination.  See SetReduceScatter for a cheaper, less
+   * trusting alternative.
    */
   class CSBulkRound : public BaseBulkRound
   {
@@ -52,12 +60,14 @@ namespace Anonymity {
         SERVER_CLIENT_LIST,
         SERVER_COMMIT,
         SERVER_CIPHERTEXT,
+        SERVER_AGGREGATE,
         SERVER_VALIDATION,
         SERVER_CLEARTEXT,
         SERVER_BLAME_BITS,
         SERVER_REBUTTAL_OR_VERDICT,
         CLIENT_REBUTTAL,
         SERVER_VERDICT_SIGNATURE,
+        SERVER_AUDIT,
       };
 
       enum States {
@@ -71,7 +81,9 @@ namespace Anonymity {
         SERVER_WAIT_FOR_CLIENT_LISTS,
         SERVER_WAIT_FOR_SERVER_COMMITS,
         SERVER_WAIT_FOR_SERVER_CIPHERTEXT,
+        SERVER_WAIT_FOR_SERVER_AGGREGATE,
         SERVER_WAIT_FOR_SERVER_VALIDATION,
+        SERVER_WAIT_FOR_SERVER_AUDIT,
         SERVER_PUSH_CLEARTEXT,
         STARTING_BLAME_SHUFFLE,
         WAITING_FOR_BLAME_SHUFFLE,
@@ -97,11 +109,14 @@ namespace Anonymity {
        * @param get_data requests data to share during this session
        * @param create_shuffle optional parameter specifying a shuffle round
        * to create, currently used for testing
+       * @param pad_rng the rng construction used to expand the DC-net pads,
+       * all members of the round must agree on it
        */
       explicit CSBulkRound(const Group &group, const PrivateIdentity &ident,
           const Id &round_id, QSharedPointer<Network> network,
           GetDataCallback &get_data,
-          CreateRound create_shuffle = &TCreateRound<ShuffleRound>);
+          CreateRound create_shuffle = &TCreateRound<ShuffleRound>,
+          Crypto::Library::RngType pad_rng = Crypto::Library::CounterRng);
 
       /**
        * Destructor
@@ -183,6 +198,102 @@ namespace Anonymity {
 
       static const int MAX_GET = 4096;
 
+      /**
+       * Client and server ciphertexts are transmitted as a stream of
+       * individually authenticated chunks of at most this many bytes, which
+       * servers xor into their accumulators as they arrive.  The chunks of
+       * an unfinished client ciphertext are retained, in the blame log when
+       * one is kept, only so that it can be xored back out if the client
+       * stalls.
+       */
+      static const int CIPHERTEXT_CHUNK_SIZE = 65536;
+
+      /**
+       * Encodes a cleartext as runs of (zero bytes skipped, literal length,
+       * literal bytes), omitting trailing zeroes.  Servers push this form to
+       * clients whenever it is smaller, which is the common case when few
+       * slots are open.
+       * @param cleartext the cleartext
+       */
+      static QByteArray CompressCleartext(const QByteArray &cleartext);
+
+      /**
+       * Reverses CompressCleartext
+       * @param compressed the output of CompressCleartext
+       * @param length the length of the cleartext
+       * @param cleartext set to the cleartext
+       * @returns false if compressed is malformed or exceeds length
+       */
+      static bool ExpandCleartext(const QByteArray &compressed, int length,
+          QByteArray &cleartext);
+
+      /**
+       * Enables or disables the per phase logs a server retains for
+       * accusations.  When disabled, servers neither keep copies of client
+       * ciphertexts nor of the pads they generate and instead xor pads
+       * directly into their ciphertext, accusations will then fail.
+       * @param enabled true to retain blame logs
+       */
+      void SetAccusationsEnabled(bool enabled) { _accusations_enabled = enabled; }
+
+      /**
+       * Returns true if servers retain blame logs
+       */
+      bool AccusationsEnabled() const { return _accusations_enabled; }
+
+      /**
+       * Enables or disables compact blame logs.  When enabled, servers keep
+       * only a hash of each client ciphertext in memory and spill the
+       * ciphertext itself to disk, and regenerate their pads from the shared
+       * secrets rather than retaining them.  Only meaningful when
+       * accusations are enabled.
+       * @param compact true to use compact blame logs
+       */
+      void SetCompactBlameLogs(bool compact) { _compact_blame_logs = compact; }
+
+      /**
+       * Returns true if servers keep compact blame logs
+       */
+      bool CompactBlameLogs() const { return _compact_blame_logs; }
+
+      /**
+       * Sets how many phases ahead of the current phase pads are expanded in
+       * the background.  Each precomputed phase holds one message length of
+       * pad, or one per client on servers retaining blame logs.  Pads are
+       * only precomputed when the CryptoFactory is MultiThreaded.
+       * @param phases the pipeline depth, 0 disables precomputation
+       */
+      void SetPadPipelineDepth(int phases) { _pad_pipeline_depth = qMax(0, phases); }
+
+      /**
+       * Returns how many phases ahead pads are expanded
+       */
+      int GetPadPipelineDepth() const { return _pad_pipeline_depth; }
+
+      /**
+       * Combines server ciphertexts with a reduce-scatter followed by an
+       * all-gather rather than a broadcast.  The message is split into one
+       * segment per server, each server commits to every segment of its
+       * ciphertext and sends each segment only to its owner, which checks
+       * the segments against the commits, xors them, and shares the result.
+       * Each server then transmits about twice the message length per phase
+       * rather than the message length times the number of servers.  Only
+       * the owner sees the inputs to its segment, so each owner signs a
+       * commit to its aggregate bound to the segment commits every server
+       * holds.  Should an aggregate or cleartext fail to match, or an
+       * accusation find no faulty client or pad, servers fall back to
+       * broadcasting their whole ciphertexts for that phase and an owner
+       * whose signed commit disagrees is blamed.  All servers must agree on
+       * this setting, which must be set before the round starts.
+       * @param enabled true to use reduce-scatter
+       */
+      void SetReduceScatter(bool enabled) { _reduce_scatter = enabled; }
+
+      /**
+       * Returns true if servers combine ciphertexts by reduce-scatter
+       */
+      bool ReduceScatter() const { return _reduce_scatter; }
+
       virtual bool CSGroupCapable() const
       {
 #if DISSENT_TEST
@@ -194,6 +305,7 @@ namespace Anonymity {
       }
 
     protected:
+      typedef Crypto::Hash Hash;
       typedef Utils::Random Random;
 
       /**
@@ -217,10 +329,13 @@ namespace Anonymity {
       virtual void OnStop();
 
       /**
-       * Server sends a message to all servers
+       * Server sends a message to all servers, authenticated with per-link
+       * MACs unless the message must remain verifiable by third parties
        * @param data the message to send
+       * @param transferable sign the message instead
        */
-      void VerifiableBroadcastToServers(const QByteArray &data);
+      void VerifiableBroadcastToServers(const QByteArray &data,
+          bool transferable = false);
 
       /**
        * Server sends a message to all clients
@@ -273,26 +388,7 @@ namespace Anonymity {
        */
       class PhaseLog {
         public:
-          PhaseLog(int phase, int max) : phase(phase), _max(max) { }
-
-          QPair<QBitArray, QBitArray> GetBitsAtIndex(int msg_idx)
-          {
-            QBitArray clients(_max, false);
-            foreach(int idx, messages.keys()) {
-              int byte_idx = msg_idx / 8;
-              int bit_idx = msg_idx % 8;
-              clients[idx] = (messages[idx][byte_idx] & bit_masks[bit_idx]) > 0;
-            }
-
-            QBitArray mine(_max, false);
-            foreach(int idx, my_sub_ciphertexts.keys()) {
-              int byte_idx = msg_idx / 8;
-              int bit_idx = msg_idx % 8;
-              mine[idx] = (my_sub_ciphertexts[idx][byte_idx] & bit_masks[bit_idx]) > 0;
-            }
-
-            return QPair<QBitArray, QBitArray>(clients, mine);
-          }
+          explicit PhaseLog(int phase) : phase(phase) { }
 
           QBitArray clients;
           QVector<int> message_offsets;
@@ -302,9 +398,53 @@ namespace Anonymity {
           QHash<int, QByteArray> my_sub_ciphertexts;
           int phase;
 
-        private:
-          int _max;
+          /**
+           * Compact logs: the group indexes of the clients whose pads were
+           * included in this server's ciphertext
+           */
+          QList<int> pad_clients;
+
+          /**
+           * Compact logs: client ciphertexts spilled to disk, the position
+           * and length of each chunk, and the hash of each full ciphertext
+           */
+          QSharedPointer<Utils::SpillFile> spill;
+          QHash<int, QList<QPair<qint64, int> > > message_chunks;
+          QHash<int, QByteArray> message_hashes;
+          QHash<int, QSharedPointer<Hash> > message_hashers;
+
+          /**
+           * Reduce-scatter: this server's ciphertext, every server's segment
+           * commits, and the signed aggregate commit received from each
+           * owner, retained to audit the aggregates
+           */
+          QByteArray my_ciphertext;
+          QHash<int, QList<QByteArray> > server_commits;
+          QHash<int, QPair<QByteArray, QByteArray> > aggregate_commits;
+
+          /**
+           * Compact logs: clients with a chunk that could not be spilled,
+           * their ciphertexts are not logged for the rest of the phase
+           */
+          QSet<int> unloggable;
+      };
+
+      /**
+       * Pads expanded in the background for a future phase.  The message
+       * length of a phase is only known once the prior cleartext arrives, so
+       * the expansion uses the length of the phase during which it was
+       * scheduled and the rngs are retained to extend the pads if needed.
+       */
+      class PrecomputedPads {
+        public:
+          PrecomputedPads() : phase(-1), length(0), keep_pads(false) {}
 
+          int phase;
+          int length;
+          bool keep_pads;
+          QHash<int, QSharedPointer<Random> > rngs;
+          QByteArray combined;
+          QHash<int, QByteArray> pads;
       };
 
       /**
@@ -312,7 +452,15 @@ namespace Anonymity {
        */
       class ServerState : public State {
         public:
-          ServerState() : accuse_found(false) { }
+          ServerState() :
+            received_clients(0),
+            submission_closed(false),
+            audit_requested(false),
+            audited(false),
+            audit_phase(-1),
+            accuse_found(false)
+          {
+          }
           virtual ~ServerState() {}
 
           Utils::TimerEvent client_ciphertext_period;
@@ -321,17 +469,59 @@ namespace Anonymity {
 
           int phase;
 
-          QByteArray my_commit;
+          QList<QByteArray> my_commits;
           QByteArray my_ciphertext;
 
           QSet<Id> allowed_clients;
           QBitArray handled_clients;
-          QList<QByteArray> client_ciphertexts;
+
+          /**
+           * The xor of all client ciphertext chunks received this phase
+           */
+          QByteArray client_accumulator;
+
+          /**
+           * Chunks of ciphertexts still being received that are not held by
+           * the blame log, used to xor a dropped ciphertext back out
+           */
+          QHash<int, QList<QByteArray> > client_partials;
+
+          /**
+           * Bytes received from clients whose ciphertext is incomplete
+           */
+          QHash<int, int> client_offsets;
+          int received_clients;
+          bool submission_closed;
 
           QSet<Id> handled_servers;
           QHash<int, int> rng_to_gidx;
-          QHash<int, QByteArray> server_commits;
-          QHash<int, QByteArray> server_ciphertexts;
+          QHash<int, QList<QByteArray> > server_commits;
+
+          /**
+           * The xor of all received server ciphertext chunks, i.e., the
+           * cleartext, or only this server's segment of it under
+           * reduce-scatter, once every server has finished
+           */
+          QByteArray server_accumulator;
+          QHash<int, int> server_offsets;
+          QHash<int, QSharedPointer<Hash> > server_hashes;
+
+          /**
+           * Reduce-scatter: set when an aggregate or cleartext signature
+           * fails to match, or once the phase has been audited
+           */
+          bool audit_requested;
+          bool audited;
+
+          /**
+           * The phase being audited, the xor of every server's ciphertext for
+           * it, each server's progress through its segment commits, and the
+           * validly signed aggregate commits relayed by the servers
+           */
+          int audit_phase;
+          QByteArray audit_accumulator;
+          QHash<int, int> audit_segments;
+          QList<QPair<int, QByteArray> > audit_commits;
           QHash<int, QSharedPointer<PhaseLog> > phase_logs;
           QSharedPointer<PhaseLog> current_phase_log;
           bool accuse_found;
@@ -421,6 +611,13 @@ namespace Anonymity {
        */
       void HandleServerCiphertext(const Id &from, QDataStream &stream);
 
+      /**
+       * Server handles other server cleartext segment messages
+       * @param from sender of the message
+       * @param stream message
+       */
+      void HandleServerAggregate(const Id &from, QDataStream &stream);
+
       /**
        * Server handles other server validation messages
        * @param from sender of the message
@@ -428,6 +625,13 @@ namespace Anonymity {
        */
       void HandleServerValidation(const Id &from, QDataStream &stream);
 
+      /**
+       * Server handles other server whole ciphertexts sent for an audit
+       * @param from sender of the message
+       * @param stream message
+       */
+      void HandleServerAudit(const Id &from, QDataStream &stream);
+
       /**
        * Client handles server cleartext message
        * @param from sender of the message
@@ -464,7 +668,9 @@ namespace Anonymity {
       void SubmitClientList();
       void SubmitCommit();
       void SubmitServerCiphertext();
+      void SubmitAggregate();
       void SubmitValidation();
+      void SubmitAudit();
       void PushCleartext();
 
       void StartBlameShuffle();
@@ -475,6 +681,99 @@ namespace Anonymity {
       void PushVerdict();
 
       /* Below are the ciphertext generation helpers */
+
+      /**
+       * Returns the xor of the pads of all anonymous rngs for this phase,
+       * from the pad pipeline if this phase was precomputed
+       */
+      QByteArray GeneratePads();
+
+      /**
+       * Expands the pads of all anonymous rngs for this phase and returns
+       * their xor.  When multithreading is enabled, the rngs are partitioned
+       * across a worker pool and the partial results combined.
+       */
+      QByteArray ExpandCurrentPads();
+
+      /**
+       * Begins expanding the pads for the next phases in the background,
+       * bounded by the pad pipeline depth
+       */
+      void SchedulePadPrecompute();
+
+      /**
+       * Expands pads for a future phase, run off of the event loop
+       * @param rngs the rngs for the phase indexed by base seed
+       * @param phase the future phase
+       * @param length the expected message length
+       * @param keep_pads retain individual pads instead of only their xor
+       */
+      static PrecomputedPads ExpandFuturePads(
+          const QHash<int, QSharedPointer<Random> > &rngs, int phase,
+          int length, bool keep_pads);
+
+      /**
+       * Returns the xor of the pads for this phase from precomputed pads,
+       * removing absent members and extending to the actual message length
+       * @param precomputed the pads expanded for this phase
+       */
+      QByteArray ApplyPrecomputedPads(const PrecomputedPads &precomputed);
+
+      /**
+       * Splits a ciphertext into chunk messages of CIPHERTEXT_CHUNK_SIZE
+       * bytes, each carrying its offset.  Always returns at least one chunk.
+       * @param mtype CLIENT_CIPHERTEXT, SERVER_CIPHERTEXT, or SERVER_AGGREGATE
+       * @param ciphertext the ciphertext
+       */
+      QList<QByteArray> BuildCiphertextChunks(MessageType mtype,
+          const QByteArray &ciphertext);
+
+      /**
+       * Validates the next chunk of a ciphertext stream and xors it into the
+       * accumulator
+       * @param dst the start of the stream in the accumulator
+       * @param length the length of the stream
+       * @param offsets the stream progress of each sender
+       * @param idx the sender's index
+       * @param offset the offset claimed by the chunk
+       * @param chunk the chunk
+       * @returns true if the sender's stream is now complete
+       */
+      bool AccumulateChunk(char *dst, int length, QHash<int, int> &offsets,
+          int idx, int offset, const QByteArray &chunk);
+
+      /**
+       * Returns the offset and length of the message segment combined by a
+       * server, the whole message unless using reduce-scatter
+       * @param sidx the server's index in the subgroup
+       */
+      QPair<int, int> GetServerSegment(int sidx) const;
+
+      /**
+       * Returns the offset and length of a server's reduce-scatter segment
+       * @param sidx the server's index in the subgroup
+       * @param length the message length
+       */
+      QPair<int, int> GetServerSegment(int sidx, int length) const;
+
+      /**
+       * Returns the statement an owner signs to commit to its aggregate,
+       * binding the aggregate's hash to the segment commits it combined
+       * @param phase the phase of the aggregate
+       * @param sidx the owner's index in the subgroup
+       * @param commit the hash of the aggregate
+       * @param server_commits the segment commits of every server
+       */
+      QByteArray AggregateStatement(int phase, int sidx,
+          const QByteArray &commit,
+          const QHash<int, QList<QByteArray> > &server_commits) const;
+
+      /**
+       * Compares the recomputed aggregates against the owners' signed
+       * commits, blaming a forger or accepting the recomputed cleartext
+       */
+      void ConcludeAudit();
+
       void GenerateServerCiphertext();
       QByteArray GenerateSlotMessage();
       bool CheckData();
@@ -507,10 +806,69 @@ namespace Anonymity {
       QPair<int, QByteArray> GetRebuttal(int phase, int accuse_idx,
           const QBitArray &server_bits);
 
+      /**
+       * Returns true if pads should be retained for the phase log
+       */
+      bool LogPads() const
+      {
+        return IsServer() && _accusations_enabled && !_compact_blame_logs;
+      }
+
+      /**
+       * Logs a chunk of a client ciphertext for accusations
+       * @param idx the group index of the client
+       * @param chunk the chunk
+       * @param complete true if this is the final chunk
+       * @returns true if the chunk is retained in the blame log
+       */
+      bool LogClientChunk(int idx, const QByteArray &chunk, bool complete);
+
+      /**
+       * Discards a client ciphertext that has not been completely received,
+       * xoring its chunks back out of the accumulator and excluding the
+       * client from this phase
+       * @param idx the group index of the client
+       * @returns false if the received chunks could not be recovered
+       */
+      bool DropClientCiphertext(int idx);
+
+      /**
+       * Returns the client ciphertext retained in a phase log, loading it
+       * from the spill file for compact logs
+       * @param phase_log the phase log
+       * @param idx the group index of the client
+       * @param message returns the ciphertext
+       * @returns false if it is missing or fails to match its hash
+       */
+      bool GetLoggedMessage(const QSharedPointer<PhaseLog> &phase_log,
+          int idx, QByteArray &message);
+
+      /**
+       * Returns the bits at the given index of the logged client ciphertexts
+       * and of the pads this server generated for each client
+       * @param phase_log the phase log
+       * @param msg_idx the bit index
+       */
+      QPair<QBitArray, QBitArray> GetBitsAtIndex(
+          const QSharedPointer<PhaseLog> &phase_log, int msg_idx);
+
+      /**
+       * Returns a pad generator for the given base seed and phase
+       * @param base_seed the shared secret with the remote peer
+       * @param phase the phase the pad will be used in
+       */
+      Random *CreatePadRng(const QByteArray &base_seed, int phase) const;
+
       QSharedPointer<ServerState> _server_state;
       QSharedPointer<State> _state;
       RoundStateMachine<CSBulkRound> _state_machine;
       bool _stop_next;
+      Crypto::Library::RngType _pad_rng_type;
+      bool _accusations_enabled;
+      bool _compact_blame_logs;
+      int _pad_pipeline_depth;
+      bool _reduce_scatter;
+      QMap<int, QFuture<PrecomputedPads> > _pad_pipeline;
       Messaging::GetDataMethod<CSBulkRound> _get_blame_data;
       BufferSink _blame_sink;
 
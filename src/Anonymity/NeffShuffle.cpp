@@ -1,7 +1,11 @@
+#include <QThread>
 #include <QThreadPool>
+#include <QtConcurrentMap>
+#include "Crypto/AbstractGroup/CppECGroup.hpp"
 #include "Crypto/CppDsaPrivateKey.hpp"
 #include "Crypto/CppDsaPublicKey.hpp"
 #include "Crypto/CppNeffShuffle.hpp"
+#include "Crypto/GroupNeffShuffle.hpp"
 #include "Identity/PublicIdentity.hpp"
 #include "Utils/QRunTimeError.hpp"
 #include "Utils/Timer.hpp"
@@ -10,13 +14,49 @@
 #include "NeffShuffle.hpp"
 
 namespace Dissent {
+  using Crypto::AbstractGroup::CppECGroup;
+  using Crypto::AbstractGroup::ECParams;
   using Crypto::CppDsaPrivateKey;
   using Crypto::CppDsaPublicKey;
   using Crypto::CppNeffShuffle;
+  using Crypto::GroupNeffShuffle;
   using Identity::PublicIdentity;
   using Utils::QRunTimeError;
 
 namespace Anonymity {
+namespace {
+  /**
+   * A single server's transcript along with the input and keys it is
+   * verified against
+   */
+  struct TranscriptJob {
+    QSharedPointer<NeffShuffle::AbstractGroup> group;
+    QVector<QSharedPointer<Crypto::AsymmetricKey> > keys;
+    QVector<NeffShuffle::Element> elements;
+    QVector<QByteArray> input;
+    QByteArray transcript;
+  };
+
+  struct TranscriptResult {
+    bool valid;
+    QVector<QByteArray> output;
+  };
+
+  TranscriptResult VerifyTranscript(const TranscriptJob &job)
+  {
+    TranscriptResult result;
+    if(job.group) {
+      // Groups may carry mutable scratch space, so each job uses its own
+      result.valid = GroupNeffShuffle(job.group->Copy()).Verify(job.input,
+          job.elements, job.transcript, result.output);
+    } else {
+      result.valid = CppNeffShuffle().Verify(job.input, job.keys,
+          job.transcript, result.output);
+    }
+    return result;
+  }
+}
+
   NeffShuffle::NeffShuffle(const Group &group,
       const PrivateIdentity &ident, const Id &round_id,
       QSharedPointer<Network> network,
@@ -43,11 +83,42 @@ namespace Anonymity {
   {
   }
 
+  void NeffShuffle::SetShuffleGroup(const QSharedPointer<AbstractGroup> &group)
+  {
+    if(_state->key_shuffle) {
+      qWarning() << "Key shuffles require DSA keys, ignoring the shuffle group";
+      return;
+    }
+    _state->shuffle_group = group;
+  }
+
+  void NeffShuffle::SetPipelined(bool pipelined)
+  {
+    if(_server_state) {
+      _server_state->pipelined = pipelined;
+    }
+  }
+
+  QVector<QByteArray> NeffShuffle::GetServerKeyBytes() const
+  {
+    QVector<QByteArray> keys;
+    if(_state->shuffle_group) {
+      foreach(const Element &element, _state->server_elements) {
+        keys.append(_state->shuffle_group->ElementToByteArray(element));
+      }
+    } else {
+      foreach(const QSharedPointer<AsymmetricKey> &key, _state->server_keys) {
+        keys.append(key->GetByteArray());
+      }
+    }
+    return keys;
+  }
+
   void NeffShuffle::VerifiableBroadcastToServers(const QByteArray &data)
   { 
     Q_ASSERT(IsServer());
     
-    QByteArray msg = data + GetSigningKey()->Sign(data);
+    QByteArray msg = SignMessage(data);
     foreach(const PublicIdentity &pi, GetGroup().GetSubgroup()) {
       GetNetwork()->Send(pi.GetId(), msg);
     }
@@ -57,7 +128,7 @@ namespace Anonymity {
   {
     Q_ASSERT(IsServer());
   
-    QByteArray msg = data + GetSigningKey()->Sign(data);
+    QByteArray msg = SignMessage(data);
     foreach(const QSharedPointer<Connection> &con,
         GetNetwork()->GetConnectionManager()->
         GetConnectionTable().GetConnections())
@@ -173,28 +244,46 @@ namespace Anonymity {
       QDataStream &stream)
   {
     int gidx = GetGroup().GetSubgroup().GetIndex(from);
-    if(_server_state->server_keys[gidx]) {
-      throw QRunTimeError("Received multiples keys.");
-    }
+    QSharedPointer<AbstractGroup> group = _state->shuffle_group;
+    if(group) {
+      if(!group->IsIdentity(_server_state->server_elements[gidx])) {
+        throw QRunTimeError("Received multiples keys.");
+      }
 
-    QSharedPointer<AsymmetricKey> key;
-    stream >> key;
-    if(!key || !key->IsValid()) {
-      throw QRunTimeError("Invalid key");
-    }
+      QByteArray bkey;
+      stream >> bkey;
+      Element key = group->ElementFromByteArray(bkey);
+      if(!group->IsElement(key) || group->IsIdentity(key)) {
+        throw QRunTimeError("Invalid key");
+      }
 
-    QSharedPointer<PublicKeyType> tkey = key.dynamicCast<PublicKeyType>();
-    if(!tkey) {
-      throw QRunTimeError("Invalid key type");
-    }
+      /// @todo check proof of ownership
 
-    if(!_server_state->my_key->InGroup(tkey->GetPublicElement())) {
-      throw QRunTimeError("Invalid generator used.");
-    }
+      _server_state->server_elements[gidx] = key;
+    } else {
+      if(_server_state->server_keys[gidx]) {
+        throw QRunTimeError("Received multiples keys.");
+      }
 
-    /// @todo check proof of ownership
+      QSharedPointer<AsymmetricKey> key;
+      stream >> key;
+      if(!key || !key->IsValid()) {
+        throw QRunTimeError("Invalid key");
+      }
+
+      QSharedPointer<PublicKeyType> tkey = key.dynamicCast<PublicKeyType>();
+      if(!tkey) {
+        throw QRunTimeError("Invalid key type");
+      }
 
-    _server_state->server_keys[gidx] = key;
+      if(!_server_state->my_key->InGroup(tkey->GetPublicElement())) {
+        throw QRunTimeError("Invalid generator used.");
+      }
+
+      /// @todo check proof of ownership
+
+      _server_state->server_keys[gidx] = key;
+    }
     _server_state->msgs_received++;
 
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId() <<
@@ -245,20 +334,39 @@ namespace Anonymity {
     }
 
     QVector<QSharedPointer<AsymmetricKey> > server_keys;
+    QVector<Element> server_elements;
     QVector<QByteArray> server_signatures;
-    stream >> server_keys >> server_signatures;
+    QSharedPointer<AbstractGroup> group = _state->shuffle_group;
+    if(group) {
+      QVector<QByteArray> bkeys;
+      stream >> bkeys >> server_signatures;
+      foreach(const QByteArray &bkey, bkeys) {
+        Element key = group->ElementFromByteArray(bkey);
+        if(!group->IsElement(key)) {
+          throw QRunTimeError("Invalid server key");
+        }
+        server_elements.append(key);
+      }
+    } else {
+      stream >> server_keys >> server_signatures;
+    }
 
-    if(GetGroup().GetSubgroup().Count() != server_keys.size()) {
+    if(GetGroup().GetSubgroup().Count() !=
+        (group ? server_elements.size() : server_keys.size()))
+    {
       throw QRunTimeError("Missing some server keys");
     } else if(GetGroup().GetSubgroup().Count() != server_signatures.size()) {
       throw QRunTimeError("Missing some server signatures");
     }
 
+    _state->server_keys = server_keys;
+    _state->server_elements = server_elements;
+
     QSharedPointer<Crypto::Hash> hash(Crypto::CryptoFactory::GetInstance().
         GetLibrary()->GetHashAlgorithm());
 
-    foreach(const QSharedPointer<AsymmetricKey> &key, server_keys) {
-      hash->Update(key->GetByteArray());
+    foreach(const QByteArray &key, GetServerKeyBytes()) {
+      hash->Update(key);
     }
     QByteArray key_hash = hash->ComputeHash();
 
@@ -270,8 +378,6 @@ namespace Anonymity {
       }
     }
 
-    _state->server_keys = server_keys;
-
     qDebug() << GetGroup().GetIndex(GetLocalId()) << GetLocalId() <<
         ": received keys from" << GetGroup().GetIndex(from) << from;
     _state_machine.StateComplete();
@@ -289,7 +395,10 @@ namespace Anonymity {
     QByteArray msg;
     stream >> msg;
 
-    if(!_server_state->my_key->InGroup(msg)) {
+    bool valid = _state->shuffle_group ?
+      GroupNeffShuffle(_state->shuffle_group).InGroup(msg) :
+      _server_state->my_key->InGroup(msg);
+    if(!valid) {
       throw QRunTimeError("Invalid element pair");
     }
     
@@ -345,6 +454,15 @@ namespace Anonymity {
         VerifyShuffles();
       }
     }
+
+    // When pipelined, shuffle the previous server's output immediately and
+    // let the verification above catch up in the background
+    if(_server_state->pipelined &&
+        _state_machine.GetState() == WAITING_FOR_SHUFFLES_BEFORE_TURN &&
+        index == GetGroup().GetSubgroup().GetIndex(GetLocalId()) - 1)
+    {
+      _state_machine.StateComplete();
+    }
   }
 
   void NeffShuffle::HandleSignature(const Id &from, QDataStream &stream)
@@ -431,12 +549,22 @@ namespace Anonymity {
   void NeffShuffle::SubmitKey()
   {
     _server_state->msgs_received = 0;
-    QSharedPointer<AsymmetricKey> key(_server_state->my_key->GetPublicKey());
 
     QByteArray out;
     QDataStream stream(&out, QIODevice::WriteOnly);
-    stream << MSG_KEY_EXCH << GetRoundId() << key;
-    _server_state->server_keys.resize(GetGroup().GetSubgroup().Count());
+    stream << MSG_KEY_EXCH << GetRoundId();
+
+    QSharedPointer<AbstractGroup> group = _state->shuffle_group;
+    if(group) {
+      stream << group->ElementToByteArray(group->Exponentiate(
+            group->GetGenerator(), _server_state->my_exponent));
+      _server_state->server_elements.fill(group->GetIdentity(),
+          GetGroup().GetSubgroup().Count());
+    } else {
+      QSharedPointer<AsymmetricKey> key(_server_state->my_key->GetPublicKey());
+      stream << key;
+      _server_state->server_keys.resize(GetGroup().GetSubgroup().Count());
+    }
     VerifiableBroadcastToServers(out);
     _state_machine.StateComplete();
   }
@@ -446,8 +574,8 @@ namespace Anonymity {
     QSharedPointer<Crypto::Hash> hash(Crypto::CryptoFactory::GetInstance().
         GetLibrary()->GetHashAlgorithm());
 
-    foreach(const QSharedPointer<AsymmetricKey> &key, _server_state->server_keys) {
-      hash->Update(key->GetByteArray());
+    foreach(const QByteArray &key, GetServerKeyBytes()) {
+      hash->Update(key);
     }
     _server_state->key_hash = hash->ComputeHash();
 
@@ -465,16 +593,32 @@ namespace Anonymity {
   void NeffShuffle::PushServerKeys()
   {
     _server_state->next_verify_keys = _server_state->server_keys;
+    _server_state->next_verify_elements = _server_state->server_elements;
     QByteArray out;
     QDataStream stream(&out, QIODevice::WriteOnly);
-    stream << MSG_KEY_DIST << GetRoundId() << _server_state->server_keys
-      << _server_state->key_signatures;
+    stream << MSG_KEY_DIST << GetRoundId();
+    if(_state->shuffle_group) {
+      stream << GetServerKeyBytes();
+    } else {
+      stream << _server_state->server_keys;
+    }
+    stream << _server_state->key_signatures;
     VerifiableBroadcastToClients(out);
     _state_machine.StateComplete();
   }
 
   void NeffShuffle::GenerateMessage()
   {
+    if(_state->shuffle_group) {
+      GroupNeffShuffle shuffle(_state->shuffle_group);
+      QPair<QByteArray, bool> input =
+        GetData(_state->shuffle_group->BytesPerElement());
+      _state->input = shuffle.SeriesEncrypt(_state->server_elements,
+          input.first);
+      _state_machine.StateComplete();
+      return;
+    }
+
     QSharedPointer<CppDsaPublicKey> pkey =
       _state->server_keys[0].dynamicCast<CppDsaPublicKey>();
     if(!pkey) {
@@ -521,6 +665,29 @@ namespace Anonymity {
 
   void NeffShuffle::ShuffleMessages()
   {
+    int my_idx = GetGroup().GetSubgroup().GetIndex(GetLocalId());
+    QSharedPointer<AbstractGroup> group = _state->shuffle_group;
+
+    // Without pipelining, or as the first server, the input has already
+    // been verified; otherwise it is the previous server's claimed output
+    if(!_server_state->pipelined || my_idx == 0) {
+      _server_state->shuffle_input = _server_state->next_verify_input;
+    } else {
+      Id prev = GetGroup().GetSubgroup().GetId(my_idx - 1);
+      QByteArray transcript = _server_state->shuffle_proof.value(prev);
+      bool parsed = group ?
+        GroupNeffShuffle(group).GetOutput(transcript,
+            _server_state->shuffle_input) :
+        CppNeffShuffle().GetOutput(transcript, _server_state->shuffle_input);
+      if(!parsed) {
+        qCritical() << "Unable to parse the shuffle output from" << prev;
+        _server_state->shuffle_input.clear();
+      }
+    }
+
+    _server_state->shuffle_keys = _state->server_keys.mid(my_idx);
+    _server_state->shuffle_elements = _state->server_elements.mid(my_idx);
+
     NeffShufflePrivate::ShuffleMessages *shuffler =
       new NeffShufflePrivate::ShuffleMessages(this);
     QObject::connect(shuffler, SIGNAL(Finished()),
@@ -530,8 +697,8 @@ namespace Anonymity {
 
   void NeffShuffle::TransmitShuffle()
   {
-    QByteArray transcript = _server_state->shuffle_proof.value(GetLocalId());
-    _server_state->shuffle_proof.remove(GetLocalId());
+    QByteArray transcript = _server_state->shuffle_transcript;
+    _server_state->shuffle_transcript.clear();
 
     QByteArray msg;
     QDataStream stream(&msg, QIODevice::WriteOnly);
@@ -548,23 +715,59 @@ namespace Anonymity {
 
   void NeffShuffle::VerifyShuffles()
   {
+    _server_state->verifying = true;
+
+    // The verifier outlives run() so that VerifyShufflesDone can apply its
+    // results on the event loop, it is deleted there afterward
     NeffShufflePrivate::VerifyShuffles *verifier =
       new NeffShufflePrivate::VerifyShuffles(this);
+    verifier->setAutoDelete(false);
     QObject::connect(verifier, SIGNAL(Finished()),
         this, SLOT(VerifyShufflesDone()));
+    QObject::connect(verifier, SIGNAL(Finished()),
+        verifier, SLOT(deleteLater()));
     QThreadPool::globalInstance()->start(verifier);
   }
 
   void NeffShuffle::VerifyShufflesDone()
   {
+    NeffShufflePrivate::VerifyShuffles *verifier =
+      qobject_cast<NeffShufflePrivate::VerifyShuffles *>(sender());
+    Q_ASSERT(verifier);
+
     _server_state->verifying = false;
+    if(Stopped()) {
+      return;
+    }
+
+    _server_state->next_verify_keys = verifier->_keys;
+    _server_state->next_verify_elements = verifier->_elements;
+    _server_state->next_verify_input = verifier->_input;
+    _server_state->next_verify_idx = verifier->_end;
+    if(verifier->_invalid_idx >= 0) {
+      _server_state->invalid_idx = verifier->_invalid_idx;
+    } else if(verifier->_last) {
+      _server_state->cleartext = verifier->_cleartext;
+    }
+
+    // Never sign a cleartext derived from an invalid shuffle
+    if(_server_state->invalid_idx >= 0) {
+      Id bad = GetGroup().GetSubgroup().GetId(_server_state->invalid_idx);
+      _bad_members.append(GetGroup().GetIndex(bad));
+      SetInterrupted();
+      Stop("Invalid shuffle transcript from " + bad.ToString());
+      return;
+    }
+
     if(_server_state->new_end_verify_idx != _server_state->end_verify_idx) {
       _server_state->end_verify_idx = _server_state->new_end_verify_idx;
       VerifyShuffles();
       return;
     }
 
-    if(_server_state->end_verify_idx == GetGroup().GetSubgroup().GetIndex(GetLocalId())) {
+    if(!_server_state->pipelined &&
+        _server_state->end_verify_idx == GetGroup().GetSubgroup().GetIndex(GetLocalId()))
+    {
       _state_machine.StateComplete();
       return;
     }
@@ -637,9 +840,29 @@ namespace Anonymity {
     _state_machine.StateComplete();
   }
 
+  QSharedPointer<Round> CreateECNeffShuffle(const Round::Group &group,
+      const Round::PrivateIdentity &ident, const Connections::Id &round_id,
+      QSharedPointer<Connections::Network> network,
+      Messaging::GetDataCallback &get_data)
+  {
+    QSharedPointer<NeffShuffle> round(new NeffShuffle(group, ident, round_id,
+          network, get_data));
+    round->SetShuffleGroup(CppECGroup::GetGroup(ECParams::NIST_P256));
+    round->SetSharedPointer(round);
+    return round;
+  }
+
 namespace NeffShufflePrivate {
   void KeyGeneration::run()
   {
+    QSharedPointer<NeffShuffle::AbstractGroup> group =
+      _shuffle->_state->shuffle_group;
+    if(group) {
+      _shuffle->_server_state->my_exponent = group->RandomExponent();
+      emit Finished();
+      return;
+    }
+
     QSharedPointer<CppDsaPrivateKey> base_key;
     if(_shuffle->_server_state->key_shuffle) {
       base_key = QSharedPointer<CppDsaPrivateKey>(
@@ -659,54 +882,124 @@ namespace NeffShufflePrivate {
 
   void ShuffleMessages::run()
   {
-    QVector<QByteArray> input = _shuffle->_server_state->next_verify_input;
-    QVector<QSharedPointer<Crypto::AsymmetricKey> > remaining_keys =
-      _shuffle->_server_state->next_verify_keys;
-    remaining_keys.pop_front();
+    QVector<QByteArray> input = _shuffle->_server_state->shuffle_input;
     QVector<QByteArray> output;
     QByteArray transcript;
 
-    CppNeffShuffle shuffle;
-    shuffle.Shuffle(input, _shuffle->_server_state->my_key,
-        remaining_keys, output, transcript);
+    if(_shuffle->_state->shuffle_group) {
+      QVector<NeffShuffle::Element> remaining =
+        _shuffle->_server_state->shuffle_elements;
+      remaining.pop_front();
+      GroupNeffShuffle shuffle(_shuffle->_state->shuffle_group);
+      shuffle.Shuffle(input, _shuffle->_server_state->my_exponent,
+          remaining, output, transcript);
+    } else {
+      QVector<QSharedPointer<Crypto::AsymmetricKey> > remaining_keys =
+        _shuffle->_server_state->shuffle_keys;
+      remaining_keys.pop_front();
+      CppNeffShuffle shuffle;
+      shuffle.Shuffle(input, _shuffle->_server_state->my_key,
+          remaining_keys, output, transcript);
+    }
 
 //    _shuffle->_server_state->next_verify_input = input;//output;
 //    _shuffle->_server_state->next_verify_idx = my_idx;// my_idx+1
 //    _shuffle->_server_state->next_verify_keys = tkeys; //remaining_keys;
-    _shuffle->_server_state->shuffle_proof[_shuffle->GetLocalId()] = transcript; // null
+    _shuffle->_server_state->shuffle_transcript = transcript;
 
     emit Finished();
   }
 
+  VerifyShuffles::VerifyShuffles(NeffShuffle *shuffle) :
+    _group(shuffle->_state->shuffle_group),
+    _key(shuffle->_server_state->my_key),
+    _start(shuffle->_server_state->next_verify_idx),
+    _end(shuffle->_server_state->end_verify_idx),
+    _last(_end == shuffle->GetGroup().GetSubgroup().Count()),
+    _keys(shuffle->_server_state->next_verify_keys),
+    _elements(shuffle->_server_state->next_verify_elements),
+    _input(shuffle->_server_state->next_verify_input),
+    _invalid_idx(-1)
+  {
+    // Copied here as HandleShuffle may add transcripts while verifying
+    for(int idx = _start; idx < _end; idx++) {
+      Connections::Id id = shuffle->GetGroup().GetSubgroup().GetId(idx);
+      _transcripts.append(shuffle->_server_state->shuffle_proof.value(id));
+    }
+  }
+
   void VerifyShuffles::run()
   {
-    QVector<QSharedPointer<Crypto::AsymmetricKey> > remaining_keys =
-      _shuffle->_server_state->next_verify_keys;
-    QVector<QByteArray> input = _shuffle->_server_state->next_verify_input;
+    QVector<QSharedPointer<Crypto::AsymmetricKey> > &remaining_keys = _keys;
+    QVector<NeffShuffle::Element> &remaining_elements = _elements;
+    QVector<QByteArray> &input = _input;
     QVector<QByteArray> output;
     CppNeffShuffle shuffle;
+    QSharedPointer<NeffShuffle::AbstractGroup> group = _group;
+
+    // Each transcript carries its claimed output, which is the next
+    // transcript's input, so the transcripts can be verified independently
+    QList<TranscriptJob> jobs;
+    QVector<QByteArray> claimed = input;
+    int start = _start;
+    int end = _end;
+    for(int idx = start; idx < end; idx++) {
+      TranscriptJob job;
+      job.group = group;
+      job.keys = remaining_keys;
+      job.elements = remaining_elements;
+      job.input = claimed;
+      job.transcript = _transcripts[idx - start];
+      jobs.append(job);
+
+      bool parsed = group ?
+        GroupNeffShuffle(group).GetOutput(job.transcript, claimed) :
+        shuffle.GetOutput(job.transcript, claimed);
+      if(!parsed) {
+        claimed.clear();
+      }
 
-    for(int idx = _shuffle->_server_state->next_verify_idx; 
-        idx < _shuffle->_server_state->end_verify_idx; idx++)
+      if(group) {
+        remaining_elements.pop_front();
+      } else {
+        remaining_keys.pop_front();
+      }
+    }
+
+    QList<TranscriptResult> results;
+    if(jobs.count() > 1 && QThread::idealThreadCount() > 1 &&
+        Crypto::CryptoFactory::GetInstance().GetThreadingType() ==
+        Crypto::CryptoFactory::MultiThreaded)
     {
-      Connections::Id id = _shuffle->GetGroup().GetSubgroup().GetId(idx);
-      QByteArray transcript = _shuffle->_server_state->shuffle_proof[id];
-      if(!shuffle.Verify(input, remaining_keys, transcript, output)) {
-        qCritical() << "Invalid transcript from" << id << "at idx" << idx;
+      results = QtConcurrent::blockingMapped(jobs, VerifyTranscript);
+    } else {
+      foreach(const TranscriptJob &job, jobs) {
+        results.append(VerifyTranscript(job));
       }
-      input = output;
-      remaining_keys.pop_front();
     }
 
-    _shuffle->_server_state->next_verify_keys = remaining_keys;
-    _shuffle->_server_state->next_verify_input = input;
-    _shuffle->_server_state->next_verify_idx = _shuffle->_server_state->end_verify_idx;
+    // Once a transcript fails, later ones were checked against an
+    // unverified input and cannot be accepted
+    bool valid = true;
+    for(int idx = start; idx < end; idx++) {
+      if(valid && !results[idx - start].valid) {
+        qCritical() << "Invalid transcript at idx" << idx;
+        _invalid_idx = idx;
+      }
+
+      valid = valid && results[idx - start].valid;
+      if(!valid) {
+        continue;
+      }
+      output = results[idx - start].output;
+      input = output;
+    }
 
-    if(_shuffle->_server_state->end_verify_idx == _shuffle->GetGroup().GetSubgroup().Count()) {
-      _shuffle->_state->cleartext.clear();
+    if(_last && valid) {
       foreach(const QByteArray &pair, output) {
-        _shuffle->_server_state->cleartext.append(
-            _shuffle->_server_state->my_key->SeriesDecryptFinish(pair));
+        _cleartext.append(group ?
+            GroupNeffShuffle(group).SeriesDecryptFinish(pair) :
+            _key->SeriesDecryptFinish(pair));
       }
     }
 
@@ -2,6 +2,7 @@
 #define DISSENT_ANONYMITY_NEFF_MSG_SHUFFLE_H_GUARD
 
 #include "Connections/Network.hpp"
+#include "Crypto/AbstractGroup/AbstractGroup.hpp"
 #include "Crypto/AsymmetricKey.hpp"
 #include "Crypto/CppDsaPrivateKey.hpp"
 #include "Crypto/Integer.hpp"
@@ -24,7 +25,9 @@ namespace NeffShufflePrivate {
    * the Neff's Shuffle primitive, and verifiable decryption
    * to produce a single exchange verifiable re-encryption mixnet.
    * The round can be used to either exchange keys (1024, 160)
-   * or messages (2048, 2047).
+   * or messages (2048, 2047).  Messages may instead be shuffled over any
+   * AbstractGroup, such as an elliptic curve, see SetShuffleGroup.
+   * Servers may also pipeline the cascade, see SetPipelined.
    */
   class NeffShuffle : public Round {
     Q_OBJECT
@@ -35,6 +38,8 @@ namespace NeffShufflePrivate {
     public:
       friend class RoundStateMachine<NeffShuffle>;
       typedef Crypto::AsymmetricKey AsymmetricKey;
+      typedef Crypto::AbstractGroup::AbstractGroup AbstractGroup;
+      typedef Crypto::AbstractGroup::Element Element;
 
       enum MessageType {
         MSG_KEY_EXCH = 0,
@@ -130,6 +135,50 @@ namespace NeffShufflePrivate {
 
       virtual bool CSGroupCapable() const { return true; }
 
+      /**
+       * Returns the server whose shuffle failed to verify, if any
+       */
+      inline virtual const QVector<int> &GetBadMembers() const
+      {
+        return _bad_members;
+      }
+
+      /**
+       * Shuffles messages using ElGamal over the given group rather than
+       * over a DSA integer group.  Each message must then fit into a single
+       * group element.  Must be set before the round starts and is ignored
+       * for key shuffles.
+       * @param group the group, all members must use the same group
+       */
+      void SetShuffleGroup(const QSharedPointer<AbstractGroup> &group);
+
+      /**
+       * Returns the group used for the message shuffle, if any
+       */
+      QSharedPointer<AbstractGroup> GetShuffleGroup() const
+      {
+        return _state->shuffle_group;
+      }
+
+      /**
+       * In a pipelined cascade, a server shuffles the output claimed by
+       * the previous server as soon as it arrives and verifies the earlier
+       * shuffles in the background, rather than verifying them before its
+       * turn.  All shuffles are still verified before the cleartext is
+       * signed.  Must be set before the round starts, has no effect on
+       * clients.
+       * @param pipelined true to enable pipelining
+       */
+      void SetPipelined(bool pipelined);
+
+      /**
+       * Returns true if this server pipelines the cascade
+       */
+      bool IsPipelined() const
+      {
+        return _server_state && _server_state->pipelined;
+      }
+
     protected:
       typedef Crypto::Integer Integer;
       typedef Crypto::CppDsaPrivateKey KeyType;
@@ -174,6 +223,13 @@ namespace NeffShufflePrivate {
           QByteArray input;
           QVector<QByteArray> cleartext;
           QVector<QSharedPointer<AsymmetricKey> > server_keys;
+
+          /**
+           * When shuffling over an AbstractGroup, the group and the
+           * public elements of the servers replace server_keys
+           */
+          QSharedPointer<AbstractGroup> shuffle_group;
+          QVector<Element> server_elements;
       };
       
       QSharedPointer<State> GetState() const { return _state; }
@@ -212,6 +268,11 @@ namespace NeffShufflePrivate {
 
       void ConcludeMessageSubmission(const int &);
 
+      /**
+       * Returns the serialized server keys or elements for signing
+       */
+      QVector<QByteArray> GetServerKeyBytes() const;
+
       /**
        * Internal state specific to servers
        */
@@ -219,10 +280,12 @@ namespace NeffShufflePrivate {
         public:
           ServerState() :
             msgs_received(0),
+            pipelined(false),
             verifying(false),
             next_verify_idx(0),
             end_verify_idx(0),
-            new_end_verify_idx(0)
+            new_end_verify_idx(0),
+            invalid_idx(-1)
           {}
 
           virtual ~ServerState() {}
@@ -237,17 +300,36 @@ namespace NeffShufflePrivate {
 
           QVector<QByteArray> initial_input;
           QHash<Id, QByteArray > shuffle_proof;
+          bool pipelined;
+
+          /**
+           * The local shuffle's input, keys, and resulting transcript, kept
+           * apart from the verification state so the two can run together
+           */
+          QVector<QByteArray> shuffle_input;
+          QVector<QSharedPointer<AsymmetricKey> > shuffle_keys;
+          QVector<Element> shuffle_elements;
+          QByteArray shuffle_transcript;
+
           QVector<QByteArray> next_verify_input;
           bool verifying;
           int next_verify_idx;
           int end_verify_idx;
           int new_end_verify_idx;
+
+          /**
+           * Subgroup index of the first transcript that failed to verify
+           */
+          int invalid_idx;
           QVector<QSharedPointer<AsymmetricKey> > next_verify_keys;
+          Integer my_exponent;
+          QVector<Element> next_verify_elements;
           QByteArray cleartext_hash;
           QHash<Id, QByteArray > signatures;
       };
       
       QSharedPointer<ServerState> _server_state;
+      QVector<int> _bad_members;
       QSharedPointer<State> _state;
       RoundStateMachine<NeffShuffle> _state_machine;
 
@@ -256,6 +338,31 @@ namespace NeffShufflePrivate {
       void VerifyShufflesDone();
   };
 
+  /**
+   * Creates a NeffShuffle whose servers pipeline the cascade
+   */
+  inline QSharedPointer<Round> CreatePipelinedNeffShuffle(
+      const Round::Group &group, const Round::PrivateIdentity &ident,
+      const Connections::Id &round_id,
+      QSharedPointer<Connections::Network> network,
+      Messaging::GetDataCallback &get_data)
+  {
+    QSharedPointer<NeffShuffle> round(new NeffShuffle(group, ident, round_id,
+          network, get_data));
+    round->SetPipelined(true);
+    round->SetSharedPointer(round);
+    return round;
+  }
+
+  /**
+   * Creates a NeffShuffle that shuffles messages over the NIST P-256
+   * curve, so each message must fit into a single curve point
+   */
+  QSharedPointer<Round> CreateECNeffShuffle(const Round::Group &group,
+      const Round::PrivateIdentity &ident, const Connections::Id &round_id,
+      QSharedPointer<Connections::Network> network,
+      Messaging::GetDataCallback &get_data);
+
 namespace NeffShufflePrivate {
   class KeyGeneration : public QObject, public QRunnable {
     Q_OBJECT
@@ -289,11 +396,17 @@ namespace NeffShufflePrivate {
       NeffShuffle *_shuffle;
   };
 
+  /**
+   * Verifies a range of shuffle transcripts off of the event loop.  The
+   * inputs are copied on construction and the results are kept here until
+   * the NeffShuffle applies them, so the server state is never shared with
+   * the pool thread.
+   */
   class VerifyShuffles : public QObject, public QRunnable {
     Q_OBJECT
 
     public:
-      VerifyShuffles(NeffShuffle *shuffle) : _shuffle(shuffle) { }
+      VerifyShuffles(NeffShuffle *shuffle);
 
       virtual ~VerifyShuffles() { }
       virtual void run();
@@ -302,7 +415,20 @@ namespace NeffShufflePrivate {
       void Finished();
 
     private:
-      NeffShuffle *_shuffle;
+      friend class Dissent::Anonymity::NeffShuffle;
+
+      QSharedPointer<NeffShuffle::AbstractGroup> _group;
+      QSharedPointer<Crypto::CppDsaPrivateKey> _key;
+      QVector<QByteArray> _transcripts;
+      int _start;
+      int _end;
+      bool _last;
+
+      QVector<QSharedPointer<Crypto::AsymmetricKey> > _keys;
+      QVector<NeffShuffle::Element> _elements;
+      QVector<QByteArray> _input;
+      int _invalid_idx;
+      QVector<QByteArray> _cleartext;
   };
 }
 }
@@ -273,9 +273,7 @@ namespace Anonymity {
     uint size = GetGroup().Count();
 
     QByteArray cleartext(_expected_bulk_size, 0);
-    foreach(QByteArray ciphertext, _messages) {
-      Xor(cleartext, cleartext, ciphertext);
-    }
+    Utils::XorEngine::Fold(cleartext, _messages.toList());
 
     uint msg_idx = 0;
     for(uint member_idx = 0; member_idx < size; member_idx++) {
@@ -1,4 +1,8 @@
+#include <QDataStream>
+
 #include "Connections/Connection.hpp"
+#include "Crypto/CryptoFactory.hpp"
+#include "Crypto/Hmac.hpp"
 #include "Messaging/Request.hpp"
 
 #include "Round.hpp"
@@ -57,6 +61,41 @@ namespace Anonymity {
 
   bool Round::Verify(const Id &from, const QByteArray &data, QByteArray &msg)
   {
+    if(data.isEmpty()) {
+      qDebug() << "Received empty data block";
+      return false;
+    }
+
+    int type = data[data.size() - 1];
+    int body_size = data.size() - 1;
+
+    if(type == MacAuthentication) {
+      QSharedPointer<Hmac> mac = GetMac(from, GetLocalId());
+      if(mac.isNull()) {
+        qDebug() << "Received MAC data block, no shared key with peer";
+        return false;
+      }
+
+      int mac_size = mac->GetMacLength();
+      if(body_size < mac_size) {
+        qDebug() << "Received malformed MAC data block, not enough data blocks." <<
+         "Expected at least:" << mac_size << "got" << body_size;
+        return false;
+      }
+
+      msg = data.left(body_size - mac_size);
+      if(!AllowsMac(msg)) {
+        qDebug() << "Received MAC data block for a message type requiring a signature";
+        return false;
+      }
+
+      QByteArray tag = QByteArray::fromRawData(data.data() + msg.size(), mac_size);
+      return mac->VerifyMac(msg, tag);
+    } else if(type != SignatureAuthentication) {
+      qDebug() << "Received data block with unknown authentication:" << type;
+      return false;
+    }
+
     QSharedPointer<AsymmetricKey> key = GetGroup().GetKey(from);
     if(key.isNull()) {
       qDebug() << "Received malsigned data block, no such peer";
@@ -64,17 +103,79 @@ namespace Anonymity {
     }
 
     int sig_size = key->GetSignatureLength();
-    if(data.size() < sig_size) {
+    if(body_size < sig_size) {
       qDebug() << "Received malsigned data block, not enough data blocks." <<
-       "Expected at least:" << sig_size << "got" << data.size();
+       "Expected at least:" << sig_size << "got" << body_size;
       return false;
     }
 
-    msg = data.left(data.size() - sig_size);
+    msg = data.left(body_size - sig_size);
     QByteArray sig = QByteArray::fromRawData(data.data() + msg.size(), sig_size);
     return key->Verify(msg, sig);
   }
 
+  QByteArray Round::SignMessage(const QByteArray &data) const
+  {
+    QByteArray msg = data + GetSigningKey()->Sign(data);
+    msg.append(char(SignatureAuthentication));
+    return msg;
+  }
+
+  QByteArray Round::AuthenticateMessage(const Id &to, const QByteArray &data)
+  {
+    if(!AllowsMac(data)) {
+      return SignMessage(data);
+    }
+
+    QSharedPointer<Hmac> mac = GetMac(GetLocalId(), to);
+    if(mac.isNull()) {
+      return SignMessage(data);
+    }
+
+    QByteArray msg = data + mac->ComputeMac(data);
+    msg.append(char(MacAuthentication));
+    return msg;
+  }
+
+  bool Round::AllowsMac(const QByteArray &data) const
+  {
+    if(_mac_types.isEmpty()) {
+      return false;
+    }
+
+    QDataStream stream(data);
+    int mtype;
+    stream >> mtype;
+    return stream.status() == QDataStream::Ok && _mac_types.contains(mtype);
+  }
+
+  QSharedPointer<Round::Hmac> Round::GetMac(const Id &from, const Id &to)
+  {
+    const QByteArray name = from.GetByteArray() + to.GetByteArray();
+    QSharedPointer<Hmac> mac = _macs.value(name);
+    if(mac) {
+      return mac;
+    }
+
+    const Id &remote = (from == GetLocalId()) ? to : from;
+    QByteArray remote_pub = GetGroup().GetPublicDiffieHellman(remote);
+    if(GetDhKey().isNull() || remote_pub.isEmpty()) {
+      return mac;
+    }
+
+    // Keys are bound to the direction and the round, so a MAC can neither
+    // be reflected back to its sender nor replayed in another round
+    Crypto::Library *lib = Crypto::CryptoFactory::GetInstance().GetLibrary();
+    QSharedPointer<Crypto::Hash> hashalgo(lib->GetHashAlgorithm());
+    hashalgo->Update(GetDhKey()->GetSharedSecret(remote_pub));
+    hashalgo->Update(name);
+    hashalgo->Update(GetRoundId().GetByteArray());
+
+    mac = QSharedPointer<Hmac>(new Hmac(hashalgo->ComputeHash()));
+    _macs[name] = mac;
+    return mac;
+  }
+
   void Round::HandleDisconnect(const Id &id)
   {
     if(_group.Contains(id)) {
@@ -2,7 +2,9 @@
 #define DISSENT_ANONYMITY_ROUND_H_GUARD
 
 #include <QDateTime>
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QSharedPointer>
 
 #include "Connections/Id.hpp"
@@ -23,6 +25,7 @@ namespace Connections {
 namespace Crypto {
   class AsymmetricKey;
   class DiffieHellman;
+  class Hmac;
 }
 
 namespace Messaging {
@@ -45,6 +48,7 @@ namespace Anonymity {
       typedef Connections::Network Network;
       typedef Crypto::AsymmetricKey AsymmetricKey;
       typedef Crypto::DiffieHellman DiffieHellman;
+      typedef Crypto::Hmac Hmac;
       typedef Identity::Group Group;
       typedef Identity::PrivateIdentity PrivateIdentity;
       typedef Messaging::GetDataCallback GetDataCallback;
@@ -187,33 +191,80 @@ namespace Anonymity {
       virtual void ProcessData(const Id &id, const QByteArray &data) = 0;
 
       /**
-       * Verifies that the provided data has a signature block and is properly
-       * signed, returning the data block via msg
-       * @param from the signing peers id
-       * @param data the data + signature blocks
+       * The authenticator trailing a message, identified by the final byte
+       */
+      enum AuthenticationType {
+        SignatureAuthentication = 0,
+        MacAuthentication = 1
+      };
+
+      /**
+       * Verifies that the provided data has an authentication block, either
+       * a signature or, for whitelisted message types, a MAC keyed for this
+       * node, returning the data block via msg
+       * @param from the authenticating peers id
+       * @param data the data + authentication blocks
        * @param msg the data block
        */
       bool Verify(const Id &from, const QByteArray &data, QByteArray &msg);
 
+      /**
+       * Returns the data followed by a signature, which any member can
+       * verify and forward as evidence during blame
+       * @param data the message
+       */
+      QByteArray SignMessage(const QByteArray &data) const;
+
+      /**
+       * Returns the data followed by a MAC keyed for the recipient, when the
+       * message type may be MACed, and a signature otherwise
+       * @param to the recipient
+       * @param data the message
+       */
+      QByteArray AuthenticateMessage(const Id &to, const QByteArray &data);
+
+      /**
+       * Enables authenticating the given point-to-point message types with
+       * MACs keyed by the pairwise DiffieHellman secrets rather than with
+       * signatures.  Messages that may be shown to a third party, such as
+       * blame evidence, must not be listed as a MAC is not transferable.
+       * @param types the message types, matching the leading int of a message
+       */
+      inline void SetMacMessageTypes(const QSet<int> &types)
+      {
+        _mac_types = types;
+      }
+
+      /**
+       * Returns true if some point-to-point messages are authenticated with
+       * MACs
+       */
+      inline bool UsesMacAuthentication() const { return !_mac_types.isEmpty(); }
+
+      /**
+       * Returns true if the message's type may be authenticated with a MAC
+       * @param data the message, beginning with its type
+       */
+      bool AllowsMac(const QByteArray &data) const;
+
       /**
        * Signs and encrypts a message before broadcasting
        * @param data the message to broadcast
        */
       virtual inline void VerifiableBroadcast(const QByteArray &data)
       {
-        QByteArray msg = data + GetSigningKey()->Sign(data);
-        GetNetwork()->Broadcast(msg);
+        GetNetwork()->Broadcast(SignMessage(data));
       }
 
       /**
-       * Signs and encrypts a message before sending it to a sepecific peer
+       * Authenticates and encrypts a message before sending it to a sepecific
+       * peer
        * @param to the peer to send it to
        * @param data the message to send
        */
       virtual inline void VerifiableSend(const Id &to, const QByteArray &data)
       {
-        QByteArray msg = data + GetSigningKey()->Sign(data);
-        GetNetwork()->Send(to, msg);
+        GetNetwork()->Send(to, AuthenticateMessage(to, data));
       }
 
       /**
@@ -278,6 +329,14 @@ namespace Anonymity {
       QByteArray GenerateData(int size = DEFAULT_GENERATE_DATA_SIZE);
 
     private:
+      /**
+       * Returns the MAC for messages from one peer to another, one of which
+       * is the local node, or NULL if there is no DiffieHellman key
+       * @param from the sender
+       * @param to the recipient
+       */
+      QSharedPointer<Hmac> GetMac(const Id &from, const Id &to);
+
       QDateTime _create_time;
       QDateTime _start_time;
       const Group _group;
@@ -289,6 +348,12 @@ namespace Anonymity {
       QVector<int> _empty_list;
       bool _interrupted;
       QWeakPointer<Round> _shared;
+      QSet<int> _mac_types;
+
+      /**
+       * Derived MACs, keyed by sender and recipient
+       */
+      QHash<QByteArray, QSharedPointer<Hmac> > _macs;
   };
 
   inline QDebug operator<<(QDebug dbg, const QSharedPointer<Round> &round)
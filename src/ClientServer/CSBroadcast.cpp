@@ -1,3 +1,4 @@
+#include <QList>
 #include <QVariant>
 
 #include "Connections/IOverlaySender.hpp"
@@ -33,6 +34,7 @@ namespace ClientServer {
     msg.append(method);
     msg.append(data);
 
+    QList<QSharedPointer<ISender> > targets;
     foreach(const QSharedPointer<Connection> &con,
         _cm->GetConnectionTable().GetConnections())
     {
@@ -40,14 +42,14 @@ namespace ClientServer {
         continue;
       }
 
-      _rpc->SendNotification(con, "CS::Broadcast", msg);
+      targets.append(con);
     }
 
     if(!_group_holder->GetGroup().Contains(_cm->GetId())) {
-      _rpc->SendNotification(
-          _cm->GetConnectionTable().GetConnection(_cm->GetId()),
-          "CS::Broadcast", msg);
+      targets.append(_cm->GetConnectionTable().GetConnection(_cm->GetId()));
     }
+
+    _rpc->SendNotification(targets, "CS::Broadcast", msg);
   }
 
   void CSBroadcast::BroadcastHelper(const Request &notification)
@@ -99,6 +101,7 @@ namespace ClientServer {
     }
 
     Id forwarder = from->GetRemoteId();
+    QList<QSharedPointer<ISender> > targets;
     if(_group_holder->GetGroup().GetSubgroup().Contains(forwarder)) {
       // Was forwarded by a server ... forward only to client
       foreach(const QSharedPointer<Connection> &con,
@@ -114,7 +117,7 @@ namespace ClientServer {
           continue;
         }
 
-        _rpc->SendNotification(con, "CS::Broadcast", msg);
+        targets.append(con);
       }
     } else {
       // Was forwarded by a client ... forward to all
@@ -129,9 +132,11 @@ namespace ClientServer {
         {
           continue;
         }
-        _rpc->SendNotification(con, "CS::Broadcast", msg);
+        targets.append(con);
       }
     }
+
+    _rpc->SendNotification(targets, "CS::Broadcast", msg);
   }
 }
 }
@@ -42,7 +42,8 @@ namespace ClientServer {
       virtual ~CSBroadcast();
 
       /**
-       * Send a notification to all group members
+       * Send a notification to all group members, the message is serialized
+       * once and shared by every connection
        * @param method The Rpc to call
        * @param data Data to be sent to all members
        */
@@ -25,13 +25,27 @@ namespace ClientServer {
   }
 
   void CSForwarder::Forward(const Id &to, const QByteArray &data,
-      const QStringList &been)
+      const QList<Id> &been)
   {
     QHash<int, bool> tested;
 
     QSharedPointer<Connection> con = GetConnectionTable().GetConnection(to);
+    bool consider_group = _group_holder->GetGroup().Count() > 0;
 
     if(!con || con->GetEdge().dynamicCast<Connections::RelayEdge>()) {
+      // The group may have changed since the route was cached
+      con = GetCachedRoute(to, been);
+      if(con && consider_group &&
+          !_group_holder->GetGroup().GetSubgroup().Contains(con->GetRemoteId()))
+      {
+        con.clear();
+      }
+    } else {
+      Send(con, to, data, been);
+      return;
+    }
+
+    if(!con) {
       const QList<QSharedPointer<Connection> > cons =
         GetConnectionTable().GetConnections();
 
@@ -44,9 +58,7 @@ namespace ClientServer {
       con = cons[idx];
       tested[idx] = true;
 
-      bool consider_group = _group_holder->GetGroup().Count() > 0;
-
-      while(been.contains(con->GetRemoteId().ToString()) ||
+      while(been.contains(con->GetRemoteId()) ||
           con->GetEdge().dynamicCast<Connections::RelayEdge>() ||
           (consider_group &&
            !_group_holder->GetGroup().GetSubgroup().Contains(con->GetRemoteId())))
@@ -63,6 +75,7 @@ namespace ClientServer {
       }
     }
 
+    CacheRoute(to, con);
     Send(con, to, data, been);
   }
 }
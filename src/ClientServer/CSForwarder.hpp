@@ -1,8 +1,8 @@
 #ifndef DISSENT_CLIENT_SERVER_CSFORWARDER_H_GUARD
 #define DISSENT_CLIENT_SERVER_CSFORWARDER_H_GUARD
 
+#include <QList>
 #include <QObject>
-#include <QStringList>
 
 #include "Connections/ConnectionTable.hpp"
 #include "Connections/RelayForwarder.hpp"
@@ -57,7 +57,7 @@ namespace ClientServer {
        * Helper function for forwarding data -- does the hard work
        */
       virtual void Forward(const Id &to, const QByteArray &data,
-          const QStringList &been);
+          const QList<Id> &been);
 
       QSharedPointer<GroupHolder> _group_holder;
   };
@@ -192,9 +192,7 @@ namespace Connections {
       inline void Send(const QSharedPointer<ISender> &to,
           const QByteArray &data)
       {
-        QVariantHash msg(_headers);
-        msg["data"] = data;
-        _rpc->SendNotification(to, _method, msg);
+        _rpc->SendBinaryNotification(to, _method, _headers, data);
       }
 
       inline QSharedPointer<RpcHandler> GetRpcHandler() const
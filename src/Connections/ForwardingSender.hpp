@@ -1,8 +1,8 @@
 #ifndef DISSENT_CONNECTIONS_FORWARDING_SENDER_H_GUARD
 #define DISSENT_CONNECTIONS_FORWARDING_SENDER_H_GUARD
 
+#include <QList>
 #include <QSharedPointer>
-#include <QStringList>
 
 #include "Id.hpp"
 #include "IOverlaySender.hpp"
@@ -23,7 +23,7 @@ namespace Connections {
        */
       ForwardingSender(const QSharedPointer<RelayForwarder> &forwarder,
           const Id &from, const Id &to,
-          const QStringList &been = QStringList()) :
+          const QList<Id> &been = QList<Id>()) :
         _forwarder(forwarder),
         _from(from),
         _to(to),
@@ -56,13 +56,13 @@ namespace Connections {
        */
       virtual Id GetRemoteId() const { return _to; }
 
-      QStringList GetReverse() { return _been; }
+      QList<Id> GetReverse() { return _been; }
 
     private:
       QSharedPointer<RelayForwarder> _forwarder;
       const Id _from;
       const Id _to;
-      QStringList _been;
+      QList<Id> _been;
   };
 }
 }
@@ -1,5 +1,6 @@
 #include "Id.hpp"
 #include "Crypto/CryptoFactory.hpp"
+#include "Utils/Utils.hpp"
 #include <QDebug>
 
 using namespace Dissent::Crypto;
@@ -18,21 +19,55 @@ namespace Connections {
     QScopedPointer<Dissent::Utils::Random> rng(lib->GetRandomNumberGenerator());
     QByteArray bid(ByteSize, 0);
     rng->GenerateBlock(bid);
-    _integer = Integer(bid);
+    Set(bid);
   }
   
-  Id::Id(const QByteArray &bid) : _integer(bid)
+  Id::Id(const QByteArray &bid)
   {
+    // Anything but a full Id would silently collide with another one
+    if(bid.size() != static_cast<int>(ByteSize)) {
+      *this = Zero();
+      return;
+    }
+    Set(bid);
+  }
+
+  Id::Id(const Integer &integer)
+  {
+    Set(integer.GetByteArray());
+  }
+
+  Id::Id(const QString &sid)
+  {
+    QByteArray bid = Utils::FromUrlSafeBase64(sid.toAscii());
+    Set(bid);
+    if(bid.size() > static_cast<int>(ByteSize) || ToString() != sid) {
+      *this = Zero();
+    }
   }
 
-  Id::Id(const Integer &integer) : _integer(integer)
+  QString Id::ToString() const
   {
+    // Strings omit leading zeros as they did when Ids were Integers
+    size_t start = 0;
+    while(start + 1 < ByteSize && _id[start] == 0) {
+      start++;
+    }
+    return Utils::ToUrlSafeBase64(QByteArray(GetData() + start, ByteSize - start));
   }
 
-  Id::Id(const QString &sid) : _integer(sid)
+  void Id::Set(const QByteArray &bid)
   {
-    if(_integer.ToString() != sid) {
-      _integer = Zero()._integer;
+    int size = qMin(bid.size(), static_cast<int>(ByteSize));
+    int pad = ByteSize - size;
+    memset(_id, 0, pad);
+    memcpy(_id + pad, bid.constData() + bid.size() - size, size);
+
+    _hash = 0;
+    for(size_t idx = 0; idx < ByteSize; idx++) {
+      _hash = (_hash << 4) + _id[idx];
+      _hash ^= (_hash & 0xf0000000) >> 23;
+      _hash &= 0x0fffffff;
     }
   }
 }
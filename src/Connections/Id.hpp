@@ -1,6 +1,7 @@
 #ifndef DISSENT_CONNECTIONS_ADDRESS_H_GUARD
 #define DISSENT_CONNECTIONS_ADDRESS_H_GUARD
 
+#include <string.h>
 #include <QByteArray>
 #include <QString>
 #include "Crypto/Integer.hpp"
@@ -8,7 +9,8 @@
 namespace Dissent {
 namespace Connections {
   /**
-   * A globally unique identifier.
+   * A globally unique identifier.  Stored inline as a fixed size big endian
+   * number so that copies, comparisons, and hashing never touch the heap.
    */
   class Id {
     public:
@@ -26,7 +28,8 @@ namespace Connections {
       explicit Id();
 
       /**
-       * Create an Id using a QByteArray
+       * Create an Id using a big endian QByteArray of exactly ByteSize
+       * bytes, any other size results in Id::Zero
        */
       explicit Id(const QByteArray &bid);
 
@@ -43,34 +46,57 @@ namespace Connections {
       /**
        * Returns a printable Id string
        */
-      inline QString ToString() const { return _integer.ToString(); }
+      QString ToString() const;
 
-      inline bool operator==(const Id &other) const { return _integer == other._integer; }
-      inline bool operator!=(const Id &other) const { return _integer != other._integer; }
-      inline bool operator<(const Id &other) const { return _integer < other._integer; }
-      inline bool operator>(const Id &other) const { return _integer > other._integer; }
+      inline bool operator==(const Id &other) const
+      {
+        return _hash == other._hash && memcmp(_id, other._id, ByteSize) == 0;
+      }
+
+      inline bool operator!=(const Id &other) const { return !(*this == other); }
+      inline bool operator<(const Id &other) const { return memcmp(_id, other._id, ByteSize) < 0; }
+      inline bool operator>(const Id &other) const { return memcmp(_id, other._id, ByteSize) > 0; }
 
       /**
-       * Returns the byte array for the Id
+       * Returns the fixed size byte array for the Id
        */
-      inline const QByteArray &GetByteArray() const { return _integer.GetByteArray(); }
+      inline QByteArray GetByteArray() const
+      {
+        return QByteArray(GetData(), ByteSize);
+      }
+
+      /**
+       * Returns the ByteSize bytes of the Id
+       */
+      inline const char *GetData() const { return reinterpret_cast<const char *>(_id); }
 
       /**
        * Returns the (big) Integer for the Id
        */
-      inline const Integer &GetInteger() const { return _integer; }
+      inline Integer GetInteger() const { return Integer(GetByteArray()); }
+
+      /**
+       * Returns a hash of the Id, computed once at construction
+       */
+      inline uint GetHash() const { return _hash; }
       
     private:
-      Integer _integer;
+      /**
+       * Sets the Id from a big endian byte array and updates the hash
+       */
+      void Set(const QByteArray &bid);
+
+      unsigned char _id[ByteSize];
+      uint _hash;
   };
 
   /**
-   * Allows an Id to be used as a Key in a QHash table, uses the QByteArray qHash
+   * Allows an Id to be used as a Key in a QHash table
    * @param id the key Id
    */
   inline uint qHash(const Id &id)
   {
-    return qHash(id.GetByteArray());
+    return id.GetHash();
   }
 
   inline QDebug operator<<(QDebug dbg, const Id &id)
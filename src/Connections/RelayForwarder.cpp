@@ -1,6 +1,10 @@
+#include <string.h>
 #include <QList>
 
 #include "Messaging/Request.hpp"
+#include "Utils/Serialization.hpp"
+#include "Utils/Timer.hpp"
+#include "Utils/TimerCallback.hpp"
 
 #include "Connection.hpp"
 #include "ForwardingSender.hpp"
@@ -9,6 +13,42 @@
 
 namespace Dissent {
 namespace Connections {
+namespace {
+  using Utils::Serialization;
+
+  /**
+   * Each message in a batch: destination, hop count, reverse path length,
+   * data length, the hops, the reverse path, and the data
+   */
+  const int MessageHeaderSize = Id::ByteSize + 12;
+
+  void WriteId(const Id &id, QByteArray &data, int offset)
+  {
+    memcpy(data.data() + offset, id.GetData(), Id::ByteSize);
+  }
+
+  Id ReadId(const QByteArray &data, int offset)
+  {
+    return Id(QByteArray::fromRawData(data.constData() + offset, Id::ByteSize));
+  }
+
+  void WriteIds(const QList<Id> &ids, QByteArray &data, int offset)
+  {
+    for(int idx = 0; idx < ids.count(); idx++) {
+      WriteId(ids[idx], data, offset + idx * Id::ByteSize);
+    }
+  }
+
+  QList<Id> ReadIds(const QByteArray &data, int offset, int count)
+  {
+    QList<Id> ids;
+    for(int idx = 0; idx < count; idx++) {
+      ids.append(ReadId(data, offset + idx * Id::ByteSize));
+    }
+    return ids;
+  }
+}
+
   const Id &RelayForwarder::Preferred()
   {
     static const Id prefered = Id(QString("HJf+qfK7oZVR3dOqeUQcM8TGeVA="));
@@ -18,16 +58,17 @@ namespace Connections {
   RelayForwarder::RelayForwarder(const Id &local_id, const ConnectionTable &ct,
       const QSharedPointer<RpcHandler> &rpc) :
     _local_id(local_id),
-    _base_been(local_id.ToString()),
     _ct(ct),
     _rpc(rpc),
-    _cache(4096)
+    _cache(4096),
+    _flush_pending(false)
   {
     _rpc->Register("RF::Data", this, "IncomingData");
   }
 
   RelayForwarder::~RelayForwarder()
   {
+    _flush_event.Stop();
     _rpc->Unregister("RF::Data");
   }
 
@@ -46,7 +87,7 @@ namespace Connections {
   }
 
   void RelayForwarder::Send(const Id &to, const QByteArray &data,
-      const QStringList &been)
+      const QList<Id> &been)
   {
     if(to == _local_id) {
       _rpc->HandleData(QSharedPointer<ISender>(
@@ -54,29 +95,93 @@ namespace Connections {
       return;
     }
 
-    if(been.isEmpty() || !Reverse(to, data, QStringList(), been)) {
-      Forward(to, data, QStringList());
+    if(been.isEmpty() || !Reverse(to, data, QList<Id>(), been)) {
+      Forward(to, data, QList<Id>());
     }
   }
 
+  void RelayForwarder::AppendMessage(QByteArray &batch, const Id &to,
+      const QByteArray &data, const QList<Id> &been, const QList<Id> &reverse)
+  {
+    int offset = batch.size();
+    batch.resize(offset + MessageHeaderSize +
+        (been.count() + reverse.count()) * Id::ByteSize);
+    WriteId(to, batch, offset);
+    Serialization::WriteInt(been.count(), batch, offset + Id::ByteSize);
+    Serialization::WriteInt(reverse.count(), batch, offset + Id::ByteSize + 4);
+    Serialization::WriteInt(data.size(), batch, offset + Id::ByteSize + 8);
+    offset += MessageHeaderSize;
+    WriteIds(been, batch, offset);
+    offset += been.count() * Id::ByteSize;
+    WriteIds(reverse, batch, offset);
+    batch.append(data);
+  }
+
+  bool RelayForwarder::ReadMessage(const QByteArray &batch, int &offset,
+      Id &to, QByteArray &data, QList<Id> &been, QList<Id> &reverse)
+  {
+    if(offset < 0 || batch.size() - offset < MessageHeaderSize) {
+      qWarning() << "Received a truncated forwarded message.";
+      return false;
+    }
+
+    int been_count = Serialization::ReadInt(batch, offset + Id::ByteSize);
+    int reverse_count = Serialization::ReadInt(batch, offset + Id::ByteSize + 4);
+    int length = Serialization::ReadInt(batch, offset + Id::ByteSize + 8);
+
+    int remaining = batch.size() - offset - MessageHeaderSize;
+    if(been_count < 0 || reverse_count < 0 || length < 0 ||
+        been_count > remaining / Id::ByteSize ||
+        reverse_count > remaining / Id::ByteSize - been_count ||
+        length > remaining - (been_count + reverse_count) * Id::ByteSize)
+    {
+      qWarning() << "Received a malformed forwarded message.";
+      return false;
+    }
+
+    to = ReadId(batch, offset);
+    offset += MessageHeaderSize;
+    been = ReadIds(batch, offset, been_count);
+    offset += been_count * Id::ByteSize;
+    reverse = ReadIds(batch, offset, reverse_count);
+    offset += reverse_count * Id::ByteSize;
+    data = batch.mid(offset, length);
+    offset += length;
+    return true;
+  }
+
   void RelayForwarder::IncomingData(const Request &notification)
   {
-    QVariantHash msg = notification.GetData().toHash();
+    QByteArray batch = notification.GetData().toByteArray();
 
-    Id destination = Id(msg.value("to").toString());
+    int offset = 0;
+    while(offset < batch.size()) {
+      Id destination(Id::Zero());
+      QByteArray data;
+      QList<Id> been, reverse;
+      if(!ReadMessage(batch, offset, destination, data, been, reverse)) {
+        return;
+      }
+
+      HandleMessage(destination, data, been, reverse);
+    }
+  }
+
+  void RelayForwarder::HandleMessage(const Id &destination,
+      const QByteArray &data, const QList<Id> &been, const QList<Id> &reverse)
+  {
     if(destination == Id::Zero()) {
       qWarning() << "Received a forwarded message without a destination.";
       return;
     }
 
-    QStringList been = msg.value("been").toStringList();
     if(destination == _local_id) {
       if(been.size() == 0) {
         qWarning() << "Received a forwarded message without any history.";
         return;
       }
 
-      Id source = Id(been[0]);
+      Id source = been[0];
       if(source == Id::Zero()) {
         qWarning() << "Received a forwarded message without a valid source.";
       }
@@ -93,27 +198,24 @@ namespace Connections {
       QSharedPointer<ForwardingSender> sender(*psender);
       _cache.insert(source, psender);
 
-      _rpc->HandleData(sender, msg.value("data").toByteArray());
+      _rpc->HandleData(sender, data);
       return;
     }
 
-    QStringList reverse = msg.value("reverse").toStringList();
-    QByteArray data = msg.value("data").toByteArray();
     if(reverse.isEmpty() || !Reverse(destination, data, been, reverse)) {
       Forward(destination, data, been);
     }
   }
 
   bool RelayForwarder::Reverse(const Id &to, const QByteArray &data,
-      const QStringList &been, const QStringList &reverse)
+      const QList<Id> &been, const QList<Id> &reverse)
   {
-    if(to != Id(reverse.value(0))) {
-      qDebug() << "to and starting position are not equal" << reverse << reverse.isEmpty();
+    if(to != reverse.value(0, Id::Zero())) {
+      qDebug() << "to and starting position are not equal" << reverse.isEmpty();
     }
     QSharedPointer<Connection> con;
-    QStringList nreverse;
     for(int idx = 0; idx < reverse.count(); idx++) {
-      con = _ct.GetConnection(Id(reverse[idx]));
+      con = _ct.GetConnection(reverse[idx]);
       if(con && !con->GetEdge().dynamicCast<RelayEdge>()) {
         Send(con, to, data, been, reverse.mid(0, idx));
         return true;
@@ -124,26 +226,37 @@ namespace Connections {
   }
 
   void RelayForwarder::Forward(const Id &to, const QByteArray &data,
-      const QStringList &been)
+      const QList<Id> &been)
   {
     QHash<int, bool> tested;
 
     QSharedPointer<Connection> con = _ct.GetConnection(to);
     if(!con || (dynamic_cast<RelayEdge *>(con->GetEdge().data()) != 0)) {
-      if(!been.contains(Preferred().ToString())) {
-        con = _ct.GetConnection(Preferred());
+      con = GetCachedRoute(to, been);
+    } else {
+      Send(con, to, data, been);
+      return;
+    }
+
+    if(!con && !been.contains(Preferred())) {
+      con = _ct.GetConnection(Preferred());
+      if(con && (dynamic_cast<RelayEdge *>(con->GetEdge().data()) != 0)) {
+        con.clear();
       }
     }
 
-    if(!con || (dynamic_cast<RelayEdge *>(con->GetEdge().data()) != 0)) {
+    if(!con) {
       const QList<QSharedPointer<Connection> > cons = _ct.GetConnections();
+      if(cons.size() == 0) {
+        return;
+      }
 
       Dissent::Utils::Random &rand = Dissent::Utils::Random::GetInstance();
       int idx = rand.GetInt(0, cons.size());
       con = cons[idx];
       tested[idx] = true;
       RelayEdge *redge = dynamic_cast<RelayEdge *>(con->GetEdge().data());
-      while(been.contains(con->GetRemoteId().ToString()) || (redge != 0)) {
+      while(been.contains(con->GetRemoteId()) || (redge != 0)) {
         if(tested.size() == cons.size()) {
           qWarning() << "Packet has been to all of our connections.";
           return;
@@ -156,27 +269,102 @@ namespace Connections {
       }
     }
 
+    CacheRoute(to, con);
     Send(con, to, data, been);
   }
 
-  void RelayForwarder::Send(const QSharedPointer<Connection> &con,
-      const Id &to, const QByteArray &data, const QStringList &been,
-      const QStringList &reverse)
+  QSharedPointer<Connection> RelayForwarder::GetCachedRoute(const Id &to,
+      const QList<Id> &been)
   {
-    QVariantHash msg;
-    msg["to"] = to.ToString();
-    msg["data"] = data;
-    msg["been"] = been + _base_been;
+    QHash<Id, Id>::iterator route = _routes.find(to);
+    if(route == _routes.end()) {
+      return QSharedPointer<Connection>();
+    }
+
+    QSharedPointer<Connection> con = _ct.GetConnection(route.value());
+    if(!con || con->GetEdge().dynamicCast<RelayEdge>()) {
+      _routes.erase(route);
+      return QSharedPointer<Connection>();
+    }
 
-    if(!reverse.isEmpty()) {
-      msg["reverse"] = reverse;
+    if(been.contains(con->GetRemoteId())) {
+      return QSharedPointer<Connection>();
     }
+    return con;
+  }
+
+  void RelayForwarder::CacheRoute(const Id &to,
+      const QSharedPointer<Connection> &con)
+  {
+    _routes.insert(to, con->GetRemoteId());
+    connect(con.data(), SIGNAL(Disconnected(const QString &)),
+        this, SLOT(HandleDisconnect()), Qt::UniqueConnection);
+  }
+
+  void RelayForwarder::HandleDisconnect()
+  {
+    Connection *con = qobject_cast<Connection *>(sender());
+    if(!con) {
+      return;
+    }
+
+    const Id hop = con->GetRemoteId();
+    QHash<Id, Id>::iterator it = _routes.begin();
+    while(it != _routes.end()) {
+      if(it.value() == hop) {
+        it = _routes.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void RelayForwarder::Send(const QSharedPointer<Connection> &con,
+      const Id &to, const QByteArray &data, const QList<Id> &been,
+      const QList<Id> &reverse)
+  {
+    QList<Id> nbeen = been;
+    nbeen.append(_local_id);
 
     qDebug() << con->GetLocalId().ToString() << "Forwarding message from" <<
-      msg["been"].toStringList().value(0) << "to" << to.ToString() << "via" <<
+      nbeen[0].ToString() << "to" << to.ToString() << "via" <<
       con->GetRemoteId().ToString() << "Reverse path" << !reverse.isEmpty();
-    
-    _rpc->SendNotification(con, "RF::Data", msg);
+
+    const Id hop = con->GetRemoteId();
+    Batch &batch = _batches[hop];
+    batch.con = con;
+
+    AppendMessage(batch.data, to, data, nbeen, reverse);
+
+    if(batch.data.size() >= BatchLimit) {
+      Flush(hop);
+      return;
+    }
+
+    if(!_flush_pending) {
+      _flush_pending = true;
+      Utils::TimerCallback *cb = new Utils::TimerMethod<RelayForwarder, int>(
+          this, &RelayForwarder::FlushAll, 0);
+      _flush_event = Utils::Timer::GetInstance().QueueCallback(cb, 0);
+    }
+  }
+
+  void RelayForwarder::FlushAll(const int &)
+  {
+    _flush_pending = false;
+    foreach(const Id &hop, _batches.keys()) {
+      Flush(hop);
+    }
+  }
+
+  void RelayForwarder::Flush(const Id &hop)
+  {
+    Batch batch = _batches.take(hop);
+    if(batch.data.isEmpty()) {
+      return;
+    }
+
+    _rpc->SendBinaryNotification(batch.con, "RF::Data", batch.data);
   }
 }
 }
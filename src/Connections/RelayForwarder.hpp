@@ -2,11 +2,13 @@
 #define DISSENT_CONNECTIONS_RELAY_FORWARDER_H_GUARD
 
 #include <QCache>
+#include <QHash>
+#include <QList>
 #include <QObject>
-#include <QStringList>
 
 #include "Messaging/ISender.hpp"
 #include "Messaging/RpcHandler.hpp"
+#include "Utils/TimerEvent.hpp"
 
 #include "ConnectionTable.hpp"
 
@@ -20,7 +22,10 @@ namespace Connections {
   class ForwardingSender;
 
   /**
-   * Does the hard work in forwarding packets over the overlay
+   * Does the hard work in forwarding packets over the overlay.  Forwarded
+   * messages carry a binary header of fixed size ids: the destination, the
+   * hops taken so far, and optionally a reverse path.  Messages headed to
+   * the same next hop during one event are sent together as a batch.
    */
   class RelayForwarder : public QObject {
     Q_OBJECT
@@ -30,6 +35,12 @@ namespace Connections {
       typedef Messaging::Request Request;
       typedef Messaging::RpcHandler RpcHandler;
 
+      /**
+       * A pending batch is sent once it reaches this many bytes rather than
+       * waiting for the end of the event
+       */
+      static const int BatchLimit = 64 * 1024;
+
       static QSharedPointer<RelayForwarder> Get(const Id &local_id,
           const ConnectionTable &ct, const QSharedPointer<RpcHandler> &rpc)
       {
@@ -52,13 +63,43 @@ namespace Connections {
        * The forwarding sender should call this to forward a message along
        */
       virtual void Send(const Id &to, const QByteArray &data,
-          const QStringList &been = QStringList());
+          const QList<Id> &been = QList<Id>());
 
       QSharedPointer<RelayForwarder> GetSharedPointer()
       {
          return _shared.toStrongRef();
       }
 
+      /**
+       * Returns the number of destinations with a cached next hop
+       */
+      int GetCachedRouteCount() const { return _routes.count(); }
+
+      /**
+       * Appends a message in the RF::Data format to a batch
+       * @param batch the batch
+       * @param to the destination
+       * @param data the message
+       * @param been the hops taken so far
+       * @param reverse the reverse path
+       */
+      static void AppendMessage(QByteArray &batch, const Id &to,
+          const QByteArray &data, const QList<Id> &been,
+          const QList<Id> &reverse);
+
+      /**
+       * Parses the message at an offset in a RF::Data batch
+       * @param batch the batch
+       * @param offset the start of the message, advanced past it
+       * @param to set to the destination
+       * @param data set to the message
+       * @param been set to the hops taken so far
+       * @param reverse set to the reverse path
+       * @returns false if the message is truncated or malformed
+       */
+      static bool ReadMessage(const QByteArray &batch, int &offset, Id &to,
+          QByteArray &data, QList<Id> &been, QList<Id> &reverse);
+
     protected:
       /**
        * Constructor
@@ -68,44 +109,98 @@ namespace Connections {
        */
       RelayForwarder(const Id &local_id, const ConnectionTable &ct,
           const QSharedPointer<RpcHandler> &rpc);
-  
+
       void SetSharedPointer(const QSharedPointer<RelayForwarder> &shared)
       {
         _shared = shared.toWeakRef();
       }
 
+      /**
+       * Queues a message into the batch for a next hop
+       */
       void Send(const QSharedPointer<Connection> &con, const Id &to,
-          const QByteArray &data, const QStringList &been,
-          const QStringList &reverse = QStringList());
+          const QByteArray &data, const QList<Id> &been,
+          const QList<Id> &reverse = QList<Id>());
 
-      const ConnectionTable &GetConnectionTable() const { return _ct; }
+      /**
+       * Returns the cached next hop towards a destination, if it is still
+       * connected, directly attached, and not yet visited
+       * @param to the destination
+       * @param been the hops taken so far
+       */
+      QSharedPointer<Connection> GetCachedRoute(const Id &to,
+          const QList<Id> &been);
+
+      /**
+       * Remembers the next hop chosen for a destination until the
+       * connection to that hop closes
+       * @param to the destination
+       * @param con the next hop
+       */
+      void CacheRoute(const Id &to, const QSharedPointer<Connection> &con);
 
-      const QStringList GetBaseBeen() const { return _base_been; }
+      const ConnectionTable &GetConnectionTable() const { return _ct; }
 
     private:
+      /**
+       * Messages bound for a single next hop
+       */
+      class Batch {
+        public:
+          QSharedPointer<Connection> con;
+          QByteArray data;
+      };
+
       /**
        * Helper function for forwarding data -- does the hard work
        */
       virtual void Forward(const Id &to, const QByteArray &data,
-          const QStringList &been);
+          const QList<Id> &been);
 
       virtual bool Reverse(const Id &to, const QByteArray &data,
-          const QStringList &been, const QStringList &reverse);
+          const QList<Id> &been, const QList<Id> &reverse);
+
+      /**
+       * Delivers or forwards a single message from a batch
+       */
+      void HandleMessage(const Id &to, const QByteArray &data,
+          const QList<Id> &been, const QList<Id> &reverse);
+
+      /**
+       * Sends all pending batches
+       */
+      void FlushAll(const int &);
+
+      /**
+       * Sends the pending batch for a next hop
+       */
+      void Flush(const Id &hop);
 
       const Id _local_id;
-      const QStringList _base_been;
       const ConnectionTable &_ct;
       QSharedPointer<RpcHandler> _rpc;
       static const Id &Preferred();
       QWeakPointer<RelayForwarder> _shared;
       QCache<Id, QSharedPointer<ForwardingSender> > _cache;
-      
+
+      /**
+       * destination -> next hop
+       */
+      QHash<Id, Id> _routes;
+      QHash<Id, Batch> _batches;
+      Utils::TimerEvent _flush_event;
+      bool _flush_pending;
+
     private slots:
       /**
        * Incoming data for forwarding
        */
       virtual void IncomingData(const Request &notification);
 
+      /**
+       * Drops the routes through a closed connection
+       */
+      void HandleDisconnect();
   };
 }
 }
@@ -1,10 +1,12 @@
 #ifndef DISSENT_CRYPTO_ABSTRACT_GROUP_ABSTRACT_GROUP_H_GUARD
 #define DISSENT_CRYPTO_ABSTRACT_GROUP_ABSTRACT_GROUP_H_GUARD
 
+#include <QList>
 #include <QString>
 
 #include "Crypto/Integer.hpp"
 #include "Element.hpp"
+#include "FixedBase.hpp"
 
 namespace Dissent {
 namespace Crypto {
@@ -75,6 +77,52 @@ namespace AbstractGroup {
       virtual Element CascadeExponentiate(const Element &a1, const Integer &e1,
           const Element &a2, const Integer &e2) const = 0;
 
+      /**
+       * Compute (bases[0]^exps[0] * ... * bases[n-1]^exps[n-1]).  Groups
+       * should override this with a method sharing work across the terms,
+       * by default terms are paired up with CascadeExponentiate.
+       * @param bases the bases
+       * @param exps the exponents, one per base
+       */
+      virtual Element MultiExponentiate(const QList<Element> &bases,
+          const QList<Integer> &exps) const
+      {
+        Q_ASSERT(bases.count() == exps.count());
+        Element res = GetIdentity();
+        int idx = 0;
+        for(; idx + 1 < bases.count(); idx += 2) {
+          res = Multiply(res, CascadeExponentiate(bases[idx], exps[idx],
+                bases[idx + 1], exps[idx + 1]));
+        }
+        if(idx < bases.count()) {
+          res = Multiply(res, Exponentiate(bases[idx], exps[idx]));
+        }
+        return res;
+      }
+
+      /**
+       * Precompute a table for an element that will be exponentiated many
+       * times, such as a long-lived public key.  Exponentiations of the
+       * generator use such a table internally.  By default, no table is
+       * built.
+       * @param base the element to precompute
+       */
+      virtual FixedBase PrecomputeFixedBase(const Element &base) const
+      {
+        return FixedBase(base);
+      }
+
+      /**
+       * Compute base^exp using the table from PrecomputeFixedBase
+       * @param base the precomputed base
+       * @param exp exponent
+       */
+      virtual Element FixedBaseExponentiate(const FixedBase &base,
+          const Integer &exp) const
+      {
+        return Exponentiate(base.GetElement(), exp);
+      }
+
       /**
        * Compute b such that ab is the group identity
        * @param a element to invert
@@ -1,15 +1,37 @@
 
+#include <QVector>
+
 #include "BotanECElementData.hpp"
 #include "BotanECGroup.hpp"
+#include "MultiExponentiation.hpp"
 
 namespace Dissent {
 namespace Crypto {
 namespace AbstractGroup {
+namespace {
+  class BotanECOps {
+    public:
+      explicit BotanECOps(const Botan::CurveGFp &curve) : _curve(curve) {}
+
+      Botan::PointGFp Multiply(const Botan::PointGFp &a,
+          const Botan::PointGFp &b) const
+      {
+        return a + b;
+      }
+
+      Botan::PointGFp Square(const Botan::PointGFp &a) const { return a + a; }
+      Botan::PointGFp Identity() const { return Botan::PointGFp(_curve); }
+
+    private:
+      const Botan::CurveGFp &_curve;
+  };
+}
 
   BotanECGroup::BotanECGroup(Integer p, Integer q, Integer a, Integer b, Integer gx, Integer gy) :
       _curve(ToBotanInt(p), ToBotanInt(a), ToBotanInt(b)),
       _q(q),
       _g(_curve, ToBotanInt(gx), ToBotanInt(gy)),
+      _g_table(new GeneratorTable<Botan::PointGFp>()),
       _field_bytes(p.GetByteArray().count())
     {
       /*
@@ -27,6 +49,7 @@ namespace AbstractGroup {
     _curve(other._curve.get_p(), other._curve.get_a(), other._curve.get_b()),
     _q(other._q),
     _g(_curve, other._g.get_affine_x(), other._g.get_affine_y()),
+    _g_table(other._g_table),
     _field_bytes(other._field_bytes)
   {
   }
@@ -52,7 +75,14 @@ namespace AbstractGroup {
 
   Element BotanECGroup::Exponentiate(const Element &a, const Integer &exp) const
   {
-    return Element(new BotanECElementData(ToBotanInt(exp) * GetPoint(a)));
+    const Botan::PointGFp point = GetPoint(a);
+    Botan::PointGFp res(_curve);
+    if(point == _g && _g_table->Get(_g, _q.GetBitCount(), BotanECOps(_curve))->
+        Exponentiate(exp, BotanECOps(_curve), res))
+    {
+      return Element(new BotanECElementData(res));
+    }
+    return Element(new BotanECElementData(ToBotanInt(exp) * point));
   }
   
   Element BotanECGroup::CascadeExponentiate(const Element &a1, const Integer &e1,
@@ -63,6 +93,44 @@ namespace AbstractGroup {
                             GetPoint(a2), ToBotanInt(e2))));
   }
 
+  Element BotanECGroup::MultiExponentiate(const QList<Element> &bases,
+      const QList<Integer> &exps) const
+  {
+    Q_ASSERT(bases.count() == exps.count());
+    if(bases.count() < 3) {
+      return AbstractGroup::MultiExponentiate(bases, exps);
+    }
+
+    QVector<Botan::PointGFp> points(bases.count());
+    QVector<Integer> iexps(exps.count());
+    for(int idx = 0; idx < bases.count(); idx++) {
+      points[idx] = GetPoint(bases[idx]);
+      iexps[idx] = MultiExponentiation::Normalize(exps[idx], _q);
+    }
+
+    return Element(new BotanECElementData(
+          MultiExponentiation::Compute(points, iexps, BotanECOps(_curve))));
+  }
+
+  FixedBase BotanECGroup::PrecomputeFixedBase(const Element &base) const
+  {
+    return FixedBase(base, QSharedPointer<const FixedBaseData>(
+          new FixedBaseTable<Botan::PointGFp>(GetPoint(base),
+            _q.GetBitCount(), BotanECOps(_curve))));
+  }
+
+  Element BotanECGroup::FixedBaseExponentiate(const FixedBase &base,
+      const Integer &exp) const
+  {
+    const FixedBaseTable<Botan::PointGFp> *table =
+      dynamic_cast<const FixedBaseTable<Botan::PointGFp> *>(base.GetData());
+    Botan::PointGFp res(_curve);
+    if(table && table->Exponentiate(exp, BotanECOps(_curve), res)) {
+      return Element(new BotanECElementData(res));
+    }
+    return Exponentiate(base.GetElement(), exp);
+  }
+
   Element BotanECGroup::Inverse(const Element &a) const
   {
     return Element(new BotanECElementData(GetPoint(a).negate()));
@@ -1,17 +1,43 @@
 
 #include <cryptopp/nbtheory.h>
 
+#include <QVector>
+
 #include "CppECElementData.hpp"
 #include "CppECGroup.hpp"
+#include "MultiExponentiation.hpp"
 
 namespace Dissent {
 namespace Crypto {
 namespace AbstractGroup {
+namespace {
+  class CppECOps {
+    public:
+      explicit CppECOps(const CryptoPP::ECP &curve) : _curve(curve) {}
+
+      CryptoPP::ECPPoint Multiply(const CryptoPP::ECPPoint &a,
+          const CryptoPP::ECPPoint &b) const
+      {
+        return _curve.Add(a, b);
+      }
+
+      CryptoPP::ECPPoint Square(const CryptoPP::ECPPoint &a) const
+      {
+        return _curve.Double(a);
+      }
+
+      CryptoPP::ECPPoint Identity() const { return _curve.Identity(); }
+
+    private:
+      const CryptoPP::ECP &_curve;
+  };
+}
 
   CppECGroup::CppECGroup(Integer p, Integer q, Integer a, Integer b, Integer gx, Integer gy) :
       _curve(ToCryptoInt(p), ToCryptoInt(a), ToCryptoInt(b)),
       _q(q),
       _g(ToCryptoInt(gx), ToCryptoInt(gy)),
+      _g_table(new GeneratorTable<CryptoPP::ECPPoint>()),
       _field_bytes(p.GetByteArray().count())
     {
       /*
@@ -46,7 +72,14 @@ namespace AbstractGroup {
 
   Element CppECGroup::Exponentiate(const Element &a, const Integer &exp) const
   {
-    return Element(new CppECElementData(_curve.Multiply(ToCryptoInt(exp), GetPoint(a))));
+    const CryptoPP::ECPPoint point = GetPoint(a);
+    CryptoPP::ECPPoint res;
+    if(point == _g && _g_table->Get(_g, _q.GetBitCount(), CppECOps(_curve))->
+        Exponentiate(exp, CppECOps(_curve), res))
+    {
+      return Element(new CppECElementData(res));
+    }
+    return Element(new CppECElementData(_curve.Multiply(ToCryptoInt(exp), point)));
   }
   
   Element CppECGroup::CascadeExponentiate(const Element &a1, const Integer &e1,
@@ -66,6 +99,44 @@ namespace AbstractGroup {
     
   }
 
+  Element CppECGroup::MultiExponentiate(const QList<Element> &bases,
+      const QList<Integer> &exps) const
+  {
+    Q_ASSERT(bases.count() == exps.count());
+    if(bases.count() < 3) {
+      return AbstractGroup::MultiExponentiate(bases, exps);
+    }
+
+    QVector<CryptoPP::ECPPoint> points(bases.count());
+    QVector<Integer> iexps(exps.count());
+    for(int idx = 0; idx < bases.count(); idx++) {
+      points[idx] = GetPoint(bases[idx]);
+      iexps[idx] = MultiExponentiation::Normalize(exps[idx], _q);
+    }
+
+    return Element(new CppECElementData(
+          MultiExponentiation::Compute(points, iexps, CppECOps(_curve))));
+  }
+
+  FixedBase CppECGroup::PrecomputeFixedBase(const Element &base) const
+  {
+    return FixedBase(base, QSharedPointer<const FixedBaseData>(
+          new FixedBaseTable<CryptoPP::ECPPoint>(GetPoint(base),
+            _q.GetBitCount(), CppECOps(_curve))));
+  }
+
+  Element CppECGroup::FixedBaseExponentiate(const FixedBase &base,
+      const Integer &exp) const
+  {
+    const FixedBaseTable<CryptoPP::ECPPoint> *table =
+      dynamic_cast<const FixedBaseTable<CryptoPP::ECPPoint> *>(base.GetData());
+    CryptoPP::ECPPoint res;
+    if(table && table->Exponentiate(exp, CppECOps(_curve), res)) {
+      return Element(new CppECElementData(res));
+    }
+    return Exponentiate(base.GetElement(), exp);
+  }
+
   Element CppECGroup::Inverse(const Element &a) const
   {
     return Element(new CppECElementData(_curve.Inverse(GetPoint(a))));
@@ -0,0 +1,178 @@
+#ifndef DISSENT_CRYPTO_ABSTRACT_GROUP_FIXED_BASE_H_GUARD
+#define DISSENT_CRYPTO_ABSTRACT_GROUP_FIXED_BASE_H_GUARD
+
+#include <QByteArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "Crypto/Integer.hpp"
+#include "Element.hpp"
+#include "MultiExponentiation.hpp"
+
+namespace Dissent {
+namespace Crypto {
+namespace AbstractGroup {
+
+  /**
+   * Group specific precomputation for a FixedBase
+   */
+  class FixedBaseData {
+    public:
+      virtual ~FixedBaseData() {}
+  };
+
+  /**
+   * A base element along with precomputed data that speeds up repeated
+   * exponentiations of that element, see AbstractGroup::PrecomputeFixedBase.
+   */
+  class FixedBase {
+    public:
+      /**
+       * Constructor - NULL base
+       */
+      FixedBase() {}
+
+      /**
+       * Constructor
+       * @param base the element being exponentiated
+       * @param data group specific precomputation, NULL if there is none
+       */
+      explicit FixedBase(const Element &base,
+          const QSharedPointer<const FixedBaseData> &data =
+            QSharedPointer<const FixedBaseData>()) :
+        _base(base),
+        _data(data)
+      {
+      }
+
+      /**
+       * Returns the base element
+       */
+      inline Element GetElement() const { return _base; }
+
+      /**
+       * Returns the group specific precomputation or NULL
+       */
+      inline const FixedBaseData *GetData() const { return _data.data(); }
+
+    private:
+      Element _base;
+      QSharedPointer<const FixedBaseData> _data;
+  };
+
+  /**
+   * A fixed-window table for a group without a native fixed-base method.
+   * Row w holds base^(d * 2^(w * Width)) for d in [1, 2^Width), so base^e
+   * costs one multiplication per non-zero window of e and no squarings.
+   * See MultiExponentiation for the Ops interface.
+   */
+  template<typename T> class FixedBaseTable : public FixedBaseData {
+    public:
+      static const int Width = 4;
+
+      /**
+       * Constructor
+       * @param base the base
+       * @param bits the largest exponent handled, generally the bit count of
+       * the group order
+       * @param ops the group operations
+       */
+      template<typename Ops> FixedBaseTable(const T &base, int bits,
+          const Ops &ops) :
+        _bits(bits)
+      {
+        const int entries = (1 << Width) - 1;
+        const int windows = (bits + Width - 1) / Width;
+
+        _table.resize(windows);
+        T current = base;
+        for(int window = 0; window < windows; window++) {
+          QVector<T> &row = _table[window];
+          row.resize(entries);
+          row[0] = current;
+          for(int digit = 1; digit < entries; digit++) {
+            row[digit] = ops.Multiply(row[digit - 1], current);
+          }
+          current = ops.Multiply(row[entries - 1], current);
+        }
+      }
+
+      virtual ~FixedBaseTable() {}
+
+      /**
+       * Returns the largest exponent the table handles
+       */
+      inline int GetBitCount() const { return _bits; }
+
+      /**
+       * Computes base^exp
+       * @param exp the exponent
+       * @param ops the group operations
+       * @param out set to base^exp
+       * @returns false if exp is negative or larger than the table
+       */
+      template<typename Ops> bool Exponentiate(const Integer &exp,
+          const Ops &ops, T &out) const
+      {
+        if(exp < 0 || exp.GetBitCount() > _bits) {
+          return false;
+        }
+
+        const QByteArray bytes = exp.GetByteArray();
+        bool have_out = false;
+        for(int window = 0; window < _table.count(); window++) {
+          int digit = MultiExponentiation::GetWindow(bytes,
+              window * Width, Width);
+          if(!digit) {
+            continue;
+          }
+          out = have_out ? ops.Multiply(out, _table[window][digit - 1]) :
+            _table[window][digit - 1];
+          have_out = true;
+        }
+
+        if(!have_out) {
+          out = ops.Identity();
+        }
+        return true;
+      }
+
+    private:
+      int _bits;
+      QVector<QVector<T> > _table;
+  };
+
+  /**
+   * Builds a group's generator table on first use and shares it with
+   * copies of the group, which may run on different threads.
+   */
+  template<typename T> class GeneratorTable {
+    public:
+      /**
+       * Returns the table, building it if necessary
+       * @param generator the group generator
+       * @param bits the bit count of the group order
+       * @param ops the group operations
+       */
+      template<typename Ops> QSharedPointer<const FixedBaseTable<T> > Get(
+          const T &generator, int bits, const Ops &ops)
+      {
+        QMutexLocker locker(&_lock);
+        if(!_table) {
+          _table = QSharedPointer<const FixedBaseTable<T> >(
+              new FixedBaseTable<T>(generator, bits, ops));
+        }
+        return _table;
+      }
+
+    private:
+      QMutex _lock;
+      QSharedPointer<const FixedBaseTable<T> > _table;
+  };
+}
+}
+}
+
+#endif
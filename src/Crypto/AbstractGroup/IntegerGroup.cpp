@@ -1,21 +1,43 @@
 
+#include <QVector>
+
 #include "IntegerElementData.hpp"
 #include "IntegerGroup.hpp"
+#include "MultiExponentiation.hpp"
 
 namespace Dissent {
 namespace Crypto {
 namespace AbstractGroup {
+namespace {
+  class IntegerOps {
+    public:
+      explicit IntegerOps(const Integer &p) : _p(p) {}
+
+      Integer Multiply(const Integer &a, const Integer &b) const
+      {
+        return a.MultiplyMod(b, _p);
+      }
+
+      Integer Square(const Integer &a) const { return a.MultiplyMod(a, _p); }
+      Integer Identity() const { return Integer(1); }
+
+    private:
+      const Integer &_p;
+  };
+}
 
   IntegerGroup::IntegerGroup(Integer p, Integer g) :
       _p(p), 
       _g(g),
-      _q((p-1)/2)
+      _q((p-1)/2),
+      _g_table(new GeneratorTable<Integer>())
     {};
 
   IntegerGroup::IntegerGroup(const char *p_bytes, const char *g_bytes) :
     _p(QByteArray::fromHex(p_bytes)),
     _g(QByteArray::fromHex(g_bytes)),
-    _q((_p-1)/2)
+    _q((_p-1)/2),
+    _g_table(new GeneratorTable<Integer>())
   {
     Q_ASSERT(_p>0);
     Q_ASSERT(_q>0);
@@ -177,7 +199,14 @@ namespace AbstractGroup {
 
   Element IntegerGroup::Exponentiate(const Element &a, const Integer &exp) const
   {
-    return Element(new IntegerElementData(GetInteger(a).Pow(exp, _p))); 
+    const Integer base = GetInteger(a);
+    Integer res;
+    if(base == _g && _g_table->Get(_g, _q.GetBitCount(), IntegerOps(_p))->
+        Exponentiate(exp, IntegerOps(_p), res))
+    {
+      return Element(new IntegerElementData(res));
+    }
+    return Element(new IntegerElementData(base.Pow(exp, _p))); 
   }
   
   Element IntegerGroup::CascadeExponentiate(const Element &a1, const Integer &e1,
@@ -187,6 +216,44 @@ namespace AbstractGroup {
           _p.PowCascade(GetInteger(a1), e1, GetInteger(a2), e2)));
   }
 
+  Element IntegerGroup::MultiExponentiate(const QList<Element> &bases,
+      const QList<Integer> &exps) const
+  {
+    Q_ASSERT(bases.count() == exps.count());
+    if(bases.count() < 3) {
+      return AbstractGroup::MultiExponentiate(bases, exps);
+    }
+
+    QVector<Integer> ibases(bases.count());
+    QVector<Integer> iexps(exps.count());
+    for(int idx = 0; idx < bases.count(); idx++) {
+      ibases[idx] = GetInteger(bases[idx]);
+      iexps[idx] = MultiExponentiation::Normalize(exps[idx], _q);
+    }
+
+    return Element(new IntegerElementData(
+          MultiExponentiation::Compute(ibases, iexps, IntegerOps(_p))));
+  }
+
+  FixedBase IntegerGroup::PrecomputeFixedBase(const Element &base) const
+  {
+    return FixedBase(base, QSharedPointer<const FixedBaseData>(
+          new FixedBaseTable<Integer>(GetInteger(base), _q.GetBitCount(),
+            IntegerOps(_p))));
+  }
+
+  Element IntegerGroup::FixedBaseExponentiate(const FixedBase &base,
+      const Integer &exp) const
+  {
+    const FixedBaseTable<Integer> *table =
+      dynamic_cast<const FixedBaseTable<Integer> *>(base.GetData());
+    Integer res;
+    if(table && table->Exponentiate(exp, IntegerOps(_p), res)) {
+      return Element(new IntegerElementData(res));
+    }
+    return Exponentiate(base.GetElement(), exp);
+  }
+
   Element IntegerGroup::Inverse(const Element &a) const
   {
     return Element(new IntegerElementData(GetInteger(a).ModInverse(_p)));
@@ -219,7 +286,7 @@ namespace AbstractGroup {
 
   Element IntegerGroup::RandomElement() const
   {
-    return Element(new IntegerElementData(_g.Pow(RandomExponent(), _p)));
+    return Exponentiate(GetGenerator(), RandomExponent());
   }
 
   Integer IntegerGroup::GetInteger(const Element &e) const
@@ -86,6 +86,29 @@ namespace AbstractGroup {
       virtual Element CascadeExponentiate(const Element &a1, const Integer &e1,
           const Element &a2, const Integer &e2) const;
 
+      /**
+       * Compute (bases[0]^exps[0] * ... * bases[n-1]^exps[n-1]) with a
+       * Straus or Pippenger multi-exponentiation
+       * @param bases the bases
+       * @param exps the exponents, one per base
+       */
+      virtual Element MultiExponentiate(const QList<Element> &bases,
+          const QList<Integer> &exps) const;
+
+      /**
+       * Precompute a fixed-window table of powers of base
+       * @param base the element to precompute
+       */
+      virtual FixedBase PrecomputeFixedBase(const Element &base) const;
+
+      /**
+       * Compute base^exp using the table from PrecomputeFixedBase
+       * @param base the precomputed base
+       * @param exp exponent
+       */
+      virtual Element FixedBaseExponentiate(const FixedBase &base,
+          const Integer &exp) const;
+
       /**
        * Compute b such that ab = 1
        * @param a element to invert
@@ -234,6 +257,11 @@ namespace AbstractGroup {
        */
       Integer _q;
 
+      /**
+       * Powers of _g, built on first use
+       */
+      QSharedPointer<GeneratorTable<Integer> > _g_table;
+
   };
 
 }
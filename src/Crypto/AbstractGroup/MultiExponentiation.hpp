@@ -0,0 +1,206 @@
+#ifndef DISSENT_CRYPTO_ABSTRACT_GROUP_MULTI_EXPONENTIATION_H_GUARD
+#define DISSENT_CRYPTO_ABSTRACT_GROUP_MULTI_EXPONENTIATION_H_GUARD
+
+#include <QByteArray>
+#include <QVector>
+
+#include "Crypto/Integer.hpp"
+
+namespace Dissent {
+namespace Crypto {
+namespace AbstractGroup {
+
+  /**
+   * Computes prod(bases[i]^exps[i]) for groups that do not provide a
+   * native multi-exponentiation.  The group is described by an Ops object
+   * providing:
+   *   T Ops::Multiply(const T &a, const T &b) const
+   *   T Ops::Square(const T &a) const
+   *   T Ops::Identity() const
+   *
+   * Few terms use Straus' interleaved fixed-window method, which shares
+   * the squarings across all bases.  Many terms use Pippenger's bucket
+   * method, which additionally avoids a per-base table.  Exponents must
+   * be non-negative, i.e., reduced modulo the group order.
+   */
+  class MultiExponentiation {
+    public:
+      /**
+       * Number of terms at which Pippenger's method replaces Straus'
+       */
+      static const int PippengerThreshold = 32;
+
+      /**
+       * Maps a possibly negative exponent into [0, order)
+       * @param exp the exponent
+       * @param order the group order
+       */
+      static Integer Normalize(const Integer &exp, const Integer &order)
+      {
+        if(exp >= 0) {
+          return exp;
+        }
+        Integer res = exp % order;
+        return (res < 0) ? res + order : res;
+      }
+
+      /**
+       * Returns prod(bases[i]^exps[i])
+       * @param bases the bases
+       * @param exps the non-negative exponents, one per base
+       * @param ops the group operations
+       */
+      template<typename T, typename Ops> static T Compute(
+          const QVector<T> &bases, const QVector<Integer> &exps,
+          const Ops &ops)
+      {
+        Q_ASSERT(bases.count() == exps.count());
+
+        QVector<QByteArray> bytes(exps.count());
+        int bits = 0;
+        for(int idx = 0; idx < exps.count(); idx++) {
+          Q_ASSERT(exps[idx] >= 0);
+          bytes[idx] = exps[idx].GetByteArray();
+          bits = qMax(bits, exps[idx].GetBitCount());
+        }
+
+        if(bases.count() < PippengerThreshold) {
+          return Straus(bases, bytes, bits, ops);
+        }
+        return Pippenger(bases, bytes, bits, ops);
+      }
+
+      /**
+       * Returns bits [bit, bit + width) of a big-endian magnitude, such as
+       * Integer::GetByteArray() of a non-negative Integer
+       */
+      static int GetWindow(const QByteArray &exp, int bit, int width)
+      {
+        int value = 0;
+        for(int idx = 0; idx < width; idx++) {
+          int cbit = bit + idx;
+          int byte_idx = exp.size() - 1 - (cbit / 8);
+          if(byte_idx < 0) {
+            break;
+          }
+          if((static_cast<unsigned char>(exp[byte_idx]) >> (cbit % 8)) & 1) {
+            value |= (1 << idx);
+          }
+        }
+        return value;
+      }
+
+    private:
+      static const int StrausWindow = 4;
+
+      /**
+       * Raises acc to 2^width, unless acc is the identity
+       */
+      template<typename T, typename Ops> static void Shift(T &acc,
+          bool &have_acc, int width, const Ops &ops)
+      {
+        if(!have_acc) {
+          return;
+        }
+        for(int idx = 0; idx < width; idx++) {
+          acc = ops.Square(acc);
+        }
+      }
+
+      template<typename T, typename Ops> static void Accumulate(T &acc,
+          bool &have_acc, const T &value, const Ops &ops)
+      {
+        acc = have_acc ? ops.Multiply(acc, value) : value;
+        have_acc = true;
+      }
+
+      template<typename T, typename Ops> static T Straus(
+          const QVector<T> &bases, const QVector<QByteArray> &exps,
+          int bits, const Ops &ops)
+      {
+        const int width = StrausWindow;
+        const int table_size = (1 << width);
+
+        // table[i][d] = bases[i]^d for d in [1, 2^w)
+        QVector<QVector<T> > table(bases.count());
+        for(int idx = 0; idx < bases.count(); idx++) {
+          table[idx].resize(table_size);
+          table[idx][1] = bases[idx];
+          for(int d = 2; d < table_size; d++) {
+            table[idx][d] = ops.Multiply(table[idx][d - 1], bases[idx]);
+          }
+        }
+
+        T acc = ops.Identity();
+        bool have_acc = false;
+        int windows = (bits + width - 1) / width;
+        for(int window = windows - 1; window >= 0; window--) {
+          Shift(acc, have_acc, width, ops);
+          for(int idx = 0; idx < bases.count(); idx++) {
+            int digit = GetWindow(exps[idx], window * width, width);
+            if(digit) {
+              Accumulate(acc, have_acc, table[idx][digit], ops);
+            }
+          }
+        }
+
+        return have_acc ? acc : ops.Identity();
+      }
+
+      template<typename T, typename Ops> static T Pippenger(
+          const QVector<T> &bases, const QVector<QByteArray> &exps,
+          int bits, const Ops &ops)
+      {
+        // Window size roughly log2(n) balances bucket filling against
+        // bucket summing
+        int width = 1;
+        while((2 << width) <= bases.count()) {
+          width++;
+        }
+        width = qMax(2, width - 1);
+        const int bucket_count = (1 << width);
+
+        T acc = ops.Identity();
+        bool have_acc = false;
+        int windows = (bits + width - 1) / width;
+        for(int window = windows - 1; window >= 0; window--) {
+          Shift(acc, have_acc, width, ops);
+
+          QVector<T> buckets(bucket_count);
+          QVector<bool> have_bucket(bucket_count, false);
+          for(int idx = 0; idx < bases.count(); idx++) {
+            int digit = GetWindow(exps[idx], window * width, width);
+            if(digit) {
+              bool have = have_bucket[digit];
+              Accumulate(buckets[digit], have, bases[idx], ops);
+              have_bucket[digit] = have;
+            }
+          }
+
+          // sum_{d} buckets[d]^d via running products
+          T running = ops.Identity();
+          bool have_running = false;
+          T total = ops.Identity();
+          bool have_total = false;
+          for(int digit = bucket_count - 1; digit > 0; digit--) {
+            if(have_bucket[digit]) {
+              Accumulate(running, have_running, buckets[digit], ops);
+            }
+            if(have_running) {
+              Accumulate(total, have_total, running, ops);
+            }
+          }
+
+          if(have_total) {
+            Accumulate(acc, have_acc, total, ops);
+          }
+        }
+
+        return have_acc ? acc : ops.Identity();
+      }
+  };
+}
+}
+}
+
+#endif
@@ -1,9 +1,24 @@
+#include <QVector>
+
 #include "OpenECElementData.hpp"
 #include "OpenECGroup.hpp"
 
 namespace Dissent {
 namespace Crypto {
 namespace AbstractGroup {
+namespace {
+  /**
+   * A copy of the curve using the fixed base as its generator, so that
+   * EC_GROUP_precompute_mult covers the fixed base
+   */
+  class OpenECFixedBaseData : public FixedBaseData {
+    public:
+      explicit OpenECFixedBaseData(EC_GROUP *group) : group(group) {}
+      virtual ~OpenECFixedBaseData() { EC_GROUP_clear_free(group); }
+
+      EC_GROUP *group;
+  };
+}
 
   OpenECGroup::OpenECGroup(BIGNUM *p, BIGNUM *q, BIGNUM *a, 
       BIGNUM *b, BIGNUM *gx, BIGNUM *gy, bool is_nist_curve) :
@@ -143,7 +158,13 @@ namespace AbstractGroup {
     ps[0] = GetPoint(a);
     ms[0] = tmp;
 
-    CHECK_CALL(EC_POINTs_mul(_data->group, r, _zero, 1, ps, ms, _data->ctx));
+    // The generator's multiples were precomputed in the constructor,
+    // but OpenSSL only uses them for the generator scalar
+    if(!EC_POINT_cmp(_data->group, ps[0], _generator, _data->ctx)) {
+      CHECK_CALL(EC_POINT_mul(_data->group, r, tmp, NULL, NULL, _data->ctx));
+    } else {
+      CHECK_CALL(EC_POINTs_mul(_data->group, r, _zero, 1, ps, ms, _data->ctx));
+    }
 
     BN_clear_free(tmp);
 
@@ -177,6 +198,72 @@ namespace AbstractGroup {
     return NewElement(r);
   }
 
+  Element OpenECGroup::MultiExponentiate(const QList<Element> &bases,
+      const QList<Integer> &exps) const
+  {
+    Q_ASSERT(bases.count() == exps.count());
+    const int count = bases.count();
+
+    EC_POINT *r = EC_POINT_new(_data->group);
+    CHECK_CALL(r);
+
+    QVector<const EC_POINT *> ps(count);
+    QVector<const BIGNUM *> ms(count);
+    QVector<BIGNUM *> tmps(count);
+
+    for(int idx = 0; idx < count; idx++) {
+      tmps[idx] = BN_new();
+      GetInteger(tmps[idx], exps[idx]);
+      ps[idx] = GetPoint(bases[idx]);
+      ms[idx] = tmps[idx];
+    }
+
+    CHECK_CALL(EC_POINTs_mul(_data->group, r, NULL, count, ps.data(),
+          ms.data(), _data->ctx));
+
+    foreach(BIGNUM *tmp, tmps) {
+      BN_clear_free(tmp);
+    }
+    return NewElement(r);
+  }
+
+  FixedBase OpenECGroup::PrecomputeFixedBase(const Element &base) const
+  {
+    if(IsIdentity(base)) {
+      return FixedBase(base);
+    }
+
+    EC_GROUP *group = EC_GROUP_dup(_data->group);
+    CHECK_CALL(group);
+    CHECK_CALL(EC_GROUP_set_generator(group, GetPoint(base), _q, _one));
+    CHECK_CALL(EC_GROUP_precompute_mult(group, _data->ctx));
+
+    return FixedBase(base, QSharedPointer<const FixedBaseData>(
+          new OpenECFixedBaseData(group)));
+  }
+
+  Element OpenECGroup::FixedBaseExponentiate(const FixedBase &base,
+      const Integer &exp) const
+  {
+    const OpenECFixedBaseData *data =
+      dynamic_cast<const OpenECFixedBaseData *>(base.GetData());
+    if(!data) {
+      return Exponentiate(base.GetElement(), exp);
+    }
+
+    EC_POINT *r = EC_POINT_new(_data->group);
+    CHECK_CALL(r);
+
+    BIGNUM *tmp = BN_new();
+    GetInteger(tmp, exp);
+
+    // Both groups share the curve, so r is a point of this group
+    CHECK_CALL(EC_POINT_mul(data->group, r, tmp, NULL, NULL, _data->ctx));
+
+    BN_clear_free(tmp);
+    return NewElement(r);
+  }
+
   Element OpenECGroup::Inverse(const Element &a) const
   {
     EC_POINT *r = EC_POINT_dup(GetPoint(a), _data->group);
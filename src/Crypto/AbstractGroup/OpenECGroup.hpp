@@ -97,6 +97,30 @@ namespace AbstractGroup {
       virtual Element CascadeExponentiate(const Element &a1, const Integer &e1,
           const Element &a2, const Integer &e2) const;
 
+      /**
+       * Compute (exps[0]bases[0] + ... + exps[n-1]bases[n-1]) using
+       * OpenSSL's interleaved multi-scalar multiplication
+       * @param bases the bases
+       * @param exps the exponents, one per base
+       */
+      virtual Element MultiExponentiate(const QList<Element> &bases,
+          const QList<Integer> &exps) const;
+
+      /**
+       * Precompute OpenSSL's multiples of base, as is done for the
+       * generator
+       * @param base the element to precompute
+       */
+      virtual FixedBase PrecomputeFixedBase(const Element &base) const;
+
+      /**
+       * Compute exp*base using the table from PrecomputeFixedBase
+       * @param base the precomputed base
+       * @param exp exponent
+       */
+      virtual Element FixedBaseExponentiate(const FixedBase &base,
+          const Integer &exp) const;
+
       /**
        * Compute b such that a+b = O (identity)
        * @param a element to invert
@@ -2,6 +2,7 @@
 #include "BlogDropClient.hpp"
 #include "CiphertextFactory.hpp"
 #include "ClientCiphertext.hpp"
+#include "HashedGeneratorCache.hpp"
 
 namespace Dissent {
 namespace Crypto {
@@ -26,6 +27,14 @@ namespace BlogDrop {
     return c->GetByteArray();
   }
 
+  void BlogDropClient::PrecomputeGenerators() const
+  {
+    QSharedPointer<HashedGeneratorCache> cache = _params->GetGeneratorCache();
+    if(cache) {
+      cache->Precompute(_params, _author_pub, _phase + 1);
+    }
+  }
+
 }
 }
 }
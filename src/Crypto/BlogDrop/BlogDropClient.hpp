@@ -43,6 +43,13 @@ namespace BlogDrop {
       inline void NextPhase() { _phase++; }
       inline int GetPhase() const { return _phase; }
 
+      /**
+       * Start deriving the next phase's hashed generators in the
+       * background, if the parameters use them.  They are only used if
+       * the element count is unchanged by then.
+       */
+      void PrecomputeGenerators() const;
+
     protected: 
 
       inline QSharedPointer<const PrivateKey> GetClientKey() const { return _client_priv; }
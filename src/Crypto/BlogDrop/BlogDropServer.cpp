@@ -24,6 +24,7 @@ namespace BlogDrop {
     _client_pubs.clear();
     _server_ciphertexts.clear();
     _client_pks.clear();
+    _plaintext.clear();
   }
 
   bool BlogDropServer::AddClientCiphertext(QByteArray in, 
@@ -33,17 +34,14 @@ namespace BlogDrop {
             _server_pk_set, _author_pub, in);
 
 
-    bool valid;
-    if(verify_proofs) {
-      valid = c->VerifyProof(_phase, pub);
-      if(valid) {
-        _client_ciphertexts.append(c);
-        _client_pubs.append(pub);
-      }
-    } else {
+    bool valid = !verify_proofs || c->VerifyProof(_phase, pub);
+    if(valid) {
       _client_ciphertexts.append(c);
       _client_pubs.append(pub);
-      valid = true;
+
+      QList<QList<Element> > cs;
+      cs.append(c->GetElements());
+      Accumulate(cs);
     }
 
     return valid;
@@ -57,21 +55,28 @@ namespace BlogDrop {
     QList<QSharedPointer<const PublicKey> > pubs_out;
     QList<QSharedPointer<const ClientCiphertext> > c_out;
 
-    bool valid;
     if(verify_proofs) {
       ClientCiphertext::VerifyProofs(_params, _server_pk_set, _author_pub, 
             _phase, pubs, in,
             c_out, pubs_out);
-      _client_ciphertexts += c_out;
-      _client_pubs += pubs_out;
-      valid = (c_out.count() == in.count());
     } else {
       for(int i=0; i<in.count(); i++) {
-        AddClientCiphertext(in[i], pubs[i], false);
+        c_out.append(CiphertextFactory::CreateClientCiphertext(_params,
+              _server_pk_set, _author_pub, in[i]));
       }
+      pubs_out = pubs;
     }
 
-    return valid;
+    _client_ciphertexts += c_out;
+    _client_pubs += pubs_out;
+
+    QList<QList<Element> > cs;
+    foreach(const QSharedPointer<const ClientCiphertext> &c, c_out) {
+      cs.append(c->GetElements());
+    }
+    Accumulate(cs);
+
+    return (c_out.count() == in.count());
   }
 
   QByteArray BlogDropServer::CloseBin() 
@@ -92,9 +97,14 @@ namespace BlogDrop {
         _params, _client_pks, _author_pub, _client_ciphertexts, in);
 
     bool okay = s->VerifyProof(_phase, from); 
-    if(okay)
+    if(okay) {
       _server_ciphertexts.append(s);
 
+      QList<QList<Element> > cs;
+      cs.append(s->GetElements());
+      Accumulate(cs);
+    }
+
     return okay;
   }
 
@@ -109,26 +119,34 @@ namespace BlogDrop {
 
     _server_ciphertexts += c_out;
 
+    QList<QList<Element> > cs;
+    foreach(const QSharedPointer<const ServerCiphertext> &s, c_out) {
+      cs.append(s->GetElements());
+    }
+    Accumulate(cs);
+
     return (c_out.count() == in.count());
 
   }
 
-  bool BlogDropServer::RevealPlaintext(QByteArray &out) const
+  void BlogDropServer::Accumulate(const QList<QList<Element> > &cs)
   {
-    Plaintext m(_params);
-    for(int client_idx=0; client_idx<_client_ciphertexts.count(); client_idx++)
-    {
-      //qDebug() << "client" << client_idx;
-      m.Reveal(_client_ciphertexts[client_idx]->GetElements());
+    if(cs.isEmpty()) {
+      return;
     }
 
-    for(int server_idx=0; server_idx<_server_ciphertexts.count(); server_idx++)
-    {
-      //qDebug() << "server" << server_idx;
-      m.Reveal(_server_ciphertexts[server_idx]->GetElements());
+    if(!_plaintext) {
+      _plaintext = QSharedPointer<Plaintext>(new Plaintext(_params));
     }
+    _plaintext->Reveal(cs);
+  }
 
-    return m.Decode(out);
+  bool BlogDropServer::RevealPlaintext(QByteArray &out) const
+  {
+    if(!_plaintext) {
+      return Plaintext(_params).Decode(out);
+    }
+    return _plaintext->Decode(out);
   }
 
   QSet<int> BlogDropServer::FindBadClients()
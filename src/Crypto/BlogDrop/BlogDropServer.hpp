@@ -19,6 +19,8 @@ namespace BlogDrop {
 
     public:
 
+      typedef Dissent::Crypto::AbstractGroup::Element Element;
+
       /**
        * Constructor: Initialize a BlogDrop client bin
        * @param params Group parameters
@@ -94,7 +96,8 @@ namespace BlogDrop {
           const QList<QSharedPointer<const PublicKey> > &pubs);
 
       /**
-       * Reveal plaintext for a BlogDrop bin
+       * Reveal plaintext for a BlogDrop bin. Ciphertexts are folded into
+       * the plaintext as they are added, so this only decodes.
        * @param out the returned plaintext
        */
       bool RevealPlaintext(QByteArray &out) const; 
@@ -119,6 +122,12 @@ namespace BlogDrop {
 
     private:
 
+      /**
+       * Fold accepted ciphertexts into the plaintext
+       * @param cs the elements of each ciphertext
+       */
+      void Accumulate(const QList<QList<Element> > &cs);
+
       int _phase;
 
       QSharedPointer<Parameters> _params;
@@ -132,6 +141,9 @@ namespace BlogDrop {
       QList<QSharedPointer<const ServerCiphertext> > _server_ciphertexts;
 
       QSharedPointer<const PublicKeySet> _client_pks;
+
+      /* product of every ciphertext in the bin, NULL while empty */
+      QSharedPointer<Plaintext> _plaintext;
   };
 }
 }
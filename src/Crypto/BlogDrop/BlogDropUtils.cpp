@@ -5,6 +5,7 @@
 #include "Crypto/AbstractGroup/Element.hpp"
 
 #include "BlogDropUtils.hpp"
+#include "HashedGeneratorCache.hpp"
 
 namespace Dissent {
 namespace Crypto {
@@ -68,6 +69,11 @@ namespace BlogDrop {
     return Integer(hash->ComputeHash()) % params->GetGroupOrder();
   }
 
+  Integer BlogDropUtils::RandomBatchExponent()
+  {
+    return Integer::GetRandomInteger(BatchExponentBits);
+  }
+
   AbstractGroup::Element BlogDropUtils::GetPairedBase(QSharedPointer<const Parameters> params,
       const QSharedPointer<const PublicKeySet> prod_pks, 
       const QSharedPointer<const PublicKey> author_pk, 
@@ -91,6 +97,19 @@ namespace BlogDrop {
       const QSharedPointer<const PublicKey> author_pk, 
       int phase, 
       int element_idx) 
+  {
+    QSharedPointer<HashedGeneratorCache> cache = params->GetGeneratorCache();
+    if(cache) {
+      return cache->GetGenerator(params, author_pk, phase, element_idx);
+    }
+    return ComputeHashedGenerator(params, author_pk, phase, element_idx);
+  }
+
+  AbstractGroup::Element BlogDropUtils::ComputeHashedGenerator(
+      QSharedPointer<const Parameters> params,
+      const QSharedPointer<const PublicKey> author_pk, 
+      int phase, 
+      int element_idx) 
   {
     // g^hash
     const int bytes = params->GetMessageGroup()->BytesPerElement() - 1;
@@ -59,13 +59,36 @@ namespace BlogDrop {
           int element_idx);
 
       /**
-       * Compute a generator as a function of H(params, ...)
+       * Compute a generator as a function of H(params, ...), using the
+       * parameters' generator cache when available
        */
       static Element GetHashedGenerator(QSharedPointer<const Parameters> params,
           const QSharedPointer<const PublicKey> author_pk, 
           int phase, 
           int element_idx);
 
+      /**
+       * Compute a generator as a function of H(params, ...) without
+       * consulting any cache
+       */
+      static Element ComputeHashedGenerator(QSharedPointer<const Parameters> params,
+          const QSharedPointer<const PublicKey> author_pk, 
+          int phase, 
+          int element_idx);
+
+      /**
+       * Number of bits in the random exponents used to combine proofs in
+       * a batch verification, a batch containing an invalid proof passes
+       * with probability at most 2^-BatchExponentBits
+       */
+      static const int BatchExponentBits = 128;
+
+      /**
+       * Returns a random exponent of BatchExponentBits bits for batch
+       * verification
+       */
+      static Integer RandomBatchExponent();
+
       /**
        * This method is used in the "Hashed generator" proof construction.
        * For our secret a, and for public keys g^x, g^y, g^z, we compute
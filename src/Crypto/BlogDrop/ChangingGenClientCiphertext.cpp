@@ -27,8 +27,9 @@ namespace BlogDrop {
     QDataStream stream(serialized);
     stream >> list;
 
-    // 2 challenges, 2 response, k elements
-    if(list.count() != (4 + GetNElements())) {
+    // 2 challenges, 2 response, k elements, optionally k+2 commitments
+    bool has_commitments = (list.count() == (6 + (2 * GetNElements())));
+    if(list.count() != (4 + GetNElements()) && !has_commitments) {
       qWarning() << "Failed to unserialize";
       return; 
     }
@@ -42,6 +43,18 @@ namespace BlogDrop {
     for(int j=0; j<GetNElements(); j++) { 
       _elements.append(_params->GetMessageGroup()->ElementFromByteArray(list[list_idx++]));
     }
+
+    if(!has_commitments) {
+      return;
+    }
+
+    // First two commitments are in the key group, the rest are in the
+    // message group
+    for(int j=0; j<(2 + GetNElements()); j++) {
+      QSharedPointer<const Crypto::AbstractGroup::AbstractGroup> group = 
+        ((j<2) ? _params->GetKeyGroup() : _params->GetMessageGroup());
+      _commitments.append(group->ElementFromByteArray(list[list_idx++]));
+    }
   }
 
   void ChangingGenClientCiphertext::InitCiphertext(int phase, 
@@ -101,6 +114,10 @@ namespace BlogDrop {
       ts.append(_params->GetMessageGroup()->CascadeExponentiate(ys[i+2], w, gs[i+2], v));
     }
 
+    if(_params->UsesBatchProofs()) {
+      _commitments = ts;
+    }
+
     // h = H(gs, ys, ts)
     // chal_1 = h - w (mod q)
     _challenge_1 = (Commit(_params, gs, ys, ts) - w) % q;
@@ -153,6 +170,10 @@ namespace BlogDrop {
       ts.append(_params->GetMessageGroup()->Exponentiate(gs[i+2], v));
     }
 
+    if(_params->UsesBatchProofs()) {
+      _commitments = ts;
+    }
+
     // h = H(gs, ys, ts)
     // chal_1 = w
     _challenge_1 = w;
@@ -221,6 +242,109 @@ namespace BlogDrop {
     return ret;
   }
 
+  bool ChangingGenClientCiphertext::VerifyProofBatch(int phase,
+      const QList<QSharedPointer<const ClientCiphertext> > &ctexts,
+      const QList<QSharedPointer<const PublicKey> > &pubs) const
+  {
+    Q_ASSERT(ctexts.count() == pubs.count());
+
+    QSharedPointer<const Crypto::AbstractGroup::AbstractGroup> key_group =
+      _params->GetKeyGroup();
+    QSharedPointer<const Crypto::AbstractGroup::AbstractGroup> msg_group =
+      _params->GetMessageGroup();
+    const Element g_key = key_group->GetGenerator();
+    const Integer q = _params->GetGroupOrder();
+
+    // The generators depend only on the phase, so every proof shares them
+    QHash<int, Element> cache;
+    QList<Element> gens;
+    for(int i=0; i<GetNElements(); i++) {
+      gens.append(ComputeGenerator(_server_pks, GetAuthorKey(), phase, i));
+      cache[i] = gens[i];
+    }
+
+    // Each proof asserts:
+    //   t_auth = (y_auth)^c1 * (g_auth)^r1
+    //   t(1) = y1^c2 * g1^r2
+    //   t(i) = yi^c2 * gi^r2
+    // Raising each equation to a random d and multiplying them together
+    // yields one equation per group, which fails with probability at most
+    // 2^-BatchExponentBits if any single equation does not hold.
+    QList<Element> key_lhs_bases, key_rhs_bases, msg_lhs_bases, msg_rhs_bases;
+    QList<Integer> key_lhs_exps, key_rhs_exps, msg_lhs_exps, msg_rhs_exps;
+
+    Integer g_exp = 0;
+    Integer y_auth_exp = 0;
+    QList<Integer> gen_exps;
+    for(int i=0; i<GetNElements(); i++) {
+      gen_exps.append(Integer(0));
+    }
+
+    for(int idx=0; idx<ctexts.count(); idx++) {
+      const ChangingGenClientCiphertext *c =
+        dynamic_cast<const ChangingGenClientCiphertext *>(ctexts[idx].data());
+      if(!c || c->_elements.count() != GetNElements() ||
+          c->_commitments.count() != (2 + GetNElements()))
+      {
+        return false;
+      }
+
+      if(!key_group->IsElement(c->_commitments[0]) ||
+          !key_group->IsElement(c->_commitments[1]))
+      {
+        return false;
+      }
+
+      for(int i=0; i<GetNElements(); i++) { 
+        if(!msg_group->IsElement(c->_elements[i]) ||
+            !msg_group->IsElement(c->_commitments[i+2]))
+        {
+          return false;
+        }
+      }
+
+      QList<Element> gs;
+      QList<Element> ys;
+      c->InitializeLists(cache, phase, pubs[idx], gs, ys);
+
+      // The commitments must be the ones the challenges were derived from
+      Integer hash = Commit(_params, gs, ys, c->_commitments);
+      if(hash != ((c->_challenge_1 + c->_challenge_2) % q)) {
+        return false;
+      }
+
+      Integer d_auth = BlogDropUtils::RandomBatchExponent();
+      Integer d_pub = BlogDropUtils::RandomBatchExponent();
+
+      key_lhs_bases << c->_commitments[0] << c->_commitments[1];
+      key_lhs_exps << d_auth << d_pub;
+      key_rhs_bases.append(pubs[idx]->GetElement());
+      key_rhs_exps.append(c->_challenge_2.MultiplyMod(d_pub, q));
+      y_auth_exp = (y_auth_exp + c->_challenge_1.MultiplyMod(d_auth, q)) % q;
+      g_exp = (g_exp + c->_response_1.MultiplyMod(d_auth, q) +
+          c->_response_2.MultiplyMod(d_pub, q)) % q;
+
+      for(int i=0; i<GetNElements(); i++) {
+        Integer d = BlogDropUtils::RandomBatchExponent();
+        msg_lhs_bases.append(c->_commitments[i+2]);
+        msg_lhs_exps.append(d);
+        msg_rhs_bases.append(c->_elements[i]);
+        msg_rhs_exps.append(c->_challenge_2.MultiplyMod(d, q));
+        gen_exps[i] = (gen_exps[i] + c->_response_2.MultiplyMod(d, q)) % q;
+      }
+    }
+
+    key_rhs_bases << _author_pub->GetElement() << g_key;
+    key_rhs_exps << y_auth_exp << g_exp;
+    msg_rhs_bases += gens;
+    msg_rhs_exps += gen_exps;
+
+    return (key_group->MultiExponentiate(key_lhs_bases, key_lhs_exps) ==
+        key_group->MultiExponentiate(key_rhs_bases, key_rhs_exps)) &&
+      (msg_group->MultiExponentiate(msg_lhs_bases, msg_lhs_exps) ==
+        msg_group->MultiExponentiate(msg_rhs_bases, msg_rhs_exps));
+  }
+
   QByteArray ChangingGenClientCiphertext::GetByteArray() const 
   {
     QList<QByteArray> list;
@@ -234,6 +358,12 @@ namespace BlogDrop {
       list.append(_params->GetMessageGroup()->ElementToByteArray(_elements[i]));
     }
 
+    for(int i=0; i<_commitments.count(); i++) {
+      QSharedPointer<const Crypto::AbstractGroup::AbstractGroup> group = 
+        ((i<2) ? _params->GetKeyGroup() : _params->GetMessageGroup());
+      list.append(group->ElementToByteArray(_commitments[i]));
+    }
+
     QByteArray out;
     QDataStream stream(&out, QIODevice::WriteOnly);
     stream << list;
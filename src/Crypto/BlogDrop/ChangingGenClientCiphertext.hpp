@@ -85,6 +85,19 @@ namespace BlogDrop {
        */
       virtual bool VerifyProof(int phase, const QSharedPointer<const PublicKey> client_pub) const;
 
+      /**
+       * Check a set of proofs, sharing this ciphertext's server keys,
+       * author key, and phase, with a single randomized test.  Requires
+       * that the ciphertexts include their proof commitments.
+       * @param phase transmission round/phase index
+       * @param ctexts the ciphertexts to check
+       * @param pubs the client (NOT author) public keys for each ciphertext
+       * @returns true if all proofs are okay
+       */
+      virtual bool VerifyProofBatch(int phase,
+          const QList<QSharedPointer<const ClientCiphertext> > &ctexts,
+          const QList<QSharedPointer<const PublicKey> > &pubs) const;
+
       /**
        * Get a byte array for this ciphertext
        */
@@ -126,6 +139,13 @@ namespace BlogDrop {
       Integer _challenge_2;
       Integer _response_1;
       Integer _response_2;
+
+      /**
+       * The proof commitments (ts), serialized so that a verifier can
+       * combine many proofs into one check.  Empty unless the parameters
+       * use batch proofs.
+       */
+      QList<Element> _commitments;
   };
 }
 }
@@ -27,17 +27,30 @@ namespace BlogDrop {
     QDataStream stream(serialized);
     stream >> list;
 
-    // challenge, response, and k elements
-    if(list.count() != (2 + _params->GetNElements())) {
+    // challenge, response, k elements, and optionally k+1 commitments
+    const int n_elms = _params->GetNElements();
+    bool has_commitments = (list.count() == (3 + (2 * n_elms)));
+    if(list.count() != (2 + n_elms) && !has_commitments) {
       qWarning() << "Failed to unserialize";
       return; 
     }
 
     _challenge = Integer(list[0]);
     _response = Integer(list[1]);
-    for(int i=0; i<_params->GetNElements(); i++) {
+    for(int i=0; i<n_elms; i++) {
       _elements.append(_params->GetMessageGroup()->ElementFromByteArray(list[i+2]));
     }
+
+    if(!has_commitments) {
+      return;
+    }
+
+    // First commitment is in the key group, the rest are in the message group
+    _commitments.append(_params->GetKeyGroup()->ElementFromByteArray(list[2+n_elms]));
+    for(int i=0; i<n_elms; i++) {
+      _commitments.append(_params->GetMessageGroup()->ElementFromByteArray(
+            list[3+n_elms+i]));
+    }
   }
 
   void ChangingGenServerCiphertext::SetProof(int phase, const QSharedPointer<const PrivateKey> priv)
@@ -71,6 +84,10 @@ namespace BlogDrop {
       ts.append(ti);
     }
 
+    if(_params->UsesBatchProofs()) {
+      _commitments = ts;
+    }
+
     // c = HASH(g1, g2, ..., y1, y2, ..., t1, t2, ...) mod q
     _challenge = BlogDropUtils::Commit(_params, gs, ys, ts);
 
@@ -125,6 +142,100 @@ namespace BlogDrop {
     return (tmp == _challenge);
   }
 
+  bool ChangingGenServerCiphertext::VerifyProofBatch(int phase,
+      const QList<QSharedPointer<const ServerCiphertext> > &ctexts,
+      const QList<QSharedPointer<const PublicKey> > &pubs) const
+  {
+    Q_ASSERT(ctexts.count() == pubs.count());
+
+    QSharedPointer<const Crypto::AbstractGroup::AbstractGroup> key_group =
+      _params->GetKeyGroup();
+    QSharedPointer<const Crypto::AbstractGroup::AbstractGroup> msg_group =
+      _params->GetMessageGroup();
+    const Integer q = _params->GetGroupOrder();
+
+    // g(0) and the g(i) are the same for every server this phase
+    QList<Element> gs;
+    QList<Element> unused;
+    InitializeLists(phase, pubs[0], gs, unused);
+
+    // Each proof asserts:
+    //   t0 = g0^r * y0^c
+    //   t(i) = g(i)^-r * y(i)^c
+    // Raising each equation to a random d and multiplying them together
+    // yields one equation per group, which fails with probability at most
+    // 2^-BatchExponentBits if any single equation does not hold.
+    QList<Element> key_lhs_bases, key_rhs_bases, msg_lhs_bases, msg_rhs_bases;
+    QList<Integer> key_lhs_exps, key_rhs_exps, msg_lhs_exps, msg_rhs_exps;
+
+    Integer g_exp = 0;
+    QList<Integer> gen_exps;
+    for(int i=0; i<_n_elms; i++) {
+      gen_exps.append(Integer(0));
+    }
+
+    for(int idx=0; idx<ctexts.count(); idx++) {
+      const ChangingGenServerCiphertext *s =
+        dynamic_cast<const ChangingGenServerCiphertext *>(ctexts[idx].data());
+      if(!s || s->_elements.count() != _n_elms ||
+          s->_commitments.count() != (1 + _n_elms))
+      {
+        return false;
+      }
+
+      if(!key_group->IsElement(pubs[idx]->GetElement()) ||
+          !key_group->IsElement(s->_commitments[0]))
+      {
+        return false;
+      }
+
+      for(int i=0; i<_n_elms; i++) {
+        if(!msg_group->IsElement(s->_elements[i]) ||
+            !msg_group->IsElement(s->_commitments[i+1]))
+        {
+          return false;
+        }
+      }
+
+      // The commitments must be the ones the challenge was derived from
+      QList<Element> ys;
+      ys.append(pubs[idx]->GetElement());
+      ys += s->_elements;
+      if(BlogDropUtils::Commit(_params, gs, ys, s->_commitments) != s->_challenge) {
+        return false;
+      }
+
+      Integer d = BlogDropUtils::RandomBatchExponent();
+      key_lhs_bases.append(s->_commitments[0]);
+      key_lhs_exps.append(d);
+      key_rhs_bases.append(pubs[idx]->GetElement());
+      key_rhs_exps.append(s->_challenge.MultiplyMod(d, q));
+      g_exp = (g_exp + s->_response.MultiplyMod(d, q)) % q;
+
+      for(int i=0; i<_n_elms; i++) {
+        d = BlogDropUtils::RandomBatchExponent();
+        msg_lhs_bases.append(s->_commitments[i+1]);
+        msg_lhs_exps.append(d);
+        msg_rhs_bases.append(s->_elements[i]);
+        msg_rhs_exps.append(s->_challenge.MultiplyMod(d, q));
+        gen_exps[i] = (gen_exps[i] + s->_response.MultiplyMod(d, q)) % q;
+      }
+    }
+
+    key_rhs_bases.append(gs[0]);
+    key_rhs_exps.append(g_exp);
+    // t(i) * g(i)^r = y(i)^c, which keeps all exponents non-negative
+    for(int i=0; i<_n_elms; i++) {
+      msg_lhs_bases.append(gs[i+1]);
+      msg_lhs_exps.append(gen_exps[i]);
+    }
+
+    return (key_group->MultiExponentiate(key_lhs_bases, key_lhs_exps) ==
+        key_group->MultiExponentiate(key_rhs_bases, key_rhs_exps)) &&
+      (msg_group->MultiExponentiate(msg_lhs_bases, msg_lhs_exps) ==
+        msg_group->MultiExponentiate(msg_rhs_bases, msg_rhs_exps));
+  }
+
   QByteArray ChangingGenServerCiphertext::GetByteArray() const 
   {
     QList<QByteArray> list;
@@ -135,6 +246,12 @@ namespace BlogDrop {
       list.append(_params->GetMessageGroup()->ElementToByteArray(_elements[i]));
     }
 
+    for(int i=0; i<_commitments.count(); i++) {
+      QSharedPointer<const Crypto::AbstractGroup::AbstractGroup> group = 
+        ((!i) ? _params->GetKeyGroup() : _params->GetMessageGroup());
+      list.append(group->ElementToByteArray(_commitments[i]));
+    }
+
     QByteArray out;
     QDataStream stream(&out, QIODevice::WriteOnly);
     stream << list;
@@ -65,6 +65,19 @@ namespace BlogDrop {
        */
       virtual bool VerifyProof(int phase, const QSharedPointer<const PublicKey> pub) const;
 
+      /**
+       * Check a set of proofs, sharing this ciphertext's client keys,
+       * author key, and phase, with a single randomized test.  Requires
+       * that the ciphertexts include their proof commitments.
+       * @param phase transmisssion round/phase index
+       * @param ctexts the ciphertexts to check
+       * @param pubs public keys of the servers for each ciphertext
+       * @returns true if all proofs are okay
+       */
+      virtual bool VerifyProofBatch(int phase,
+          const QList<QSharedPointer<const ServerCiphertext> > &ctexts,
+          const QList<QSharedPointer<const PublicKey> > &pubs) const;
+
       /**
        * Get serialized version
        */
@@ -89,6 +102,13 @@ namespace BlogDrop {
       QSharedPointer<const PublicKeySet> _client_pks;
       Integer _challenge;
       Integer _response;
+
+      /**
+       * The proof commitments (ts), serialized so that a verifier can
+       * combine many proofs into one check.  Empty unless the parameters
+       * use batch proofs.
+       */
+      QList<Element> _commitments;
   };
 }
 }
@@ -29,21 +29,31 @@ namespace BlogDrop {
           const QList<QSharedPointer<const PublicKey> > &pubs,
           const QList<QByteArray> &c,
           QList<QSharedPointer<const ClientCiphertext> > &c_out,
-          QList<QSharedPointer<const PublicKey> > &pubs_out)
+          QList<QSharedPointer<const PublicKey> > &pubs_out,
+          bool batch)
   {
     Q_ASSERT(pubs.count() == c.count());
 
     CryptoFactory::ThreadingType tt = CryptoFactory::GetInstance().GetThreadingType();
+    batch = batch && params->UsesBatchProofs() && c.count() > 1;
 
-    if(tt == CryptoFactory::SingleThreaded) {
-      QList<QSharedPointer<const ClientCiphertext> > list;
-
-      // Unpack each ciphertext
+    // Unpack each ciphertext once, the batch check and the
+    // single threaded fallback share them
+    QList<QSharedPointer<const ClientCiphertext> > list;
+    if(batch || tt == CryptoFactory::SingleThreaded) {
       for(int client_idx=0; client_idx<c.count(); client_idx++) {
         list.append(CiphertextFactory::CreateClientCiphertext(params, 
               server_pk_set, author_pk, c[client_idx]));
       }
+    }
 
+    if(batch && list[0]->VerifyProofBatch(phase, list, pubs)) {
+      c_out += list;
+      pubs_out += pubs;
+      return;
+    }
+
+    if(tt == CryptoFactory::SingleThreaded) {
       // Verify each proof
       for(int idx=0; idx<c.count(); idx++) {
         if(list[idx]->VerifyProof(phase, pubs[idx])) {
@@ -73,7 +83,8 @@ namespace BlogDrop {
 
       for(int client_idx=0; client_idx<valid_list.count(); client_idx++) {
         if(valid_list[client_idx]) {
-          c_out.append(CiphertextFactory::CreateClientCiphertext(
+          c_out.append(list.count() ? list[client_idx] :
+              CiphertextFactory::CreateClientCiphertext(
                   params, server_pk_set, author_pk, c[client_idx]));
           pubs_out.append(pubs[client_idx]);
         }
@@ -79,6 +79,23 @@ namespace BlogDrop {
        */
       virtual bool VerifyProof(int phase, const QSharedPointer<const PublicKey> client_pub) const = 0;
 
+      /**
+       * Check a set of proofs, sharing this ciphertext's server keys,
+       * author key, and phase, with a single randomized test.
+       * Constructions that cannot combine proofs return false, so that
+       * callers fall back to checking each proof.
+       * @param phase transmission round/phase index
+       * @param ctexts the ciphertexts to check
+       * @param pubs the client (NOT author) public keys for each ciphertext
+       * @returns true if all proofs are okay
+       */
+      virtual bool VerifyProofBatch(int /*phase*/,
+          const QList<QSharedPointer<const ClientCiphertext> > &/*ctexts*/,
+          const QList<QSharedPointer<const PublicKey> > &/*pubs*/) const
+      {
+        return false;
+      }
+
       /**
        * Get a byte array for this ciphertext
        */
@@ -86,7 +103,9 @@ namespace BlogDrop {
 
       /**
        * Verify a set of proofs. Uses threading if available, so this might
-       * be much faster than verifying each proof in turn
+       * be much faster than verifying each proof in turn.  If batch is set
+       * and the parameters use batch proofs, all proofs are first checked
+       * together and only verified one by one if the combined check fails.
        */
       static void VerifyProofs(
           const QSharedPointer<const Parameters> params,
@@ -96,7 +115,8 @@ namespace BlogDrop {
           const QList<QSharedPointer<const PublicKey> > &pubs,
           const QList<QByteArray> &c,
           QList<QSharedPointer<const ClientCiphertext> > &c_out,
-          QList<QSharedPointer<const PublicKey> > &pubs_out);
+          QList<QSharedPointer<const PublicKey> > &pubs_out,
+          bool batch = true);
 
       virtual inline QList<Element> GetElements() const 
       { 
@@ -20,8 +20,8 @@ namespace BlogDrop {
       QSharedPointer<const PublicKey> pub(new PublicKey(priv));
       _one_time_privs.append(priv);
       _one_time_pubs.append(pub);
-      _elements.append(_params->GetMessageGroup()->Exponentiate(_server_pks->GetElement(),
-          _one_time_privs[i]->GetInteger())); 
+      // ElGamal parameters use the same group for keys and messages
+      _elements.append(_server_pks->Exponentiate(_one_time_privs[i]->GetInteger()));
     }
   }
 
@@ -0,0 +1,99 @@
+#include <QDataStream>
+#include <QMutexLocker>
+#include <QtConcurrentRun>
+
+#include "Crypto/CryptoFactory.hpp"
+
+#include "BlogDropUtils.hpp"
+#include "HashedGeneratorCache.hpp"
+
+namespace Dissent {
+namespace Crypto {
+namespace BlogDrop {
+
+  HashedGeneratorCache::HashedGeneratorCache() :
+    _newest_phase(-1)
+  {
+  }
+
+  AbstractGroup::Element HashedGeneratorCache::GetGenerator(
+      const QSharedPointer<const Parameters> &params,
+      const QSharedPointer<const PublicKey> &author_pk,
+      int phase, int element_idx)
+  {
+    if(element_idx >= params->GetNElements()) {
+      return BlogDropUtils::ComputeHashedGenerator(params, author_pk,
+          phase, element_idx);
+    }
+
+    QSharedPointer<Entry> entry = GetEntry(params, author_pk, phase);
+    Fill(entry, params, author_pk, phase);
+    return entry->generators[element_idx];
+  }
+
+  void HashedGeneratorCache::Precompute(
+      const QSharedPointer<const Parameters> &params,
+      const QSharedPointer<const PublicKey> &author_pk, int phase)
+  {
+    if(CryptoFactory::GetInstance().GetThreadingType() !=
+        CryptoFactory::MultiThreaded)
+    {
+      return;
+    }
+
+    // The round keeps adjusting the element count of its parameters, so
+    // the background computation works on a snapshot
+    QSharedPointer<const Parameters> snapshot(new Parameters(*params));
+    QtConcurrent::run(&HashedGeneratorCache::Fill,
+        GetEntry(snapshot, author_pk, phase), snapshot, author_pk, phase);
+  }
+
+  QSharedPointer<HashedGeneratorCache::Entry> HashedGeneratorCache::GetEntry(
+      const QSharedPointer<const Parameters> &params,
+      const QSharedPointer<const PublicKey> &author_pk, int phase)
+  {
+    QMutexLocker locker(&_lock);
+    if(phase > _newest_phase) {
+      _newest_phase = phase;
+      while(!_entries.isEmpty() && _entries.begin().key() < (phase - 1)) {
+        _entries.erase(_entries.begin());
+      }
+      _authors.clear();
+    }
+
+    QPair<Element, QByteArray> &author = _authors[author_pk.data()];
+    if(author.second.isEmpty() || author.first != author_pk->GetElement()) {
+      author.first = author_pk->GetElement();
+      author.second = author_pk->GetByteArray();
+    }
+
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream << author.second << params->GetRoundNonce() << params->GetNElements();
+
+    QSharedPointer<Entry> &entry = _entries[phase][key];
+    if(!entry) {
+      entry = QSharedPointer<Entry>(new Entry());
+    }
+    return entry;
+  }
+
+  void HashedGeneratorCache::Fill(QSharedPointer<Entry> entry,
+      QSharedPointer<const Parameters> params,
+      QSharedPointer<const PublicKey> author_pk, int phase)
+  {
+    QMutexLocker locker(&entry->lock);
+    if(entry->ready) {
+      return;
+    }
+
+    for(int idx = 0; idx < params->GetNElements(); idx++) {
+      entry->generators.append(BlogDropUtils::ComputeHashedGenerator(params,
+            author_pk, phase, idx));
+    }
+    entry->ready = true;
+  }
+
+}
+}
+}
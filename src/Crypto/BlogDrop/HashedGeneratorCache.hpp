@@ -0,0 +1,106 @@
+#ifndef DISSENT_CRYPTO_BLOGDROP_HASHED_GENERATOR_CACHE_H_GUARD
+#define DISSENT_CRYPTO_BLOGDROP_HASHED_GENERATOR_CACHE_H_GUARD
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QSharedPointer>
+
+#include "Crypto/AbstractGroup/Element.hpp"
+#include "Parameters.hpp"
+#include "PublicKey.hpp"
+
+namespace Dissent {
+namespace Crypto {
+namespace BlogDrop {
+
+  /**
+   * Holds the hashed generators of a round.  A generator depends only on
+   * the parameters, the author key, the phase and the element index, yet
+   * every client and server ciphertext of a slot needs the same ones.
+   * Parameters with the hashing generator proof share one cache across
+   * all of their copies, so it lives as long as the round.  Only the
+   * newest two phases are retained.  Since the copies share their groups,
+   * entries are told apart by author, round nonce and element count.
+   */
+  class HashedGeneratorCache {
+
+    public:
+
+      typedef Dissent::Crypto::AbstractGroup::Element Element;
+
+      /**
+       * Constructor
+       */
+      HashedGeneratorCache();
+
+      /**
+       * Returns BlogDropUtils::ComputeHashedGenerator(params, author_pk,
+       * phase, element_idx), computing all of the phase's generators on a
+       * miss
+       * @param params the parameters
+       * @param author_pk the slot's author
+       * @param phase the phase
+       * @param element_idx the ciphertext element
+       */
+      Element GetGenerator(const QSharedPointer<const Parameters> &params,
+          const QSharedPointer<const PublicKey> &author_pk,
+          int phase, int element_idx);
+
+      /**
+       * Computes a phase's generators on the global thread pool, if
+       * threading is enabled.  GetGenerator waits on a computation in
+       * progress rather than repeating it.
+       * @param params the parameters, which may change afterwards
+       * @param author_pk the slot's author
+       * @param phase the phase
+       */
+      void Precompute(const QSharedPointer<const Parameters> &params,
+          const QSharedPointer<const PublicKey> &author_pk, int phase);
+
+    private:
+
+      /**
+       * The generators of one author and phase, guarded by its own lock
+       * so that distinct slots compute in parallel
+       */
+      class Entry {
+        public:
+          Entry() : ready(false) {}
+
+          QMutex lock;
+          bool ready;
+          QList<Element> generators;
+      };
+
+      QSharedPointer<Entry> GetEntry(
+          const QSharedPointer<const Parameters> &params,
+          const QSharedPointer<const PublicKey> &author_pk, int phase);
+
+      static void Fill(QSharedPointer<Entry> entry,
+          QSharedPointer<const Parameters> params,
+          QSharedPointer<const PublicKey> author_pk, int phase);
+
+      QMutex _lock;
+      int _newest_phase;
+
+      /**
+       * phase -> (author, round nonce, element count) -> generators
+       */
+      QMap<int, QHash<QByteArray, QSharedPointer<Entry> > > _entries;
+
+      /**
+       * The serialized element of each author key seen since the newest
+       * phase began, so that it is not reserialized on every lookup.  The
+       * element is kept to detect a key allocated at a reused address.
+       */
+      QHash<const PublicKey *, QPair<Element, QByteArray> > _authors;
+  };
+}
+}
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include "Crypto/AbstractGroup/OpenECGroup.hpp"
 #include "Crypto/AbstractGroup/PairingG1Group.hpp"
 #include "Crypto/AbstractGroup/PairingGTGroup.hpp"
+#include "HashedGeneratorCache.hpp"
 #include "Parameters.hpp"
 
 using namespace Dissent::Crypto::AbstractGroup;
@@ -112,7 +113,8 @@ namespace BlogDrop {
 
   Parameters::Parameters() : 
     _proof_type(ProofType_Invalid),
-    _n_elements(0) {}
+    _n_elements(0),
+    _batch_proofs(false) {}
 
   Parameters::Parameters(ProofType proof_type, 
       QByteArray round_nonce,
@@ -123,8 +125,14 @@ namespace BlogDrop {
     _round_nonce(round_nonce),
     _key_group(key_group),
     _msg_group(msg_group),
-    _n_elements(n_elements)
+    _n_elements(n_elements),
+    _batch_proofs(false)
   {
+    if(_proof_type == ProofType_HashingGenerator) {
+      _generator_cache = QSharedPointer<HashedGeneratorCache>(
+          new HashedGeneratorCache());
+    }
+
     Q_ASSERT(!_key_group.isNull());
     Q_ASSERT(!_msg_group.isNull());
     Q_ASSERT(key_group->IsProbablyValid());
@@ -136,7 +144,9 @@ namespace BlogDrop {
     _round_nonce(p._round_nonce),
     _key_group(p._key_group->Copy()),
     _msg_group(p._msg_group->Copy()),
-    _n_elements(p._n_elements)
+    _n_elements(p._n_elements),
+    _batch_proofs(p._batch_proofs),
+    _generator_cache(p._generator_cache)
   {
   }
 
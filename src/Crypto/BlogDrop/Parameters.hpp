@@ -10,6 +10,8 @@ namespace Dissent {
   namespace Crypto {
     namespace BlogDrop {
 
+      class HashedGeneratorCache;
+
       /**
        * Object holding group definition
        */
@@ -163,6 +165,29 @@ namespace Dissent {
 
           Element ApplyPairing(const Element &a, const Element &b) const;
 
+          /**
+           * Enable batch proof verification.  Hashing and pairing
+           * ciphertexts then also carry their proof commitments, which
+           * lets a verifier check many proofs at once at the cost of
+           * roughly doubling the size of each ciphertext.  Off by default.
+           * @param batch true to send commitments and batch verify
+           */
+          inline void SetBatchProofs(bool batch) { _batch_proofs = batch; }
+
+          /**
+           * Returns true if ciphertexts carry proof commitments and proofs
+           * are batch verified
+           */
+          inline bool UsesBatchProofs() const { return _batch_proofs; }
+
+          /**
+           * Get the hashed generator cache shared by all copies of these
+           * parameters, NULL unless using the hashing generator proof
+           */
+          inline QSharedPointer<HashedGeneratorCache> GetGeneratorCache() const {
+            return _generator_cache;
+          }
+
           /**
            * Constructor: it's better to use one of the static constructors
            * @param proof_type which proof construction to use
@@ -216,6 +241,16 @@ namespace Dissent {
        * Number of ciphertext elements in a single ciphertext
        */
       int _n_elements;
+
+      /**
+       * Send proof commitments and batch verify proofs
+       */
+      bool _batch_proofs;
+
+      /**
+       * Generators used by the hashing generator proof
+       */
+      QSharedPointer<HashedGeneratorCache> _generator_cache;
   };
 }
 }
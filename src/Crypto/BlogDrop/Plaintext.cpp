@@ -1,9 +1,39 @@
 
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include "Crypto/CryptoFactory.hpp"
+
 #include "Plaintext.hpp"
 
 namespace Dissent {
 namespace Crypto {
 namespace BlogDrop {
+namespace {
+  typedef Dissent::Crypto::AbstractGroup::AbstractGroup AbstractGroup;
+  typedef Dissent::Crypto::AbstractGroup::Element Element;
+
+  /**
+   * A contiguous range of plaintext elements and the matching range of
+   * each ciphertext
+   */
+  struct RevealJob {
+    QSharedPointer<const AbstractGroup> group;
+    QList<Element> ms;
+    QList<QList<Element> > cs;
+  };
+
+  QList<Element> RevealRange(const RevealJob &job)
+  {
+    QList<Element> ms = job.ms;
+    foreach(const QList<Element> &c, job.cs) {
+      for(int idx = 0; idx < ms.count(); idx++) {
+        ms[idx] = job.group->Multiply(ms[idx], c[idx]);
+      }
+    }
+    return ms;
+  }
+}
 
   Plaintext::Plaintext(const QSharedPointer<const Parameters> params) :
     _params(params)
@@ -54,6 +84,47 @@ namespace BlogDrop {
     }
   }
 
+  void Plaintext::Reveal(const QList<QList<Element> > &cs)
+  {
+    const int nelms = _ms.count();
+    int workers = 1;
+    if(CryptoFactory::GetInstance().GetThreadingType() ==
+        CryptoFactory::MultiThreaded)
+    {
+      workers = qMax(1, qMin(QThread::idealThreadCount(), nelms));
+    }
+
+    if(workers == 1 || cs.count() < 2) {
+      foreach(const QList<Element> &c, cs) {
+        Reveal(c);
+      }
+      return;
+    }
+
+    // Each thread gets its own copy of the group, since some group
+    // implementations keep scratch state
+    QList<RevealJob> jobs;
+    const int per_job = (nelms + workers - 1) / workers;
+    for(int start = 0; start < nelms; start += per_job) {
+      RevealJob job;
+      job.group = _params->GetMessageGroup()->Copy();
+      job.ms = _ms.mid(start, per_job);
+      foreach(const QList<Element> &c, cs) {
+        Q_ASSERT(c.count() == nelms);
+        job.cs.append(c.mid(start, per_job));
+      }
+      jobs.append(job);
+    }
+
+    QList<QList<Element> > results =
+      QtConcurrent::blockingMapped(jobs, RevealRange);
+
+    _ms.clear();
+    foreach(const QList<Element> &result, results) {
+      _ms += result;
+    }
+  }
+
 }
 }
 }
@@ -64,6 +64,15 @@ namespace BlogDrop {
        */
       void Reveal(const QList<Element> &c);
 
+      /**
+       * Reveal a plaintext by combining the elements of several
+       * ciphertexts. Uses threading (where available) by splitting
+       * the elements across threads, a single ciphertext is combined
+       * serially as splitting it costs more than it saves.
+       * @param cs the elements of each ciphertext
+       */
+      void Reveal(const QList<QList<Element> > &cs);
+
     private:
 
       const QSharedPointer<const Parameters> _params;
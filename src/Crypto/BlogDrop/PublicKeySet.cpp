@@ -6,7 +6,8 @@ namespace Crypto {
 namespace BlogDrop {
 
   PublicKeySet::PublicKeySet(const QSharedPointer<const Parameters> params, 
-      const QList<QSharedPointer<const PublicKey> > &keys) :
+      const QList<QSharedPointer<const PublicKey> > &keys,
+      bool precompute) :
     _n_keys(keys.count()),
     _params(params)
   {
@@ -15,6 +16,9 @@ namespace BlogDrop {
     for(int i=0; i<keys.count(); i++) {
       _key = _params->GetKeyGroup()->Multiply(_key, keys[i]->GetElement());
     }
+
+    _fixed_key = precompute ? _params->GetKeyGroup()->PrecomputeFixedBase(_key) :
+      FixedBase(_key);
   }
 
   PublicKeySet::PublicKeySet(const QSharedPointer<const Parameters> params, 
@@ -27,6 +31,7 @@ namespace BlogDrop {
     stream >> _n_keys >> keybytes;
 
     _key = _params->GetKeyGroup()->ElementFromByteArray(keybytes);
+    _fixed_key = FixedBase(_key);
   }
 
   QList<QSharedPointer<const PublicKeySet> > PublicKeySet::CreateClientKeySets(
@@ -6,6 +6,7 @@
 #include <QSharedPointer>
 
 #include "Crypto/AbstractGroup/Element.hpp"
+#include "Crypto/AbstractGroup/FixedBase.hpp"
 #include "Parameters.hpp"
 #include "PublicKey.hpp"
 
@@ -23,14 +24,18 @@ namespace BlogDrop {
     public:
 
       typedef Dissent::Crypto::AbstractGroup::Element Element;
+      typedef Dissent::Crypto::AbstractGroup::FixedBase FixedBase;
 
       /**
        * Constructor: Initialize using a QSet of keys
        * @params params group parameters
        * @params keys keyset to use
+       * @params precompute build a fixed-base table for the keyset, worth
+       *         it for long-lived sets such as the servers' keys
        */
       PublicKeySet(const QSharedPointer<const Parameters> params, 
-          const QList<QSharedPointer<const PublicKey> > &keys);
+          const QList<QSharedPointer<const PublicKey> > &keys,
+          bool precompute = false);
 
       /**
        * Constructor: Initialize using a QSet of keys
@@ -62,6 +67,14 @@ namespace BlogDrop {
        */
       const Element GetElement() const { return _key; }
 
+      /**
+       * Compute key^exp, using the fixed-base table if one was built
+       * @param exp the exponent
+       */
+      inline Element Exponentiate(const Integer &exp) const {
+        return _params->GetKeyGroup()->FixedBaseExponentiate(_fixed_key, exp);
+      }
+
       /**
        * Get number of keys
        */
@@ -87,6 +100,11 @@ namespace BlogDrop {
        *   key = (g^x0)(g^x1)...(g^xN)
        */
       Element _key;
+
+      /**
+       * _key with an optional precomputed table
+       */
+      FixedBase _fixed_key;
   };
 }
 }
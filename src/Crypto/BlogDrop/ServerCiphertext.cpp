@@ -28,20 +28,30 @@ namespace BlogDrop {
       int phase, 
       const QList<QSharedPointer<const PublicKey> > &pubs,
       const QList<QByteArray> &c,
-      QList<QSharedPointer<const ServerCiphertext> > &c_out)
+      QList<QSharedPointer<const ServerCiphertext> > &c_out,
+      bool batch)
   {
     Q_ASSERT(pubs.count() == c.count());
 
     CryptoFactory::ThreadingType tt = CryptoFactory::GetInstance().GetThreadingType();
-    if(tt == CryptoFactory::SingleThreaded) {
-      QList<QSharedPointer<const ServerCiphertext> > list;
+    batch = batch && params->UsesBatchProofs() && c.count() > 1;
 
-      // Unpack each ciphertext
+    // Unpack each ciphertext once, the batch check and the
+    // single threaded fallback share them
+    QList<QSharedPointer<const ServerCiphertext> > list;
+    if(batch || tt == CryptoFactory::SingleThreaded) {
       for(int server_idx=0; server_idx<c.count(); server_idx++) {
         list.append(CiphertextFactory::CreateServerCiphertext(params, 
               server_pk_set, author_pk, client_ctexts, c[server_idx]));
       }
+    }
 
+    if(batch && list[0]->VerifyProofBatch(phase, list, pubs)) {
+      c_out += list;
+      return;
+    }
+
+    if(tt == CryptoFactory::SingleThreaded) {
       // Verify each proof
       for(int idx=0; idx<c.count(); idx++) {
         if(list[idx]->VerifyProof(phase, pubs[idx])) {
@@ -82,8 +92,9 @@ namespace BlogDrop {
 
       for(int server_idx=0; server_idx<valid_list.count(); server_idx++) {
         if(valid_list[server_idx]) {
-          c_out.append(CiphertextFactory::CreateServerCiphertext(
-              params, server_pk_set, author_pk, client_ctexts, c[server_idx]));
+          c_out.append(list.count() ? list[server_idx] :
+              CiphertextFactory::CreateServerCiphertext(
+                params, server_pk_set, author_pk, client_ctexts, c[server_idx]));
         }
       }
 
@@ -60,9 +60,28 @@ namespace BlogDrop {
        */
       virtual bool VerifyProof(int phase, const QSharedPointer<const PublicKey> pub) const = 0;
 
+      /**
+       * Check a set of proofs, sharing this ciphertext's client keys,
+       * author key, and phase, with a single randomized test.
+       * Constructions that cannot combine proofs return false, so that
+       * callers fall back to checking each proof.
+       * @param phase transmisssion round/phase index
+       * @param ctexts the ciphertexts to check
+       * @param pubs public keys of the servers for each ciphertext
+       * @returns true if all proofs are okay
+       */
+      virtual bool VerifyProofBatch(int /*phase*/,
+          const QList<QSharedPointer<const ServerCiphertext> > &/*ctexts*/,
+          const QList<QSharedPointer<const PublicKey> > &/*pubs*/) const
+      {
+        return false;
+      }
+
       /**
        * Verify a set of proofs. Uses threading if available, so this might
-       * be much faster than verifying each proof in turn
+       * be much faster than verifying each proof in turn.  If batch is set
+       * and the parameters use batch proofs, all proofs are first checked
+       * together and only verified one by one if the combined check fails.
        */
       static void VerifyProofs(
           const QSharedPointer<const Parameters> params,
@@ -72,7 +91,8 @@ namespace BlogDrop {
           int phase, 
           const QList<QSharedPointer<const PublicKey> > &pubs,
           const QList<QByteArray> &c,
-          QList<QSharedPointer<const ServerCiphertext> > &c_out);
+          QList<QSharedPointer<const ServerCiphertext> > &c_out,
+          bool batch = true);
 
       /**
        * Get serialized version
@@ -0,0 +1,70 @@
+#include "CppCtrRandom.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  CppCtrRandom::CppCtrRandom(const QByteArray &seed, uint index)
+  {
+    int seed_length = CryptoPP::AES::DEFAULT_KEYLENGTH;
+    QByteArray seed_tmp(seed);
+    if(seed_tmp.size() < seed_length) {
+      QByteArray tmp(seed_length - seed_tmp.size(), 0);
+      seed_tmp.append(tmp);
+    } else if(seed_length < seed_tmp.size()) {
+      seed_tmp.resize(seed_length);
+    }
+
+    QByteArray counter(CryptoPP::AES::BLOCKSIZE, 0);
+    _cipher.SetKeyWithIV(reinterpret_cast<const byte *>(seed_tmp.constData()),
+        seed_tmp.size(), reinterpret_cast<const byte *>(counter.constData()),
+        counter.size());
+
+    if(index) {
+      MoveRngPosition(index);
+    }
+  }
+
+  void CppCtrRandom::MoveRngPosition(uint index)
+  {
+    _cipher.Seek(BytesGenerated() + index);
+    IncrementByteCount(index);
+  }
+
+  int CppCtrRandom::GetInt(int min, int max)
+  {
+    if(min == max) {
+      return min;
+    }
+
+    // CryptoPP's GenerateWord32 rejection samples over a variable number of
+    // keystream bytes, so draw whole words here instead and count every one,
+    // keeping BytesGenerated an exact keystream position for MoveRngPosition
+    quint64 range = quint64(qint64(max) - qint64(min));
+    quint64 span = Q_UINT64_C(1) << 32;
+    quint64 limit = span - (span % range);
+
+    quint64 value;
+    do {
+      byte word[4];
+      _cipher.GenerateBlock(word, sizeof(word));
+      IncrementByteCount(sizeof(word));
+      value = (quint64(word[0]) << 24) | (quint64(word[1]) << 16) |
+        (quint64(word[2]) << 8) | quint64(word[3]);
+    } while(value >= limit);
+
+    return int(qint64(min) + qint64(value % range));
+  }
+
+  void CppCtrRandom::GenerateBlock(QByteArray &data)
+  {
+    _cipher.GenerateBlock(reinterpret_cast<byte *>(data.data()), data.size());
+    IncrementByteCount(data.size());
+  }
+
+  void CppCtrRandom::XorBlock(QByteArray &data)
+  {
+    byte *bdata = reinterpret_cast<byte *>(data.data());
+    _cipher.ProcessData(bdata, bdata, data.size());
+    IncrementByteCount(data.size());
+  }
+}
+}
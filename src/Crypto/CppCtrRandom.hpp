@@ -0,0 +1,62 @@
+#ifndef DISSENT_CRYPTO_CPP_CTR_RANDOM_H_GUARD
+#define DISSENT_CRYPTO_CPP_CTR_RANDOM_H_GUARD
+
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+
+#include "Utils/Random.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  /**
+   * Seekable deterministic random number generator using AES in counter
+   * mode.  Unlike the X9.17 generator used by CppRandom, each output block
+   * is a single AES call over an independent counter, so CryptoPP can
+   * pipeline blocks (and use AES-NI when the processor supports it) and
+   * moving to an arbitrary position in the stream is constant time.
+   * Intended for bulk keystream generation such as DC-net pads.
+   */
+  class CppCtrRandom : public Utils::Random {
+    public:
+      /**
+       * Constructor
+       * @param seed the AES key, padded with zeroes or truncated to
+       * OptimalSeedSize
+       * @param index byte offset into the keystream to start from
+       */
+      explicit CppCtrRandom(const QByteArray &seed, uint index = 0);
+
+      /**
+       * Destructor
+       */
+      virtual ~CppCtrRandom() {}
+
+      /**
+       * Returns the optimal seed size, less than will provide suboptimal
+       * results and greater than will be compressed into the chosen seed.
+       */
+      static uint OptimalSeedSize() { return CryptoPP::AES::DEFAULT_KEYLENGTH; }
+
+      virtual int GetInt(int min = 0, int max = RAND_MAX);
+      virtual void GenerateBlock(QByteArray &data);
+
+      /**
+       * Xors the keystream directly into data in a single pass
+       * @param data QByteArray to xor random data into
+       */
+      virtual void XorBlock(QByteArray &data);
+
+    protected:
+      /**
+       * Moves the keystream to the specified byte offset
+       * @param index the position
+       */
+      virtual void MoveRngPosition(uint index);
+
+    private:
+      CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption _cipher;
+  };
+}
+}
+
+#endif
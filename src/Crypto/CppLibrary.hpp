@@ -1,6 +1,7 @@
 #ifndef DISSENT_CRYPTO_CPP_LIBRARY_H_GUARD
 #define DISSENT_CRYPTO_CPP_LIBRARY_H_GUARD
 
+#include "CppCtrRandom.hpp"
 #include "CppDiffieHellman.hpp"
 #include "CppHash.hpp"
 #include "CppIntegerData.hpp"
@@ -78,8 +79,12 @@ namespace Crypto {
       /**
        * Returns a deterministic random number generator
        */
-      inline virtual Dissent::Utils::Random *GetRandomNumberGenerator(const QByteArray &seed, uint index)
+      inline virtual Dissent::Utils::Random *GetRandomNumberGenerator(
+          const QByteArray &seed, uint index, RngType type)
       {
+        if(type == CounterRng && !seed.isEmpty()) {
+          return new CppCtrRandom(seed, index);
+        }
         return new CppRandom(seed, index);
       }
 
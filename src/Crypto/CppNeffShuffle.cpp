@@ -1,13 +1,97 @@
 #include <QDataStream>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include "CppDsaPrivateKey.hpp"
 #include "CppDsaPublicKey.hpp"
 #include "CppHash.hpp"
 #include "CppNeffShuffle.hpp"
 #include "CppRandom.hpp"
+#include "CryptoFactory.hpp"
 
 namespace Dissent {
 namespace Crypto {
+namespace {
+  /**
+   * A contiguous range of modular exponentiations,
+   * out[idx] = (bases ? bases[idx] : base)^exps[idx] % modulus
+   */
+  struct PowChunk {
+    const Integer *base;
+    const Integer *bases;
+    const Integer *exps;
+    const Integer *modulus;
+    Integer *out;
+    int start;
+    int end;
+  };
+
+  void PowRange(PowChunk &chunk)
+  {
+    for(int idx = chunk.start; idx < chunk.end; idx++) {
+      const Integer &base = chunk.bases ? chunk.bases[idx] : *chunk.base;
+      chunk.out[idx] = base.Pow(chunk.exps[idx], *chunk.modulus);
+    }
+  }
+
+  /**
+   * Computes the exponentiations in data-parallel chunks over the global
+   * thread pool when the CryptoFactory is multithreaded
+   */
+  QVector<Integer> ParallelPow(const Integer *base, const Integer *bases,
+      const QVector<Integer> &exps, const Integer &modulus)
+  {
+    int count = exps.size();
+    QVector<Integer> out(count);
+
+    int workers = 1;
+    if(CryptoFactory::GetInstance().GetThreadingType() ==
+        CryptoFactory::MultiThreaded)
+    {
+      workers = qMax(1, qMin(QThread::idealThreadCount(), count));
+    }
+
+    QList<PowChunk> chunks;
+    for(int idx = 0; idx < workers; idx++) {
+      PowChunk chunk;
+      chunk.base = base;
+      chunk.bases = bases;
+      chunk.exps = exps.constData();
+      chunk.modulus = &modulus;
+      chunk.out = out.data();
+      chunk.start = (count * idx) / workers;
+      chunk.end = (count * (idx + 1)) / workers;
+      chunks.append(chunk);
+    }
+
+    if(workers == 1) {
+      PowRange(chunks[0]);
+    } else {
+      QtConcurrent::blockingMap(chunks, PowRange);
+    }
+    return out;
+  }
+
+  QVector<Integer> ParallelPow(const Integer &base,
+      const QVector<Integer> &exps, const Integer &modulus)
+  {
+    return ParallelPow(&base, 0, exps, modulus);
+  }
+
+  QVector<Integer> ParallelPow(const QVector<Integer> &bases,
+      const QVector<Integer> &exps, const Integer &modulus)
+  {
+    Q_ASSERT(bases.size() == exps.size());
+    return ParallelPow(0, bases.constData(), exps, modulus);
+  }
+
+  QVector<Integer> ParallelPow(const QVector<Integer> &bases,
+      const Integer &exp, const Integer &modulus)
+  {
+    return ParallelPow(bases, QVector<Integer>(bases.size(), exp), modulus);
+  }
+}
+
   bool CppNeffShuffle::Shuffle(const QVector<QByteArray> &input,
       const QSharedPointer<AsymmetricKey> &private_key,
       const QVector<QSharedPointer<AsymmetricKey> > &remaining_keys,
@@ -66,14 +150,14 @@ namespace Crypto {
     // Rencryption
     QVector<Integer> X_bar, Y_bar;
     QVector<QPair<QByteArray, int> > sortable;
+    QVector<Integer> g_beta = ParallelPow(generator, beta, modulus);
+    QVector<Integer> h_beta = ParallelPow(h, beta, modulus);
     
     for(int idx = 0; idx < k; idx++) {
-      Integer X_bar_l = (X[idx] *
-          generator.Pow(beta[idx], modulus)) % modulus;
+      Integer X_bar_l = (X[idx] * g_beta[idx]) % modulus;
       X_bar.append(X_bar_l);
 
-      Integer Y_bar_l = (Y[idx] *
-          h.Pow(beta[idx], modulus)) % modulus;
+      Integer Y_bar_l = (Y[idx] * h_beta[idx]) % modulus;
       Y_bar.append(Y_bar_l);
 
       QByteArray toutput;
@@ -115,22 +199,32 @@ namespace Crypto {
     // Part 1 -- Generation of initial shares
 
     Integer Gamma = generator.Pow(gamma, modulus);
-    QVector<Integer> A, C, U, W;
+    QVector<Integer> gamma_w, A_pi;
     for(int idx = 0; idx < k; idx++) {
-      A.append(generator.Pow(a[idx], modulus));
-      U.append(generator.Pow(u[idx], modulus));
-      W.append(generator.Pow((gamma * w[idx]) % subgroup, modulus));
+      gamma_w.append((gamma * w[idx]) % subgroup);
     }
 
+    QVector<Integer> A = ParallelPow(generator, a, modulus);
+    QVector<Integer> U = ParallelPow(generator, u, modulus);
+    QVector<Integer> W = ParallelPow(generator, gamma_w, modulus);
+
     for(int idx = 0; idx < k; idx++) {
-      C.append(A[pi[idx]].Pow(gamma, modulus));
+      A_pi.append(A[pi[idx]]);
     }
+    QVector<Integer> C = ParallelPow(A_pi, gamma, modulus);
 
     Integer delta_sum = tau_0, x_multi = 1, y_multi = 1;
+    QVector<Integer> delta_exp;
     for(int idx = 0; idx < k; idx++) {
       delta_sum = (delta_sum + w[idx] * beta[pi[idx]]) % subgroup;
-      x_multi = (x_multi * X[idx].Pow((w[inv_pi[idx]] - u[idx]) % subgroup, modulus)) % modulus;
-      y_multi = (y_multi * Y[idx].Pow((w[inv_pi[idx]] - u[idx]) % subgroup, modulus)) % modulus;
+      delta_exp.append((w[inv_pi[idx]] - u[idx]) % subgroup);
+    }
+
+    QVector<Integer> X_delta = ParallelPow(X, delta_exp, modulus);
+    QVector<Integer> Y_delta = ParallelPow(Y, delta_exp, modulus);
+    for(int idx = 0; idx < k; idx++) {
+      x_multi = (x_multi * X_delta[idx]) % modulus;
+      y_multi = (y_multi * Y_delta[idx]) % modulus;
     }
     Integer Delta_0 = (generator.Pow(delta_sum, modulus) * x_multi) % modulus;
     Integer Delta_1 = (h.Pow(delta_sum, modulus) * y_multi) % modulus;
@@ -145,22 +239,26 @@ namespace Crypto {
     QVector<Integer> p, B;
     for(int idx = 0; idx < k; idx++) {
       p.append(rand.GetInteger(2, subgroup));
-      B.append((generator.Pow(p[idx], modulus) *
-            U[idx].ModInverse(modulus)) % modulus);
+    }
+
+    QVector<Integer> g_p = ParallelPow(generator, p, modulus);
+    for(int idx = 0; idx < k; idx++) {
+      B.append((g_p[idx] * U[idx].ModInverse(modulus)) % modulus);
     }
 
     // Part 3 -- Prover
 
-    QVector<Integer> b, d, D;
+    QVector<Integer> b, d;
     for(int idx = 0; idx < k; idx++) {
       b.append((p[idx] - u[idx]) % subgroup);
     }
 
     for(int idx = 0; idx < k; idx++) {
       d.append((gamma * b[pi[idx]]) % subgroup);
-      D.append(generator.Pow(d[idx], modulus));
     }
 
+    QVector<Integer> D = ParallelPow(generator, d, modulus);
+
     stream << D;
 
     // Part 4 -- Verifier
@@ -212,17 +310,18 @@ namespace Crypto {
       theta.append(Integer::GetRandomInteger(0, subgroup));
     }
 
-    QVector<Integer> Theta;
-    Theta.append(generator.Pow(subgroup - (theta[0] * s_t[0]) % subgroup, modulus));
+    QVector<Integer> theta_exp;
+    theta_exp.append(subgroup - (theta[0] * s_t[0]) % subgroup);
     for(int idx = 1; idx < k; idx++) {
-      Theta.append(generator.Pow((theta[idx - 1] * r_t[idx] - theta[idx] * s_t[idx]) % subgroup, modulus));
+      theta_exp.append((theta[idx - 1] * r_t[idx] - theta[idx] * s_t[idx]) % subgroup);
     }
 
     for(int idx = k; idx < (2 * k - 1); idx++) {
-      Theta.append(generator.Pow((gamma * theta[idx - 1] - theta[idx]) % subgroup, modulus));
+      theta_exp.append((gamma * theta[idx - 1] - theta[idx]) % subgroup);
     }
 
-    Theta.append(generator.Pow((gamma * theta[2 * k - 2]) % subgroup, modulus));
+    theta_exp.append((gamma * theta[2 * k - 2]) % subgroup);
+    QVector<Integer> Theta = ParallelPow(generator, theta_exp, modulus);
 
     stream << Theta;
 
@@ -259,22 +358,27 @@ namespace Crypto {
     QVector<QByteArray> decrypted;
     QVector<QPair<Integer, Integer> > decryption_proof;
 
-    foreach(const QByteArray &encrypted, output) {
-      decrypted.append(pkey->SeriesDecrypt(encrypted));
-      if(decrypted.last().isEmpty()) {
-        qDebug() << "Invalid encryption";
-        return false;
-      }
+    // X_bar and Y_bar are in output order and within the group, so
+    // decryption is Y_bar / X_bar^x
+    Integer x = pkey->GetPrivateExponent();
+    QVector<Integer> shared_x = ParallelPow(X_bar, x, modulus);
+
+    QVector<Integer> t_vals;
+    for(int idx = 0; idx < k; idx++) {
+      t_vals.append(Integer::GetRandomInteger(2, subgroup));
+    }
+    QVector<Integer> T_vals = ParallelPow(X_bar, t_vals, modulus);
 
-      QDataStream tstream(encrypted);
-      Integer shared;
-      tstream >> shared;
+    for(int idx = 0; idx < k; idx++) {
+      Integer result = (Y_bar[idx] * shared_x[idx].ModInverse(modulus)) % modulus;
+      QByteArray out;
+      QDataStream ostream(&out, QIODevice::WriteOnly);
+      ostream << X_bar[idx] << result;
+      decrypted.append(out);
 
-      Integer t = Integer::GetRandomInteger(2, subgroup);
-      Integer T = shared.Pow(t, modulus);
       Integer c = rand.GetInteger(2, subgroup);
-      Integer s = (t + c * pkey->GetPrivateExponent()) % subgroup;
-      decryption_proof.append(QPair<Integer, Integer>(T, s));
+      Integer s = (t_vals[idx] + c * x) % subgroup;
+      decryption_proof.append(QPair<Integer, Integer>(T_vals[idx], s));
     }
 
     stream << decrypted;
@@ -323,18 +427,21 @@ namespace Crypto {
       QDataStream tstream(input[idx]);
       Integer shared, enc;
       tstream >> shared >> enc;
+      X.append(shared);
+      Y.append(enc);
+    }
 
-      if(!pkey->InGroup(shared)) {
+    QVector<Integer> X_order = ParallelPow(X, subgroup, modulus);
+    QVector<Integer> Y_order = ParallelPow(Y, subgroup, modulus);
+    for(int idx = 0; idx < k; idx++) {
+      if(!(X[idx] < modulus) || X_order[idx] != 1) {
         qCritical() << "Shared" << idx << "not within group";
         return false;
       }
-      if(!pkey->InGroup(enc)) {
+      if(!(Y[idx] < modulus) || Y_order[idx] != 1) {
         qCritical() << "Encrypted" << idx << "not within group";
         return false;
       }
-
-      X.append(shared);
-      Y.append(enc);
     }
 
     // Non-interactive setup
@@ -361,6 +468,11 @@ namespace Crypto {
       qDebug() << "Output is incorrect length:" << shuffle_output.size();
       return false;
     }
+
+    if(A.size() != k || C.size() != k || U.size() != k || W.size() != k) {
+      qDebug() << "Invalid share sizes";
+      return false;
+    }
     istream << shuffle_output << Gamma << A << C << U << W << Delta_0 << Delta_1;
 
     QVector<Integer> X_bar, Y_bar;
@@ -385,8 +497,11 @@ namespace Crypto {
     QVector<Integer> p, B;
     for(int idx = 0; idx < k; idx++) {
       p.append(rand.GetInteger(2, subgroup));
-      B.append((generator.Pow(p[idx], modulus) *
-            U[idx].ModInverse(modulus)) % modulus);
+    }
+
+    QVector<Integer> g_p = ParallelPow(generator, p, modulus);
+    for(int idx = 0; idx < k; idx++) {
+      B.append((g_p[idx] * U[idx].ModInverse(modulus)) % modulus);
     }
 
     // Part 3 -- Prover
@@ -451,63 +566,68 @@ namespace Crypto {
 
     // Part 6.5 - Verifier
 
+    if(alpha.size() != 2 * k - 1 || sigma.size() != k || D.size() != k) {
+      qDebug() << "Invalid proof sizes";
+      return false;
+    }
+
     QVector<Integer> R, S, R_t, S_t;
     Integer U_ = generator.Pow(subgroup - t, modulus);
     Integer W_ = Gamma.Pow(subgroup - t, modulus);
+    QVector<Integer> B_lambda = ParallelPow(B, lambda, modulus);
+    QVector<Integer> D_lambda = ParallelPow(D, lambda, modulus);
 
     for(int idx = 0; idx < k; idx++) {
-      R.append((A[idx] * B[idx].Pow(lambda, modulus)) % modulus);
+      R.append((A[idx] * B_lambda[idx]) % modulus);
       R_t.append((R[idx] * U_) % modulus);
 
-      S.append((C[idx] * D[idx].Pow(lambda, modulus)) % modulus);
+      S.append((C[idx] * D_lambda[idx]) % modulus);
       S_t.append((S[idx] * W_) % modulus);
     }
 
-    if(Theta[0] !=
-        ((R_t[0].Pow(c, modulus) *
-         S_t[0].Pow(subgroup - alpha[0], modulus)) % modulus))
-    {
-      qDebug() << "Failed Theta[0] check";
-      return false;
+    // Theta[idx] == left_base[idx]^left_exp[idx] * right_base[idx]^right_exp[idx]
+    QVector<Integer> left_base, left_exp, right_base, right_exp;
+    for(int idx = 0; idx < k; idx++) {
+      left_base.append(R_t[idx]);
+      left_exp.append(idx == 0 ? c : alpha[idx - 1]);
+      right_base.append(S_t[idx]);
+      right_exp.append(subgroup - alpha[idx]);
     }
 
-    for(int idx = 1; idx < k; idx++) {
-      if(Theta[idx] !=
-          ((R_t[idx].Pow(alpha[idx - 1], modulus) *
-            S_t[idx].Pow(subgroup - alpha[idx], modulus)) % modulus))
-      {
-        qDebug().nospace() << "Failed Theta[" << idx <<"] check";
-        return false;
-      }
+    for(int idx = k; idx < 2 * k; idx++) {
+      left_base.append(Gamma);
+      left_exp.append(alpha[idx - 1]);
+      right_base.append(generator);
+      right_exp.append(idx < 2 * k - 1 ? subgroup - alpha[idx] : subgroup - c);
     }
 
-    for(int idx = k; idx < 2 * k - 1; idx++) {
-      if(Theta[idx] !=
-          ((Gamma.Pow(alpha[idx - 1], modulus) *
-            generator.Pow(subgroup - alpha[idx], modulus)) % modulus))
-      {
+    QVector<Integer> left = ParallelPow(left_base, left_exp, modulus);
+    QVector<Integer> right = ParallelPow(right_base, right_exp, modulus);
+    for(int idx = 0; idx < 2 * k; idx++) {
+      if(Theta[idx] != ((left[idx] * right[idx]) % modulus)) {
         qDebug().nospace() << "Failed Theta[" << idx <<"] check";
         return false;
       }
     }
 
-    if(Theta[2 * k - 1] !=
-        ((Gamma.Pow(alpha[2 * k - 2], modulus) *
-          generator.Pow(subgroup - c, modulus)) % modulus))
-    {
-      qDebug().nospace() << "Failed Theta[" << (2 * k - 1) <<"] check";
-      return false;
+    // Part 7 -- Verifier
+
+    QVector<Integer> neg_p;
+    for(int idx = 0; idx < k; idx++) {
+      neg_p.append(subgroup - p[idx]);
     }
 
-    // Part 7 -- Verifier
+    QVector<Integer> X_bar_sigma = ParallelPow(X_bar, sigma, modulus);
+    QVector<Integer> X_p = ParallelPow(X, neg_p, modulus);
+    QVector<Integer> Y_bar_sigma = ParallelPow(Y_bar, sigma, modulus);
+    QVector<Integer> Y_p = ParallelPow(Y, neg_p, modulus);
+    QVector<Integer> Gamma_sigma = ParallelPow(Gamma, sigma, modulus);
 
     Integer iota_0 = 1, iota_1 = 1;
     for(int idx = 0; idx < k; idx++) {
-      iota_0 = (iota_0 * X_bar[idx].Pow(sigma[idx], modulus) *
-          X[idx].Pow(subgroup - p[idx], modulus)) % modulus;
-      iota_1 = (iota_1 * Y_bar[idx].Pow(sigma[idx], modulus) *
-          Y[idx].Pow(subgroup - p[idx], modulus)) % modulus;
-      if(Gamma.Pow(sigma[idx], modulus) != ((W[idx] * D[idx]) % modulus)) {
+      iota_0 = (iota_0 * X_bar_sigma[idx] * X_p[idx]) % modulus;
+      iota_1 = (iota_1 * Y_bar_sigma[idx] * Y_p[idx]) % modulus;
+      if(Gamma_sigma[idx] != ((W[idx] * D[idx]) % modulus)) {
         qDebug().nospace() << "Failed sigma[" << idx << "] check";
         return false;
       }
@@ -542,6 +662,7 @@ namespace Crypto {
     cseed = hash.ComputeHash(proof);
     rand = CppRandom(cseed);
 
+    QVector<Integer> shared, pair, dec_s, dec_c;
     for(int idx = 0; idx < k; idx++) {
       QDataStream tstream_in(shuffle_output[idx]);
       Integer shared_in, secret_in;
@@ -551,16 +672,22 @@ namespace Crypto {
       Integer shared_out, secret_out;
       tstream_out >> shared_out >> secret_out;
 
-      Integer pair = (secret_in * secret_out.ModInverse(modulus)) % modulus;
-      Integer T = decryption_proof[idx].first;
-      Integer s = decryption_proof[idx].second;
-      Integer c = rand.GetInteger(2, subgroup);
       if(shared_in != shared_out) {
         qDebug() << "Decryption error";
         return false;
       }
 
-      if(shared_out.Pow(s, modulus) != ((T * pair.Pow(c, modulus)) % modulus)) {
+      shared.append(shared_out);
+      pair.append((secret_in * secret_out.ModInverse(modulus)) % modulus);
+      dec_s.append(decryption_proof[idx].second);
+      dec_c.append(rand.GetInteger(2, subgroup));
+    }
+
+    QVector<Integer> shared_s = ParallelPow(shared, dec_s, modulus);
+    QVector<Integer> pair_c = ParallelPow(pair, dec_c, modulus);
+    for(int idx = 0; idx < k; idx++) {
+      Integer T = decryption_proof[idx].first;
+      if(shared_s[idx] != ((T * pair_c[idx]) % modulus)) {
         qDebug() << "Invalid decryption proof";
         return false;
       }
@@ -569,5 +696,25 @@ namespace Crypto {
     output = decrypted;
     return true;
   }
+
+  bool CppNeffShuffle::GetOutput(const QByteArray &proof,
+      QVector<QByteArray> &output)
+  {
+    QDataStream stream(proof);
+    QVector<QByteArray> shuffle_output, decrypted;
+    Integer Gamma, Delta_0, Delta_1, tau;
+    QVector<Integer> A, C, U, W, D, sigma, Theta, alpha;
+
+    stream >> shuffle_output >> Gamma >> A >> C >> U >> W >> Delta_0 >>
+      Delta_1 >> D >> tau >> sigma >> Theta >> alpha >> decrypted;
+    if(stream.status() != QDataStream::Ok ||
+        decrypted.size() != shuffle_output.size())
+    {
+      return false;
+    }
+
+    output = decrypted;
+    return true;
+  }
 }
 }
@@ -42,6 +42,15 @@ namespace Crypto {
           const QVector<QSharedPointer<AsymmetricKey> > &keys,
           const QByteArray &input_proof,
           QVector<QByteArray> &output);
+
+      /**
+       * Returns the output claimed by a transcript without verifying it,
+       * allowing the next transcript in a cascade to be verified before this
+       * one has been
+       * @param proof a transcript produced by Shuffle
+       * @param output the claimed shuffled and decrypted messages
+       */
+      bool GetOutput(const QByteArray &proof, QVector<QByteArray> &output);
   };
 }
 }
@@ -0,0 +1,722 @@
+#include <QDataStream>
+#include <QDebug>
+
+#include "CppHash.hpp"
+#include "CppRandom.hpp"
+#include "GroupNeffShuffle.hpp"
+
+namespace Dissent {
+namespace Crypto {
+namespace {
+  typedef GroupNeffShuffle::Element Element;
+  typedef GroupNeffShuffle::AbstractGroup Group;
+  typedef Dissent::Crypto::AbstractGroup::FixedBase FixedBase;
+
+  QVector<QByteArray> ToByteArrays(const QSharedPointer<Group> &group,
+      const QVector<Element> &elements)
+  {
+    QVector<QByteArray> bytes;
+    foreach(const Element &element, elements) {
+      bytes.append(group->ElementToByteArray(element));
+    }
+    return bytes;
+  }
+
+  bool FromByteArrays(const QSharedPointer<Group> &group,
+      const QVector<QByteArray> &bytes, QVector<Element> &elements)
+  {
+    elements.clear();
+    foreach(const QByteArray &data, bytes) {
+      Element element = group->ElementFromByteArray(data);
+      if(!group->IsElement(element)) {
+        return false;
+      }
+      elements.append(element);
+    }
+    return true;
+  }
+
+  bool FromByteArray(const QSharedPointer<Group> &group,
+      const QByteArray &bytes, Element &element)
+  {
+    element = group->ElementFromByteArray(bytes);
+    return group->IsElement(element);
+  }
+}
+
+  GroupNeffShuffle::GroupNeffShuffle(const QSharedPointer<AbstractGroup> &group) :
+    _group(group)
+  {
+  }
+
+  bool GroupNeffShuffle::ParseCiphertext(const QByteArray &data,
+      Element &shared, Element &encrypted) const
+  {
+    QByteArray bshared, bencrypted;
+    QDataStream stream(data);
+    stream >> bshared >> bencrypted;
+    return FromByteArray(_group, bshared, shared) &&
+      FromByteArray(_group, bencrypted, encrypted);
+  }
+
+  QByteArray GroupNeffShuffle::SerializeCiphertext(const Element &shared,
+      const Element &encrypted) const
+  {
+    QByteArray out;
+    QDataStream stream(&out, QIODevice::WriteOnly);
+    stream << _group->ElementToByteArray(shared) <<
+      _group->ElementToByteArray(encrypted);
+    return out;
+  }
+
+  QByteArray GroupNeffShuffle::SeriesEncrypt(const QVector<Element> &keys,
+      const QByteArray &data) const
+  {
+    if(keys.size() == 0) {
+      qCritical() << "Attempting to encrypt with 0 keys";
+      return QByteArray();
+    } else if(data.size() > _group->BytesPerElement()) {
+      qWarning() << "Unable to encrypt due to group limitations";
+      return QByteArray();
+    }
+
+    Element h = _group->GetIdentity();
+    foreach(const Element &key, keys) {
+      if(!_group->IsElement(key)) {
+        qDebug() << "Invalid key";
+      }
+      h = _group->Multiply(h, key);
+    }
+
+    Integer secret = _group->RandomExponent();
+    Element shared = _group->Exponentiate(_group->GetGenerator(), secret);
+    Element encrypted = _group->Multiply(_group->EncodeBytes(data),
+        _group->Exponentiate(h, secret));
+    return SerializeCiphertext(shared, encrypted);
+  }
+
+  QByteArray GroupNeffShuffle::SeriesDecrypt(const Integer &private_key,
+      const QByteArray &data) const
+  {
+    Element shared, encrypted;
+    if(!ParseCiphertext(data, shared, encrypted)) {
+      qCritical() << "Ciphertext elements are not within the group";
+      return QByteArray();
+    }
+
+    Element result = _group->Multiply(encrypted,
+        _group->Inverse(_group->Exponentiate(shared, private_key)));
+    return SerializeCiphertext(shared, result);
+  }
+
+  QByteArray GroupNeffShuffle::SeriesDecryptFinish(const QByteArray &data) const
+  {
+    Element shared, encrypted;
+    if(!ParseCiphertext(data, shared, encrypted)) {
+      return QByteArray();
+    }
+
+    QByteArray output;
+    if(_group->DecodeBytes(encrypted, output)) {
+      return output;
+    }
+    return QByteArray();
+  }
+
+  bool GroupNeffShuffle::InGroup(const QByteArray &data) const
+  {
+    Element shared, encrypted;
+    return ParseCiphertext(data, shared, encrypted);
+  }
+
+  bool GroupNeffShuffle::Shuffle(const QVector<QByteArray> &input,
+      const Integer &private_key,
+      const QVector<Element> &remaining_keys,
+      QVector<QByteArray> &output,
+      QByteArray &proof) const
+  {
+    // Setup
+    int k = input.size();
+    QVector<Element> X, Y;
+    for(int idx = 0; idx < input.size(); idx++) {
+      Element shared, enc;
+      if(!ParseCiphertext(input[idx], shared, enc)) {
+        qCritical() << "Input" << idx << "not within group";
+        return false;
+      }
+      X.append(shared);
+      Y.append(enc);
+    }
+
+    Integer subgroup = _group->GetOrder();
+    Element generator = _group->GetGenerator();
+    Element h = _group->Exponentiate(generator, private_key);
+    foreach(const Element &key, remaining_keys) {
+      h = _group->Multiply(h, key);
+    }
+    FixedBase fixed_h = _group->PrecomputeFixedBase(h);
+
+    // Non-interactive setup
+    proof.clear();
+    QDataStream stream(&proof, QIODevice::WriteOnly);
+    CppHash hash;
+    foreach(const QByteArray &in, input) {
+      hash.Update(in);
+    }
+    QByteArray base_seed = hash.ComputeHash();
+    QByteArray cseed;
+    CppRandom rand;
+
+    // Reencryption betas
+    QVector<Integer> beta;
+    for(int idx = 0; idx < k; idx++) {
+      beta.append(Integer::GetRandomInteger(2, subgroup));
+    }
+
+    // Rencryption
+    QVector<Element> X_bar, Y_bar;
+    QVector<QPair<QByteArray, int> > sortable;
+
+    for(int idx = 0; idx < k; idx++) {
+      Element X_bar_l = _group->Multiply(X[idx],
+          _group->Exponentiate(generator, beta[idx]));
+      X_bar.append(X_bar_l);
+
+      Element Y_bar_l = _group->Multiply(Y[idx],
+          _group->FixedBaseExponentiate(fixed_h, beta[idx]));
+      Y_bar.append(Y_bar_l);
+
+      sortable.append(QPair<QByteArray, int>(
+            SerializeCiphertext(X_bar_l, Y_bar_l), idx));
+    }
+
+    // Mixxing
+    qSort(sortable);
+
+    QVector<int> pi(k), inv_pi(k);
+    output.clear();
+    for(int idx = 0; idx < k; idx++) {
+      pi[idx] = sortable[idx].second;
+      inv_pi[sortable[idx].second] = idx;
+      output.append(sortable[idx].first);
+    }
+
+    // Part 0 -- Generation of secrets
+
+    QVector<Integer> u, w, a;
+    for(int idx = 0; idx < k; idx++) {
+      u.append(Integer::GetRandomInteger(2, subgroup));
+      w.append(Integer::GetRandomInteger(2, subgroup));
+      a.append(Integer::GetRandomInteger(2, subgroup));
+    }
+
+    Integer gamma = Integer::GetRandomInteger(2, subgroup);
+    Integer tau_0 = Integer::GetRandomInteger(2, subgroup);
+
+    // Part 1 -- Generation of initial shares
+
+    Element Gamma = _group->Exponentiate(generator, gamma);
+    QVector<Element> A, C, U, W;
+    for(int idx = 0; idx < k; idx++) {
+      A.append(_group->Exponentiate(generator, a[idx]));
+      U.append(_group->Exponentiate(generator, u[idx]));
+      W.append(_group->Exponentiate(generator, (gamma * w[idx]) % subgroup));
+    }
+
+    for(int idx = 0; idx < k; idx++) {
+      C.append(_group->Exponentiate(A[pi[idx]], gamma));
+    }
+
+    Integer delta_sum = tau_0;
+    QList<Element> x_bases = X.toList(), y_bases = Y.toList();
+    QList<Integer> xy_exps;
+    for(int idx = 0; idx < k; idx++) {
+      delta_sum = (delta_sum + w[idx] * beta[pi[idx]]) % subgroup;
+      xy_exps.append((w[inv_pi[idx]] - u[idx]) % subgroup);
+    }
+    Element Delta_0 = _group->Multiply(_group->Exponentiate(generator, delta_sum),
+        _group->MultiExponentiate(x_bases, xy_exps));
+    Element Delta_1 = _group->Multiply(_group->FixedBaseExponentiate(fixed_h, delta_sum),
+        _group->MultiExponentiate(y_bases, xy_exps));
+
+    stream << output << _group->ElementToByteArray(Gamma) <<
+      ToByteArrays(_group, A) << ToByteArrays(_group, C) <<
+      ToByteArrays(_group, U) << ToByteArrays(_group, W) <<
+      _group->ElementToByteArray(Delta_0) << _group->ElementToByteArray(Delta_1);
+
+    // Part 2 -- Non-Interactive Verifier
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    QVector<Integer> p;
+    for(int idx = 0; idx < k; idx++) {
+      p.append(rand.GetInteger(2, subgroup));
+    }
+
+    // Part 3 -- Prover
+
+    QVector<Integer> b, d;
+    QVector<Element> D;
+    for(int idx = 0; idx < k; idx++) {
+      b.append((p[idx] - u[idx]) % subgroup);
+    }
+
+    for(int idx = 0; idx < k; idx++) {
+      d.append((gamma * b[pi[idx]]) % subgroup);
+      D.append(_group->Exponentiate(generator, d[idx]));
+    }
+
+    stream << ToByteArrays(_group, D);
+
+    // Part 4 -- Verifier
+
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    Integer lambda = rand.GetInteger(2, subgroup);
+
+    // Part 5 -- Prover
+
+    QVector<Integer> r, s, sigma;
+    Integer tau = subgroup - tau_0;
+
+    for(int idx = 0; idx < k; idx++) {
+      r.append((a[idx] + lambda * b[idx]) % subgroup);
+    }
+
+    for(int idx = 0; idx < k; idx++) {
+      s.append((gamma * r[pi[idx]]) % subgroup);
+      sigma.append((w[idx] + b[pi[idx]]) % subgroup);
+      tau = (tau + b[idx] * beta[idx]) % subgroup;
+    }
+
+    stream << tau << sigma;
+
+    // Part 6 -- SimpleKShuffle (R, S, G, Gamma)
+
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    // Part 6.1 - Verifier Challenger
+
+    Integer t = rand.GetInteger(2, subgroup);
+
+    // Part 6.2
+
+    QVector<Integer> r_t, s_t;
+
+    for(int idx = 0; idx < k; idx++) {
+      r_t.append((r[idx] - t) % subgroup);
+      s_t.append((s[idx] - (gamma * t)) % subgroup);
+    }
+
+    QVector<Integer> theta;
+
+    for(int idx = 0; idx < (2 * k) - 1; idx++) {
+      theta.append(Integer::GetRandomInteger(0, subgroup));
+    }
+
+    QVector<Element> Theta;
+    Theta.append(_group->Exponentiate(generator,
+          subgroup - (theta[0] * s_t[0]) % subgroup));
+    for(int idx = 1; idx < k; idx++) {
+      Theta.append(_group->Exponentiate(generator,
+            (theta[idx - 1] * r_t[idx] - theta[idx] * s_t[idx]) % subgroup));
+    }
+
+    for(int idx = k; idx < (2 * k - 1); idx++) {
+      Theta.append(_group->Exponentiate(generator,
+            (gamma * theta[idx - 1] - theta[idx]) % subgroup));
+    }
+
+    Theta.append(_group->Exponentiate(generator,
+          (gamma * theta[2 * k - 2]) % subgroup));
+
+    stream << ToByteArrays(_group, Theta);
+
+    // Part 6.3 - Verifier
+
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    Integer c = rand.GetInteger(2, subgroup);
+
+    // Part 6.4 - Prover
+
+    QVector<Integer> alpha;
+
+    Integer s_r_multi = c;
+    for(int idx = 0 ; idx <  k; idx++) {
+      s_r_multi = (s_r_multi * r_t[idx] * s_t[idx].ModInverse(subgroup)) % subgroup;
+      alpha.append((theta[idx] + s_r_multi) % subgroup);
+    }
+
+    Integer inv_gamma = gamma.ModInverse(subgroup);
+    for(int idx = k; idx < (2 * k - 1); idx++) {
+      alpha.append((theta[idx] + c * inv_gamma.Pow(2 * k - idx - 1, subgroup)) % subgroup);
+    }
+
+    stream << alpha;
+
+    // Part 8 Verifiable decryption
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    QVector<QByteArray> decrypted;
+    QVector<QPair<QByteArray, Integer> > decryption_proof;
+
+    foreach(const QByteArray &encrypted, output) {
+      decrypted.append(SeriesDecrypt(private_key, encrypted));
+      if(decrypted.last().isEmpty()) {
+        qDebug() << "Invalid encryption";
+        return false;
+      }
+
+      Element shared, enc;
+      ParseCiphertext(encrypted, shared, enc);
+
+      Integer t = Integer::GetRandomInteger(2, subgroup);
+      Element T = _group->Exponentiate(shared, t);
+      Integer c = rand.GetInteger(2, subgroup);
+      Integer s = (t + c * private_key) % subgroup;
+      decryption_proof.append(QPair<QByteArray, Integer>(
+            _group->ElementToByteArray(T), s));
+    }
+
+    stream << decrypted;
+    stream << decryption_proof;
+    return true;
+  }
+
+  bool GroupNeffShuffle::Verify(const QVector<QByteArray> &input,
+      const QVector<Element> &keys,
+      const QByteArray &input_proof,
+      QVector<QByteArray> &output) const
+  {
+    if(keys.size() < 1) {
+      qCritical() << "Needs at least 1 public key";
+      return false;
+    }
+
+    int k = input.size();
+    Integer subgroup = _group->GetOrder();
+    Element generator = _group->GetGenerator();
+    Element h = _group->GetIdentity();
+    foreach(const Element &key, keys) {
+      if(!_group->IsElement(key)) {
+        qCritical() << "Key not within group";
+        return false;
+      }
+      h = _group->Multiply(h, key);
+    }
+
+    QVector<Element> X, Y;
+    for(int idx = 0; idx < input.size(); idx++) {
+      Element shared, enc;
+      if(!ParseCiphertext(input[idx], shared, enc)) {
+        qCritical() << "Input" << idx << "not within group";
+        return false;
+      }
+
+      X.append(shared);
+      Y.append(enc);
+    }
+
+    // Non-interactive setup
+    QDataStream ostream(input_proof);
+    QByteArray proof;
+    QDataStream istream(&proof, QIODevice::WriteOnly);
+    CppHash hash;
+    foreach(const QByteArray &in, input) {
+      hash.Update(in);
+    }
+    QByteArray base_seed = hash.ComputeHash();
+    QByteArray cseed;
+    CppRandom rand;
+
+    // Part 1 -- Generation of initial shares
+
+    QVector<QByteArray> shuffle_output;
+    QByteArray bGamma, bDelta_0, bDelta_1;
+    QVector<QByteArray> bA, bC, bU, bW;
+
+    ostream >> shuffle_output >> bGamma >> bA >> bC >> bU >> bW >>
+      bDelta_0 >> bDelta_1;
+    if(shuffle_output.size() != k) {
+      qDebug() << "Output is incorrect length:" << shuffle_output.size();
+      return false;
+    }
+    istream << shuffle_output << bGamma << bA << bC << bU << bW <<
+      bDelta_0 << bDelta_1;
+
+    Element Gamma, Delta_0, Delta_1;
+    QVector<Element> A, C, U, W;
+    if(!FromByteArray(_group, bGamma, Gamma) ||
+        !FromByteArray(_group, bDelta_0, Delta_0) ||
+        !FromByteArray(_group, bDelta_1, Delta_1) ||
+        !FromByteArrays(_group, bA, A) || A.size() != k ||
+        !FromByteArrays(_group, bC, C) || C.size() != k ||
+        !FromByteArrays(_group, bU, U) || U.size() != k ||
+        !FromByteArrays(_group, bW, W) || W.size() != k)
+    {
+      qDebug() << "Invalid initial shares";
+      return false;
+    }
+
+    QVector<Element> X_bar, Y_bar;
+    for(int idx = 0; idx < input.size(); idx++) {
+      if(idx > 0 && shuffle_output[idx - 1] > shuffle_output[idx]) {
+        qDebug() << "Output is not sorted as expected";
+        return false;
+      }
+
+      Element shared, enc;
+      if(!ParseCiphertext(shuffle_output[idx], shared, enc)) {
+        qDebug() << "Output" << idx << "not within group";
+        return false;
+      }
+      X_bar.append(shared);
+      Y_bar.append(enc);
+    }
+
+    // Part 2 -- Non-Interactive Verifier
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    QVector<Integer> p;
+    QVector<Element> B;
+    for(int idx = 0; idx < k; idx++) {
+      p.append(rand.GetInteger(2, subgroup));
+      B.append(_group->Multiply(_group->Exponentiate(generator, p[idx]),
+            _group->Inverse(U[idx])));
+    }
+
+    // Part 3 -- Prover
+
+    QVector<QByteArray> bD;
+    ostream >> bD;
+    istream << bD;
+
+    QVector<Element> D;
+    if(!FromByteArrays(_group, bD, D) || D.size() != k) {
+      qDebug() << "Invalid D";
+      return false;
+    }
+
+    // Part 4 -- Verifier
+
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    Integer lambda = rand.GetInteger(2, subgroup);
+
+    // Part 5 -- Prover
+
+    Integer tau;
+    QVector<Integer> sigma;
+
+    ostream >> tau >> sigma;
+    istream << tau << sigma;
+
+    if(sigma.size() != k) {
+      qDebug() << "Invalid sigma size";
+      return false;
+    }
+
+    // Part 6 -- SimpleKShuffle (R, S, G, Gamma)
+
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    // Part 6.1 - Verifier Challenger
+
+    Integer t = rand.GetInteger(2, subgroup);
+
+    // Part 6.2
+
+    QVector<QByteArray> bTheta;
+    ostream >> bTheta;
+    istream << bTheta;
+
+    QVector<Element> Theta;
+    if(!FromByteArrays(_group, bTheta, Theta) || Theta.size() != 2 * k) {
+      qDebug() << "Invalid Theta size";
+      return false;
+    }
+
+    // Part 6.3 - Verifier
+
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    Integer c = rand.GetInteger(2, subgroup);
+
+    // Part 6.4 - Prover
+
+    QVector<Integer> alpha;
+
+    ostream >> alpha;
+    istream << alpha;
+
+    if(alpha.size() != 2 * k - 1) {
+      qDebug() << "Invalid alpha size";
+      return false;
+    }
+
+    // Part 6.5 - Verifier
+
+    QVector<Element> R_t, S_t;
+    Element U_ = _group->Exponentiate(generator, subgroup - t);
+    Element W_ = _group->Exponentiate(Gamma, subgroup - t);
+
+    for(int idx = 0; idx < k; idx++) {
+      Element R = _group->Multiply(A[idx], _group->Exponentiate(B[idx], lambda));
+      R_t.append(_group->Multiply(R, U_));
+
+      Element S = _group->Multiply(C[idx], _group->Exponentiate(D[idx], lambda));
+      S_t.append(_group->Multiply(S, W_));
+    }
+
+    if(Theta[0] != _group->CascadeExponentiate(R_t[0], c,
+          S_t[0], subgroup - alpha[0]))
+    {
+      qDebug() << "Failed Theta[0] check";
+      return false;
+    }
+
+    for(int idx = 1; idx < k; idx++) {
+      if(Theta[idx] != _group->CascadeExponentiate(R_t[idx], alpha[idx - 1],
+            S_t[idx], subgroup - alpha[idx]))
+      {
+        qDebug().nospace() << "Failed Theta[" << idx <<"] check";
+        return false;
+      }
+    }
+
+    for(int idx = k; idx < 2 * k - 1; idx++) {
+      if(Theta[idx] != _group->CascadeExponentiate(Gamma, alpha[idx - 1],
+            generator, subgroup - alpha[idx]))
+      {
+        qDebug().nospace() << "Failed Theta[" << idx <<"] check";
+        return false;
+      }
+    }
+
+    if(Theta[2 * k - 1] != _group->CascadeExponentiate(Gamma, alpha[2 * k - 2],
+          generator, subgroup - c))
+    {
+      qDebug().nospace() << "Failed Theta[" << (2 * k - 1) <<"] check";
+      return false;
+    }
+
+    // Part 7 -- Verifier
+
+    QList<Element> x_bases, y_bases;
+    QList<Integer> exps;
+    for(int idx = 0; idx < k; idx++) {
+      x_bases.append(X_bar[idx]);
+      x_bases.append(X[idx]);
+      y_bases.append(Y_bar[idx]);
+      y_bases.append(Y[idx]);
+      exps.append(sigma[idx]);
+      exps.append(subgroup - p[idx]);
+
+      if(_group->Exponentiate(Gamma, sigma[idx]) !=
+          _group->Multiply(W[idx], D[idx]))
+      {
+        qDebug().nospace() << "Failed sigma[" << idx << "] check";
+        return false;
+      }
+    }
+
+    Element iota_0 = _group->MultiExponentiate(x_bases, exps);
+    if(iota_0 != _group->Multiply(Delta_0, _group->Exponentiate(generator, tau))) {
+      qDebug() << "Failed Iota_0 check";
+      return false;
+    }
+
+    Element iota_1 = _group->MultiExponentiate(y_bases, exps);
+    if(iota_1 != _group->Multiply(Delta_1, _group->Exponentiate(h, tau))) {
+      qDebug() << "Failed Iota_1 check";
+      return false;
+    }
+
+    // Part 8 -- Verifying Decryption
+    QVector<QByteArray> decrypted;
+    QVector<QPair<QByteArray, Integer> > decryption_proof;
+    ostream >> decrypted >> decryption_proof;
+    if(decrypted.size() != k) {
+      qCritical() << "Decrypted size != k";
+      return false;
+    }
+
+    if(decryption_proof.size() != k) {
+      qCritical() << "Decryption proof size != k";
+      return false;
+    }
+
+    hash.Update(base_seed);
+    cseed = hash.ComputeHash(proof);
+    rand = CppRandom(cseed);
+
+    for(int idx = 0; idx < k; idx++) {
+      Element shared_out, secret_out, T;
+      if(!ParseCiphertext(decrypted[idx], shared_out, secret_out) ||
+          !FromByteArray(_group, decryption_proof[idx].first, T))
+      {
+        qDebug() << "Decryption not within group";
+        return false;
+      }
+
+      Element pair = _group->Multiply(Y_bar[idx], _group->Inverse(secret_out));
+      Integer s = decryption_proof[idx].second;
+      Integer c = rand.GetInteger(2, subgroup);
+      if(X_bar[idx] != shared_out) {
+        qDebug() << "Decryption error";
+        return false;
+      }
+
+      if(_group->Exponentiate(shared_out, s) !=
+          _group->Multiply(T, _group->Exponentiate(pair, c)))
+      {
+        qDebug() << "Invalid decryption proof";
+        return false;
+      }
+    }
+
+    output = decrypted;
+    return true;
+  }
+
+  bool GroupNeffShuffle::GetOutput(const QByteArray &proof,
+      QVector<QByteArray> &output) const
+  {
+    QDataStream stream(proof);
+    QVector<QByteArray> shuffle_output, decrypted;
+    QByteArray Gamma, Delta_0, Delta_1;
+    QVector<QByteArray> A, C, U, W, D, Theta;
+    Integer tau;
+    QVector<Integer> sigma, alpha;
+
+    stream >> shuffle_output >> Gamma >> A >> C >> U >> W >> Delta_0 >>
+      Delta_1 >> D >> tau >> sigma >> Theta >> alpha >> decrypted;
+    if(stream.status() != QDataStream::Ok ||
+        decrypted.size() != shuffle_output.size())
+    {
+      return false;
+    }
+
+    output = decrypted;
+    return true;
+  }
+}
+}
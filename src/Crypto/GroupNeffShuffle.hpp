@@ -0,0 +1,123 @@
+#ifndef DISSENT_CRYPTO_GROUP_NEFF_SHUFFLE_H_GUARD
+#define DISSENT_CRYPTO_GROUP_NEFF_SHUFFLE_H_GUARD
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "AbstractGroup/AbstractGroup.hpp"
+#include "AbstractGroup/Element.hpp"
+#include "Integer.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  /**
+   * A non-interactive verifiable Neff Mix with verifiable decryption over
+   * any AbstractGroup, such as an elliptic curve.  Messages are ElGamal
+   * ciphertexts, serialized pairs of elements (shared, encrypted), where
+   * encrypted is the message element times the product of all remaining
+   * public keys raised to the shared secret.  Private keys are exponents and
+   * public keys are the generator raised to the private key.  Each message
+   * must fit into a single element, see AbstractGroup::BytesPerElement.
+   */
+  class GroupNeffShuffle {
+    public:
+      typedef Dissent::Crypto::AbstractGroup::Element Element;
+      typedef Dissent::Crypto::AbstractGroup::AbstractGroup AbstractGroup;
+
+      /**
+       * Constructor
+       * @param group the group used for keys and ciphertexts
+       */
+      explicit GroupNeffShuffle(const QSharedPointer<AbstractGroup> &group);
+
+      /**
+       * Returns the group used for keys and ciphertexts
+       */
+      QSharedPointer<AbstractGroup> GetGroup() const { return _group; }
+
+      /**
+       * Encrypts data once under the product of the keys, so that each
+       * key holder can remove a single layer
+       * @param keys the public keys to encrypt serially with
+       * @param data the data to encrypt, must fit into a single element
+       * @returns the ciphertext or an empty array on failure
+       */
+      QByteArray SeriesEncrypt(const QVector<Element> &keys,
+          const QByteArray &data) const;
+
+      /**
+       * Removes a single layer of encryption, leaving the shared and
+       * encrypted pair
+       * @param private_key the private key for the layer
+       * @param data the ciphertext
+       * @returns the ciphertext with one fewer layer or empty on failure
+       */
+      QByteArray SeriesDecrypt(const Integer &private_key,
+          const QByteArray &data) const;
+
+      /**
+       * Returns the data in a ciphertext whose layers have all been removed
+       * @param data the ciphertext
+       * @returns the data or empty on failure
+       */
+      QByteArray SeriesDecryptFinish(const QByteArray &data) const;
+
+      /**
+       * Returns true if data is a ciphertext of elements within the group
+       * @param data the ciphertext
+       */
+      bool InGroup(const QByteArray &data) const;
+
+      /**
+       * Performs a non-interactive verifiable Neff Mix
+       * with a verifiable decryption.
+       * @param input the messages to be shuffled
+       * @param private_key the private key used for decrypting a layer of encryption
+       * @param remaining_keys the keys for the remaining shufflers
+       * @param output shuffled and decrypted messages
+       * @param proof a transcript that shows the output is a verifiably
+       * decrypted and shuffled version of the input
+       */
+      bool Shuffle(const QVector<QByteArray> &input,
+          const Integer &private_key,
+          const QVector<Element> &remaining_keys,
+          QVector<QByteArray> &output,
+          QByteArray &proof) const;
+
+      /**
+       * Performs a non-interactive verification of a Neff Mix
+       * and verifiable decryption.
+       * @param input the messages to be shuffled
+       * @param keys the keys for the shufflers and the remaining shufflers
+       * @param input_proof a transcript that shows the output is a verifiably
+       * decrypted and shuffled version of the input
+       * @param output shuffled and decrypted messages
+       */
+      bool Verify(const QVector<QByteArray> &input,
+          const QVector<Element> &keys,
+          const QByteArray &input_proof,
+          QVector<QByteArray> &output) const;
+
+      /**
+       * Returns the output claimed by a transcript without verifying it,
+       * allowing the next transcript in a cascade to be verified before this
+       * one has been
+       * @param proof a transcript produced by Shuffle
+       * @param output the claimed shuffled and decrypted messages
+       */
+      bool GetOutput(const QByteArray &proof, QVector<QByteArray> &output) const;
+
+    private:
+      bool ParseCiphertext(const QByteArray &data, Element &shared,
+          Element &encrypted) const;
+
+      QByteArray SerializeCiphertext(const Element &shared,
+          const Element &encrypted) const;
+
+      QSharedPointer<AbstractGroup> _group;
+  };
+}
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include "CryptoFactory.hpp"
+#include "Hmac.hpp"
+
+namespace Dissent {
+namespace Crypto {
+  Hmac::Hmac(const QByteArray &key, QSharedPointer<Hash> hash) :
+    _hash(hash)
+  {
+    if(!_hash) {
+      Library *lib = CryptoFactory::GetInstance().GetLibrary();
+      _hash = QSharedPointer<Hash>(lib->GetHashAlgorithm());
+    }
+
+    QByteArray block = key;
+    if(block.size() > BlockSize) {
+      block = _hash->ComputeHash(block);
+    }
+    block.append(QByteArray(BlockSize - block.size(), 0));
+
+    _ipad = QByteArray(BlockSize, 0);
+    _opad = QByteArray(BlockSize, 0);
+    for(int idx = 0; idx < BlockSize; idx++) {
+      _ipad[idx] = block[idx] ^ 0x36;
+      _opad[idx] = block[idx] ^ 0x5c;
+    }
+  }
+
+  QByteArray Hmac::ComputeMac(const QByteArray &data) const
+  {
+    _hash->Restart();
+    _hash->Update(_ipad);
+    _hash->Update(data);
+    QByteArray inner = _hash->ComputeHash();
+
+    _hash->Update(_opad);
+    _hash->Update(inner);
+    return _hash->ComputeHash();
+  }
+
+  bool Hmac::VerifyMac(const QByteArray &data, const QByteArray &mac) const
+  {
+    QByteArray expected = ComputeMac(data);
+    if(expected.size() != mac.size()) {
+      return false;
+    }
+
+    // Constant time, so a forger learns nothing from the timing
+    char diff = 0;
+    for(int idx = 0; idx < expected.size(); idx++) {
+      diff |= expected[idx] ^ mac[idx];
+    }
+    return diff == 0;
+  }
+}
+}
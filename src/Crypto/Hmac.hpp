@@ -0,0 +1,58 @@
+#ifndef DISSENT_CRYPTO_HMAC_H_GUARD
+#define DISSENT_CRYPTO_HMAC_H_GUARD
+
+#include <QByteArray>
+#include <QSharedPointer>
+
+#include "Hash.hpp"
+
+namespace Dissent {
+namespace Crypto {
+
+  /**
+   * HMAC (RFC 2104) over the library's hash algorithm.  Unlike a signature,
+   * a MAC convinces only the holder of the key, so it cannot be forwarded
+   * as evidence to a third party.
+   */
+  class Hmac {
+    public:
+      /**
+       * Input block size of the supported hash functions (SHA-1 / SHA-2)
+       */
+      static const int BlockSize = 64;
+
+      /**
+       * Constructor
+       * @param key the secret key
+       * @param hash the hash algorithm, the library's default if NULL
+       */
+      explicit Hmac(const QByteArray &key,
+          QSharedPointer<Hash> hash = QSharedPointer<Hash>());
+
+      /**
+       * Returns the length of a MAC
+       */
+      int GetMacLength() const { return _hash->GetDigestSize(); }
+
+      /**
+       * Returns the MAC of the data
+       * @param data the data to authenticate
+       */
+      QByteArray ComputeMac(const QByteArray &data) const;
+
+      /**
+       * Returns true if mac is the MAC of the data
+       * @param data the authenticated data
+       * @param mac the MAC to check
+       */
+      bool VerifyMac(const QByteArray &data, const QByteArray &mac) const;
+
+    private:
+      QSharedPointer<Hash> _hash;
+      QByteArray _ipad;
+      QByteArray _opad;
+  };
+}
+}
+
+#endif
@@ -11,6 +11,16 @@ namespace Dissent {
 namespace Crypto {
   class Library {
     public:
+      /**
+       * Deterministic random number generator constructions, the default
+       * is the library's general purpose generator, the counter generator is
+       * seekable and suited to producing long keystreams
+       */
+      enum RngType {
+        DefaultRng = 0,
+        CounterRng
+      };
+
       /**
        * Load a public key from a file
        */
@@ -53,9 +63,13 @@ namespace Crypto {
 
       /**
        * Returns a random number generator
+       * @param seed optional seed for a deterministic generator
+       * @param index moves the rng to a specific index
+       * @param type the construction to use for seeded generators
        */
       virtual Utils::Random *GetRandomNumberGenerator(
-          const QByteArray &seed = QByteArray(), uint index = 0) = 0;
+          const QByteArray &seed = QByteArray(), uint index = 0,
+          RngType type = DefaultRng) = 0;
 
       /**
        * Returns the optimal seed size for the RNG
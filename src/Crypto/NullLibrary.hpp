@@ -78,7 +78,8 @@ namespace Crypto {
       /**
        * Returns a random number generator
        */
-      inline virtual Utils::Random *GetRandomNumberGenerator(const QByteArray &seed, uint index) 
+      inline virtual Utils::Random *GetRandomNumberGenerator(const QByteArray &seed,
+          uint index, RngType) 
       {
         return new Utils::Random(seed, index);
       }
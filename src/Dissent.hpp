@@ -47,8 +47,10 @@
 #include "Connections/RelayAddress.hpp"
 #include "Connections/RelayEdge.hpp"
 #include "Connections/RelayEdgeListener.hpp"
+#include "Connections/RelayForwarder.hpp"
 
 #include "Crypto/AsymmetricKey.hpp"
+#include "Crypto/CppCtrRandom.hpp"
 #include "Crypto/CppDiffieHellman.hpp"
 #include "Crypto/CppDsaLibrary.hpp"
 #include "Crypto/CppDsaPrivateKey.hpp"
@@ -63,7 +65,9 @@
 #include "Crypto/CryptoFactory.hpp"
 #include "Crypto/DiffieHellman.hpp"
 #include "Crypto/CppHash.hpp"
+#include "Crypto/GroupNeffShuffle.hpp"
 #include "Crypto/Hash.hpp"
+#include "Crypto/Hmac.hpp"
 #include "Crypto/Integer.hpp"
 #include "Crypto/IntegerData.hpp"
 #include "Crypto/KeyShare.hpp"
@@ -90,9 +94,11 @@
 #include "Crypto/AbstractGroup/CppECGroup.hpp"
 #include "Crypto/AbstractGroup/ECParams.hpp"
 #include "Crypto/AbstractGroup/Element.hpp"
+#include "Crypto/AbstractGroup/FixedBase.hpp"
 #include "Crypto/AbstractGroup/ElementData.hpp"
 #include "Crypto/AbstractGroup/IntegerElementData.hpp"
 #include "Crypto/AbstractGroup/IntegerGroup.hpp"
+#include "Crypto/AbstractGroup/MultiExponentiation.hpp"
 #include "Crypto/AbstractGroup/OpenECElementData.hpp"
 #include "Crypto/AbstractGroup/OpenECGroup.hpp"
 #include "Crypto/AbstractGroup/PairingElementData.hpp"
@@ -109,6 +115,7 @@
 #include "Crypto/BlogDrop/ClientCiphertext.hpp"
 #include "Crypto/BlogDrop/ElGamalClientCiphertext.hpp"
 #include "Crypto/BlogDrop/ElGamalServerCiphertext.hpp"
+#include "Crypto/BlogDrop/HashedGeneratorCache.hpp"
 #include "Crypto/BlogDrop/HashingGenClientCiphertext.hpp"
 #include "Crypto/BlogDrop/HashingGenServerCiphertext.hpp"
 #include "Crypto/BlogDrop/PairingClientCiphertext.hpp"
@@ -179,6 +186,7 @@
 #include "Transports/EdgeListenerFactory.hpp"
 #include "Transports/TcpAddress.hpp"
 #include "Transports/TcpEdge.hpp"
+#include "Transports/TcpEdgeWorker.hpp"
 #include "Transports/TcpEdgeListener.hpp"
 
 #include "Tunnel/EntryTunnel.hpp"
@@ -201,6 +209,8 @@
 #include "Utils/Serialization.hpp"
 #include "Utils/SignalCounter.hpp"
 #include "Utils/Sleeper.hpp"
+#include "Utils/SpillFile.hpp"
+#include "Utils/SpscQueue.hpp"
 #include "Utils/StartStop.hpp"
 #include "Utils/StartStopSlots.hpp"
 #include "Utils/Time.hpp"
@@ -210,6 +220,7 @@
 #include "Utils/Triggerable.hpp"
 #include "Utils/Triple.hpp"
 #include "Utils/Utils.hpp"
+#include "Utils/XorEngine.hpp"
 
 #include "Web/HttpRequest.hpp"
 #include "Web/HttpResponse.hpp"
@@ -1,6 +1,7 @@
 #include <QDataStream>
 #include <QVariant>
 
+#include "Utils/Serialization.hpp"
 #include "Utils/Time.hpp"
 #include "Utils/Timer.hpp"
 
@@ -8,6 +9,33 @@
 
 namespace Dissent {
 namespace Messaging {
+namespace {
+  using Utils::Serialization;
+
+  /*
+   * Binary frame, integers are little endian:
+   *   [0]      marker, a QDataStream QVariantList starts with 0x00
+   *   [1]      type
+   *   [2]      flags
+   *   [3]      version, frames of any other version are dropped
+   *   [4, 8)   request id
+   *   [8, 12)  method id, see GetMethodId
+   *   [12, 16) length of the serialized QVariantHash headers
+   *   headers, then the payload filling the rest of the frame
+   */
+  const char BinaryMarker = char(0x81);
+  const char BinaryVersion = 1;
+  const int BinaryHeaderSize = 16;
+
+  enum BinaryType {
+    BinaryNotification = 0
+  };
+
+  enum BinaryFlags {
+    /* data is the headers with the payload under "data" */
+    BinaryHasHeaders = 0x1
+  };
+}
   const QString Request::NotificationType = QString("n");
   const QString Request::RequestType = QString("r");
   const QString Response::ResponseType = QString("p");
@@ -52,6 +80,11 @@ namespace Messaging {
   void RpcHandler::HandleData(const QSharedPointer<ISender> &from,
       const QByteArray &data)
   {
+    if(!data.isEmpty() && data[0] == BinaryMarker) {
+      HandleBinaryData(from, data);
+      return;
+    }
+
     QVariantList container;
     QDataStream stream(data);
     stream >> container;
@@ -78,6 +111,76 @@ namespace Messaging {
     }
   }
 
+  void RpcHandler::HandleBinaryData(const QSharedPointer<ISender> &from,
+      const QByteArray &data)
+  {
+    if(data.size() < BinaryHeaderSize) {
+      qDebug() << "Received a truncated binary Rpc frame";
+      return;
+    }
+
+    int type = data[1];
+    int flags = data[2];
+    int version = data[3];
+    int id = Serialization::ReadInt(data, 4);
+    quint32 method_id = quint32(Serialization::ReadInt(data, 8));
+    int headers_size = Serialization::ReadInt(data, 12);
+
+    if(version != BinaryVersion) {
+      qDebug() << "Received a binary Rpc frame of unknown version:" << version;
+      return;
+    }
+
+    if(type != BinaryNotification) {
+      qDebug() << "Received an unknown binary Rpc type:" << type;
+      return;
+    }
+
+    if(headers_size < 0 || headers_size > data.size() - BinaryHeaderSize) {
+      qDebug() << "Received a binary Rpc frame with invalid headers";
+      return;
+    }
+
+    if(id <= 0) {
+      qWarning() << "RpcHandler: Request: Invalid ID, from: " <<
+        from->ToString();
+      return;
+    }
+
+    QHash<quint32, Method>::const_iterator method =
+      _methods.constFind(method_id);
+    if(method == _methods.constEnd()) {
+      QString name = "#" + QString::number(method_id);
+      qDebug() << "RpcHandler: Request: No such method: " << name <<
+        ", from: " << from->ToString();
+      SendFailedResponse(Request(_responder, from,
+            Request::BuildNotification(id, name, QVariant())),
+          Response::InvalidMethod, QString("No such method: " + name));
+      return;
+    }
+
+    QByteArray payload = data.mid(BinaryHeaderSize + headers_size);
+    QVariant value;
+    if(flags & BinaryHasHeaders) {
+      QByteArray headers_data = QByteArray::fromRawData(
+          data.constData() + BinaryHeaderSize, headers_size);
+      QDataStream stream(headers_data);
+      QVariantHash headers;
+      stream >> headers;
+      headers["data"] = payload;
+      value = headers;
+    } else {
+      value = payload;
+    }
+
+    Request request(_responder, from,
+        Request::BuildNotification(id, method->first, value));
+    method->second->MakeRequest(request);
+#ifdef RESPOND_NOTIFICATION
+    request.Respond(Request::NotificationType);
+#endif
+  }
+
   void RpcHandler::HandleRequest(const Request &request)
   {
     int id = request.GetId();
@@ -159,6 +262,67 @@ namespace Messaging {
     to->Send(msg);
   }
 
+  void RpcHandler::SendNotification(const QList<QSharedPointer<ISender> > &to,
+      const QString &method, const QVariant &data)
+  {
+    if(to.isEmpty()) {
+      return;
+    }
+
+    int id = IncrementId();
+    QVariantList container = Request::BuildNotification(id, method, data);
+
+    QByteArray msg;
+    QDataStream stream(&msg, QIODevice::WriteOnly);
+    stream << container;
+
+    qDebug() << "RpcHandler: Sending notification" << id << "for" << method <<
+      "to" << to.count() << "destinations";
+    foreach(const QSharedPointer<ISender> &sender, to) {
+      sender->Send(msg);
+    }
+  }
+
+  void RpcHandler::SendBinaryNotification(const QSharedPointer<ISender> &to,
+      const QString &method, const QByteArray &payload)
+  {
+    SendBinary(to, method, 0, QByteArray(), payload);
+  }
+
+  void RpcHandler::SendBinaryNotification(const QSharedPointer<ISender> &to,
+      const QString &method, const QVariantHash &headers,
+      const QByteArray &payload)
+  {
+    QByteArray headers_data;
+    QDataStream stream(&headers_data, QIODevice::WriteOnly);
+    stream << headers;
+    SendBinary(to, method, BinaryHasHeaders, headers_data, payload);
+  }
+
+  void RpcHandler::SendBinary(const QSharedPointer<ISender> &to,
+      const QString &method, int flags, const QByteArray &headers,
+      const QByteArray &payload)
+  {
+    int id = IncrementId();
+
+    QByteArray msg;
+    msg.reserve(BinaryHeaderSize + headers.size() + payload.size());
+    msg.resize(BinaryHeaderSize);
+    msg[0] = BinaryMarker;
+    msg[1] = char(BinaryNotification);
+    msg[2] = char(flags);
+    msg[3] = BinaryVersion;
+    Serialization::WriteInt(id, msg, 4);
+    Serialization::WriteUInt(GetMethodId(method), msg, 8);
+    Serialization::WriteInt(headers.size(), msg, 12);
+    msg.append(headers);
+    msg.append(payload);
+
+    qDebug() << "RpcHandler: Sending binary notification" << id << "for" <<
+      method << "to" << to->ToString();
+    to->Send(msg);
+  }
+
   int RpcHandler::SendRequest(const QSharedPointer<ISender> &to,
       const QString &method, const QVariant &data,
       const QSharedPointer<ResponseHandler> &cb, bool timeout)
@@ -213,6 +377,18 @@ namespace Messaging {
     return _current_id++;
   }
 
+  quint32 RpcHandler::GetMethodId(const QString &method)
+  {
+    // 32-bit FNV-1a
+    const QByteArray name = method.toUtf8();
+    quint32 hash = 2166136261u;
+    for(int idx = 0; idx < name.size(); idx++) {
+      hash ^= static_cast<unsigned char>(name[idx]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
   bool RpcHandler::Register(const QString &name,
       const QSharedPointer<RequestHandler> &cb)
   {
@@ -220,7 +396,15 @@ namespace Messaging {
       return false;
     }
 
+    quint32 method_id = GetMethodId(name);
+    if(_methods.contains(method_id)) {
+      qWarning() << "RpcHandler: Method id collision between" << name <<
+        "and" << _methods[method_id].first;
+      return false;
+    }
+
     _callbacks[name] = cb;
+    _methods[method_id] = Method(name, cb);
     return true;
   }
 
@@ -231,9 +415,8 @@ namespace Messaging {
       return false;
     }
 
-    _callbacks[name] =
-      QSharedPointer<RequestHandler>(new RequestHandler(obj, method));
-    return true;
+    return Register(name,
+        QSharedPointer<RequestHandler>(new RequestHandler(obj, method)));
   }
 
   bool RpcHandler::Unregister(const QString &name)
@@ -244,6 +427,7 @@ namespace Messaging {
     }
 
     _callbacks.remove(name);
+    _methods.remove(GetMethodId(name));
     return true;
   }
 }
@@ -4,7 +4,9 @@
 #include <QByteArray>
 #include <QDebug>
 #include <QHash>
+#include <QList>
 #include <QObject>
+#include <QPair>
 #include <QString>
 #include <QSharedPointer>
 
@@ -24,7 +26,10 @@ namespace Messaging {
   class RequestState;
 
   /**
-   * Rpc mechanism assumes a reliable sending mechanism
+   * Rpc mechanism assumes a reliable sending mechanism.  Messages are either
+   * a QDataStream serialized QVariantList or, for notifications carrying a
+   * byte payload, a versioned binary frame with a fixed header and integer
+   * method id that avoids serializing the payload through QVariant.
    */
   class RpcHandler : public ISinkObject {
     Q_OBJECT
@@ -65,6 +70,13 @@ namespace Messaging {
       void HandleData(const QSharedPointer<ISender> &from,
           const QVariantList &container);
 
+      /**
+       * Returns the wire identifier of a method name, a stable hash so that
+       * peers agree on it without negotiation
+       * @param method the method name
+       */
+      static quint32 GetMethodId(const QString &method);
+
       /**
        * Send a request
        * @param to the destination for the notification
@@ -75,6 +87,40 @@ namespace Messaging {
       void SendNotification(const QSharedPointer<ISender> &to,
           const QString &method, const QVariant &data);
 
+      /**
+       * Send the same notification to many destinations, the notification is
+       * serialized once and every destination is handed the same shared
+       * buffer
+       * @param to the destinations for the notification
+       * @param method the remote method
+       * @param data the input data for that method
+       */
+      void SendNotification(const QList<QSharedPointer<ISender> > &to,
+          const QString &method, const QVariant &data);
+
+      /**
+       * Send a notification whose data is a byte array using the binary
+       * format, the remote side receives the payload as the request's data
+       * @param to the destination for the notification
+       * @param method the remote method
+       * @param payload the input data for that method
+       */
+      void SendBinaryNotification(const QSharedPointer<ISender> &to,
+          const QString &method, const QByteArray &payload);
+
+      /**
+       * Send a notification whose data is a hash with a byte array under
+       * "data" using the binary format, only the headers pass through
+       * QVariant serialization
+       * @param to the destination for the notification
+       * @param method the remote method
+       * @param headers the remaining entries of the hash
+       * @param payload the value of "data"
+       */
+      void SendBinaryNotification(const QSharedPointer<ISender> &to,
+          const QString &method, const QVariantHash &headers,
+          const QByteArray &payload);
+
       /**
        * Send a request
        * @param to the destination for the request
@@ -150,6 +196,20 @@ namespace Messaging {
        */
       void HandleRequest(const Request &request);
 
+      /**
+       * Handle an incoming binary frame
+       * @param from a return path to the requestor
+       * @param data the frame
+       */
+      void HandleBinaryData(const QSharedPointer<ISender> &from,
+          const QByteArray &data);
+
+      /**
+       * Frame and send a binary notification
+       */
+      void SendBinary(const QSharedPointer<ISender> &to, const QString &method,
+          int flags, const QByteArray &headers, const QByteArray &payload);
+
       /**
        * Handle an incoming response
        * @param response the response
@@ -166,6 +226,17 @@ namespace Messaging {
        */
       QHash<QString, QSharedPointer<RequestHandler> > _callbacks;
 
+      /**
+       * A registered method's name and callback
+       */
+      typedef QPair<QString, QSharedPointer<RequestHandler> > Method;
+
+      /**
+       * Maps a registered method's wire identifier to the method, binary
+       * frames are dispatched through this without a string lookup
+       */
+      QHash<quint32, Method> _methods;
+
       /**
        * Maps id to a callback method to handle responses
        */
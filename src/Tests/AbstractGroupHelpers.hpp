@@ -83,6 +83,59 @@ namespace Tests {
     }
   }
 
+  inline void AbstractGroup_MultiExponentiate(QSharedPointer<AbstractGroup> group)
+  {
+    // Cover the pairwise, Straus and Pippenger code paths
+    int counts[] = {0, 1, 2, 5, 40};
+    for(unsigned int idx = 0; idx < sizeof(counts) / sizeof(int); idx++) {
+      QList<Element> bases;
+      QList<Integer> exps;
+      Element expected = group->GetIdentity();
+      for(int i=0; i<counts[idx]; i++) {
+        Element a = group->RandomElement();
+        Integer e = group->RandomExponent();
+        bases.append(a);
+        exps.append(e);
+        expected = group->Multiply(expected, group->Exponentiate(a, e));
+      }
+
+      EXPECT_EQ(expected, group->MultiExponentiate(bases, exps));
+    }
+
+    // Zero and repeated bases
+    Element a = group->RandomElement();
+    QList<Element> bases;
+    QList<Integer> exps;
+    bases << a << a << group->GetGenerator();
+    exps << Integer(0) << Integer(3) << Integer(0);
+    EXPECT_EQ(group->Exponentiate(a, Integer(3)),
+        group->MultiExponentiate(bases, exps));
+  }
+
+  inline void AbstractGroup_FixedBase(QSharedPointer<AbstractGroup> group)
+  {
+    Element a = group->RandomElement();
+    FixedBase fixed = group->PrecomputeFixedBase(a);
+    Element g = group->GetGenerator();
+
+    for(int i=0; i<100; i++) {
+      Integer e = group->RandomExponent();
+      EXPECT_EQ(group->CascadeExponentiate(a, e, a, Integer(0)),
+          group->FixedBaseExponentiate(fixed, e));
+      EXPECT_EQ(group->CascadeExponentiate(g, e, g, Integer(0)),
+          group->Exponentiate(g, e));
+    }
+
+    // Edge cases and exponents outside of the table
+    EXPECT_TRUE(group->IsIdentity(group->FixedBaseExponentiate(fixed, Integer(0))));
+    EXPECT_EQ(a, group->FixedBaseExponentiate(fixed, Integer(1)));
+    EXPECT_TRUE(group->IsIdentity(group->FixedBaseExponentiate(fixed, group->GetOrder())));
+    EXPECT_TRUE(group->IsIdentity(group->Exponentiate(g, group->GetOrder())));
+    EXPECT_EQ(group->Inverse(a),
+        group->FixedBaseExponentiate(fixed, group->GetOrder() - 1));
+    EXPECT_EQ(a, group->FixedBaseExponentiate(fixed, group->GetOrder() + 1));
+  }
+
   inline void AbstractGroup_Serialize(QSharedPointer<AbstractGroup> group)
   {
     for(int i=0; i<100; i++) {
@@ -134,6 +187,54 @@ namespace Tests {
     }
   }
 
+  inline void AbstractGroup_NeffShuffle(QSharedPointer<AbstractGroup> group)
+  {
+    int values = 10;
+    int keys = 3;
+
+    GroupNeffShuffle shuffle(group);
+    QVector<Integer> pr_keys;
+    QVector<Element> pub_keys;
+    for(int idx = 0; idx < keys; idx++) {
+      pr_keys.append(group->RandomExponent());
+      pub_keys.append(group->Exponentiate(group->GetGenerator(), pr_keys.last()));
+    }
+
+    Library *lib = CryptoFactory::GetInstance().GetLibrary();
+    QScopedPointer<Dissent::Utils::Random> rand(lib->GetRandomNumberGenerator());
+
+    QVector<QByteArray> input, msgs;
+    for(int idx = 0; idx < values; idx++) {
+      QByteArray msg(group->BytesPerElement(), 0);
+      rand->GenerateBlock(msg);
+      msgs.append(msg);
+      input.append(shuffle.SeriesEncrypt(pub_keys, msg));
+      EXPECT_TRUE(shuffle.InGroup(input.last()));
+    }
+
+    QVector<QByteArray> output;
+    QByteArray proof;
+    QVector<Element> npub_keys = pub_keys;
+    QVector<Element> cpub_keys = pub_keys;
+
+    foreach(const Integer &private_key, pr_keys) {
+      npub_keys.pop_front();
+      EXPECT_TRUE(shuffle.Shuffle(input, private_key, npub_keys, output, proof));
+      QVector<QByteArray> verified;
+      EXPECT_TRUE(shuffle.Verify(input, cpub_keys, proof, verified));
+      EXPECT_EQ(output, verified);
+
+      proof[proof.size() / 2] = proof[proof.size() / 2] ^ 0x01;
+      EXPECT_FALSE(shuffle.Verify(input, cpub_keys, proof, verified));
+
+      input = output;
+      cpub_keys = npub_keys;
+    }
+
+    foreach(const QByteArray &encrypted, output) {
+      EXPECT_TRUE(msgs.contains(shuffle.SeriesDecryptFinish(encrypted)));
+    }
+  }
 }
 }
 
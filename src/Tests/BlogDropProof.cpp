@@ -765,6 +765,100 @@ namespace Tests {
     cf.SetThreading(tt);
   }
 
+  void BatchVerifyOnce(QSharedPointer<Parameters> params)
+  {
+    params->SetBatchProofs(true);
+
+    QSharedPointer<const PrivateKey> author_priv(new PrivateKey(params));
+    QSharedPointer<const PublicKey> author_pk(new PublicKey(author_priv));
+
+    const int nservers = Random::GetInstance().GetInt(TEST_RANGE_MIN, TEST_RANGE_MAX);
+    QList<QSharedPointer<const PublicKey> > server_pks;
+    for(int i=0; i<nservers; i++) {
+      QSharedPointer<const PrivateKey> priv(new PrivateKey(params));
+      server_pks.append(QSharedPointer<const PublicKey>(new PublicKey(priv)));
+    }
+    QSharedPointer<const PublicKeySet> server_pk_set(new PublicKeySet(params, server_pks));
+
+    const int nclients = Random::GetInstance().GetInt(TEST_RANGE_MIN, TEST_RANGE_MAX) + 1;
+    QList<QSharedPointer<const PublicKey> > client_pks;
+    QList<QByteArray> ctexts;
+    for(int i=0; i<nclients; i++) {
+      QSharedPointer<const PrivateKey> priv(new PrivateKey(params));
+      client_pks.append(QSharedPointer<const PublicKey>(new PublicKey(priv)));
+
+      QSharedPointer<ClientCiphertext> c = CiphertextFactory::CreateClientCiphertext(
+          params, server_pk_set, author_pk);
+      c->SetProof(0, priv);
+      ctexts.append(c->GetByteArray());
+    }
+
+    QList<QSharedPointer<const ClientCiphertext> > c_out;
+    QList<QSharedPointer<const PublicKey> > pubs_out;
+    ClientCiphertext::VerifyProofs(params, server_pk_set, author_pk, 0,
+        client_pks, ctexts, c_out, pubs_out, true);
+    ASSERT_EQ(nclients, c_out.count());
+    ASSERT_TRUE(c_out[0]->VerifyProofBatch(0, c_out, pubs_out));
+
+    // A proof checked against the wrong key must fail the batch and
+    // only that proof should be rejected by the fallback
+    const int bad_idx = Random::GetInstance().GetInt(0, nclients);
+    QList<QSharedPointer<const PublicKey> > bad_pks = client_pks;
+    bad_pks[bad_idx] = author_pk;
+    ASSERT_FALSE(c_out[0]->VerifyProofBatch(0, c_out, bad_pks));
+
+    c_out.clear();
+    pubs_out.clear();
+    ClientCiphertext::VerifyProofs(params, server_pk_set, author_pk, 0,
+        bad_pks, ctexts, c_out, pubs_out, true);
+    ASSERT_EQ(nclients - 1, c_out.count());
+    ASSERT_FALSE(pubs_out.contains(author_pk));
+
+    // Without batch proofs the commitments are not sent, so the batch
+    // check cannot pass but every proof still verifies on its own
+    params->SetBatchProofs(false);
+    QList<QByteArray> small_ctexts;
+    for(int i=0; i<nclients; i++) {
+      QSharedPointer<const PrivateKey> priv(new PrivateKey(params));
+      client_pks[i] = QSharedPointer<const PublicKey>(new PublicKey(priv));
+
+      QSharedPointer<ClientCiphertext> c = CiphertextFactory::CreateClientCiphertext(
+          params, server_pk_set, author_pk);
+      c->SetProof(0, priv);
+      small_ctexts.append(c->GetByteArray());
+      ASSERT_TRUE(small_ctexts[i].count() < ctexts[i].count());
+    }
+
+    c_out.clear();
+    pubs_out.clear();
+    ClientCiphertext::VerifyProofs(params, server_pk_set, author_pk, 0,
+        client_pks, small_ctexts, c_out, pubs_out, true);
+    ASSERT_EQ(nclients, c_out.count());
+    ASSERT_FALSE(c_out[0]->VerifyProofBatch(0, c_out, pubs_out));
+  }
+
+  TEST_P(BlogDropProofTest, IntegerHashingBatchVerify)
+  {
+    CryptoFactory &cf = CryptoFactory::GetInstance();
+    CryptoFactory::ThreadingType tt = cf.GetThreadingType();
+    cf.SetThreading(GetParam());
+
+    BatchVerifyOnce(Parameters::Parameters::IntegerHashingTesting());
+
+    cf.SetThreading(tt);
+  }
+
+  TEST_P(BlogDropProofTest, CppECHashingBatchVerify)
+  {
+    CryptoFactory &cf = CryptoFactory::GetInstance();
+    CryptoFactory::ThreadingType tt = cf.GetThreadingType();
+    cf.SetThreading(GetParam());
+
+    BatchVerifyOnce(Parameters::Parameters::CppECHashingProduction());
+
+    cf.SetThreading(tt);
+  }
+
   INSTANTIATE_TEST_CASE_P(BlogDropProof, BlogDropProofTest,
       ::testing::Values(
         CryptoFactory::SingleThreaded,
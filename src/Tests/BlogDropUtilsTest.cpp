@@ -21,6 +21,45 @@ namespace Tests {
     EXPECT_EQ(100, set.count());
   }
 
+  void TestHashedCache(QSharedPointer<const Parameters> params)
+  {
+    QSharedPointer<const PrivateKey> author_priv(new PrivateKey(params));
+    QSharedPointer<const PublicKey> author_pub(new PublicKey(author_priv));
+    QSharedPointer<HashedGeneratorCache> cache = params->GetGeneratorCache();
+    ASSERT_FALSE(cache.isNull());
+
+    cache->Precompute(params, author_pub, 1);
+    for(int phase=0; phase<3; phase++) {
+      for(int i=0; i<params->GetNElements(); i++) {
+        Element e = BlogDropUtils::ComputeHashedGenerator(params, author_pub, phase, i);
+        EXPECT_EQ(e, BlogDropUtils::GetHashedGenerator(params, author_pub, phase, i));
+        EXPECT_EQ(e, BlogDropUtils::GetHashedGenerator(params, author_pub, phase, i));
+      }
+    }
+
+    // Copies share the cache, but a different element count is a
+    // different set of generators
+    QSharedPointer<Parameters> copy(new Parameters(*params));
+    EXPECT_EQ(cache, copy->GetGeneratorCache());
+    copy->SetNElements(params->GetNElements() + 1);
+    EXPECT_EQ(BlogDropUtils::ComputeHashedGenerator(copy, author_pub, 2, 0),
+        BlogDropUtils::GetHashedGenerator(copy, author_pub, 2, 0));
+
+    // Each author has its own generators
+    QSharedPointer<const PrivateKey> other_priv(new PrivateKey(params));
+    QSharedPointer<const PublicKey> other_pub(new PublicKey(other_priv));
+    EXPECT_EQ(BlogDropUtils::ComputeHashedGenerator(params, other_pub, 2, 0),
+        BlogDropUtils::GetHashedGenerator(params, other_pub, 2, 0));
+  }
+
+  TEST(BlogDropUtils, HashedGeneratorCacheInteger) {
+    TestHashedCache(Parameters::Parameters::IntegerHashingTesting());
+  }
+
+  TEST(BlogDropUtils, HashedGeneratorCacheCppEC) {
+    TestHashedCache(Parameters::Parameters::CppECHashingProduction());
+  }
+
   TEST(BlogDropUtils, HashedGeneratorInteger) {
     TestHashed(Parameters::Parameters::IntegerHashingTesting());
   }
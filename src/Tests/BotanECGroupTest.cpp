@@ -33,6 +33,16 @@ namespace Tests {
     AbstractGroup_Exponentiation(BotanECGroup::GetGroup((ECParams::CurveName)GetParam()));
   }
 
+  TEST_P(BotanECGroupTest, MultiExponentiate)
+  {
+    AbstractGroup_MultiExponentiate(BotanECGroup::GetGroup((ECParams::CurveName)GetParam()));
+  }
+
+  TEST_P(BotanECGroupTest, FixedBase)
+  {
+    AbstractGroup_FixedBase(BotanECGroup::GetGroup((ECParams::CurveName)GetParam()));
+  }
+
   TEST_P(BotanECGroupTest, Serialize)
   {
     AbstractGroup_Serialize(BotanECGroup::GetGroup((ECParams::CurveName)GetParam()));
@@ -5,6 +5,39 @@
 
 namespace Dissent {
 namespace Tests {
+  /**
+   * Creates a CSBulkRound of type B using shuffle S, adjusted by Configure
+   * before it starts
+   */
+  template <typename B, typename S, void (*Configure)(CSBulkRound *)>
+    QSharedPointer<Round> TCreateConfiguredCSBulkRound(
+      const Round::Group &group, const Round::PrivateIdentity &ident,
+      const Connections::Id &round_id,
+      QSharedPointer<Connections::Network> network,
+      Messaging::GetDataCallback &get_data)
+  {
+    QSharedPointer<B> round(new B(group, ident, round_id, network,
+          get_data, &TCreateRound<S>));
+    round->SetSharedPointer(round);
+    Configure(round.data());
+    return round;
+  }
+
+  void CSBulkRoundUseReduceScatter(CSBulkRound *round)
+  {
+    round->SetReduceScatter(true);
+  }
+
+  void CSBulkRoundUseCompactBlameLogs(CSBulkRound *round)
+  {
+    round->SetCompactBlameLogs(true);
+  }
+
+  void CSBulkRoundUseDeepPadPipeline(CSBulkRound *round)
+  {
+    round->SetPadPipelineDepth(3);
+  }
+
   TEST(CSBulkRound, BasicManaged)
   {
     RoundTest_Basic(SessionCreator(TCreateRound<CSBulkRound>),
@@ -57,5 +90,94 @@ namespace Tests {
       SessionCreator(TCreateBulkRound<badbulk, NeffKeyShuffle>),
       Group::ManagedSubgroup, TBadGuyCB<badbulk>);
   }
+
+  TEST(CSBulkRound, BadClientCompactBlameLogs)
+  {
+    typedef CSBulkRoundBadClient badbulk;
+    RoundTest_BadGuy(SessionCreator(TCreateConfiguredCSBulkRound<CSBulkRound,
+          NeffKeyShuffle, CSBulkRoundUseCompactBlameLogs>),
+      SessionCreator(TCreateConfiguredCSBulkRound<badbulk,
+          NeffKeyShuffle, CSBulkRoundUseCompactBlameLogs>),
+      Group::ManagedSubgroup, TBadGuyCB<badbulk>);
+  }
+
+  TEST(CSBulkRound, BasicReduceScatter)
+  {
+    RoundTest_Basic(SessionCreator(TCreateConfiguredCSBulkRound<CSBulkRound,
+          ShuffleRound, CSBulkRoundUseReduceScatter>),
+        Group::ManagedSubgroup);
+  }
+
+  TEST(CSBulkRound, MultiRoundReduceScatter)
+  {
+    RoundTest_MultiRound(SessionCreator(TCreateConfiguredCSBulkRound<CSBulkRound,
+          ShuffleRound, CSBulkRoundUseReduceScatter>),
+        Group::ManagedSubgroup);
+  }
+
+  TEST(CSBulkRound, MultiRoundPadPipeline)
+  {
+    // Pads are only precomputed with worker threads available
+    CryptoFactory &cf = CryptoFactory::GetInstance();
+    CryptoFactory::ThreadingType tt = cf.GetThreadingType();
+    cf.SetThreading(CryptoFactory::MultiThreaded);
+
+    RoundTest_MultiRound(SessionCreator(TCreateConfiguredCSBulkRound<CSBulkRound,
+          ShuffleRound, CSBulkRoundUseDeepPadPipeline>),
+        Group::ManagedSubgroup);
+
+    cf.SetThreading(tt);
+  }
+
+  TEST(CSBulkRound, BadClientPadPipeline)
+  {
+    CryptoFactory &cf = CryptoFactory::GetInstance();
+    CryptoFactory::ThreadingType tt = cf.GetThreadingType();
+    cf.SetThreading(CryptoFactory::MultiThreaded);
+
+    typedef CSBulkRoundBadClient badbulk;
+    RoundTest_BadGuy(SessionCreator(TCreateConfiguredCSBulkRound<CSBulkRound,
+          NeffKeyShuffle, CSBulkRoundUseDeepPadPipeline>),
+      SessionCreator(TCreateConfiguredCSBulkRound<badbulk,
+          NeffKeyShuffle, CSBulkRoundUseDeepPadPipeline>),
+      Group::ManagedSubgroup, TBadGuyCB<badbulk>);
+
+    cf.SetThreading(tt);
+  }
+
+  TEST(CSBulkRound, SparseCleartext)
+  {
+    CppRandom rand;
+    for(int run = 0; run < 20; run++) {
+      QByteArray cleartext(rand.GetInt(1, 4096), 0);
+      int literals = rand.GetInt(0, 10);
+      for(int idx = 0; idx < literals; idx++) {
+        QByteArray data(rand.GetInt(1, 64), 0);
+        rand.GenerateBlock(data);
+        int offset = rand.GetInt(0, cleartext.size());
+        int length = qMin(data.size(), cleartext.size() - offset);
+        cleartext.replace(offset, length, data.left(length));
+      }
+
+      QByteArray compressed = CSBulkRound::CompressCleartext(cleartext);
+      QByteArray expanded;
+      EXPECT_TRUE(CSBulkRound::ExpandCleartext(compressed, cleartext.size(),
+            expanded));
+      EXPECT_EQ(cleartext, expanded);
+    }
+
+    QByteArray empty(1024, 0);
+    EXPECT_TRUE(CSBulkRound::CompressCleartext(empty).isEmpty());
+
+    QByteArray cleartext(1024, 0);
+    cleartext[1000] = 1;
+    QByteArray compressed = CSBulkRound::CompressCleartext(cleartext);
+    EXPECT_EQ(compressed.size(), 9);
+
+    QByteArray expanded;
+    EXPECT_FALSE(CSBulkRound::ExpandCleartext(compressed, 1000, expanded));
+    EXPECT_FALSE(CSBulkRound::ExpandCleartext(compressed.left(8), 1024,
+          expanded));
+  }
 }
 }
@@ -148,7 +148,7 @@ namespace Tests {
     }
   }
 
-  TEST(Crypto, NeffShuffle)
+  void TestNeffShuffle()
   {
     int values = 50;
     int keys = 10;
@@ -187,7 +187,10 @@ namespace Tests {
     foreach(const QSharedPointer<CppDsaPrivateKey> &private_key, pr_keys) {
       npub_keys.pop_front();
       EXPECT_TRUE(shuffle.Shuffle(input, private_key, npub_keys, output, proof));
+      QVector<QByteArray> claimed;
+      EXPECT_TRUE(shuffle.GetOutput(proof, claimed));
       EXPECT_TRUE(shuffle.Verify(input, cpub_keys, proof, output));
+      EXPECT_EQ(claimed, output);
       input = output;
       cpub_keys = npub_keys;
     }
@@ -198,5 +201,19 @@ namespace Tests {
       EXPECT_TRUE(x.contains(val));
     }
   }
+
+  TEST(Crypto, NeffShuffle)
+  {
+    TestNeffShuffle();
+  }
+
+  TEST(Crypto, NeffShuffleMultiThreaded)
+  {
+    CryptoFactory &cf = CryptoFactory::GetInstance();
+    CryptoFactory::ThreadingType tt = cf.GetThreadingType();
+    cf.SetThreading(CryptoFactory::MultiThreaded);
+    TestNeffShuffle();
+    cf.SetThreading(tt);
+  }
 }
 }
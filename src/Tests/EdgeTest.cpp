@@ -109,6 +109,108 @@ namespace Tests {
     EXPECT_EQ(sc.GetCount(), 1);
   }
 
+  TEST(EdgeTest, TcpFraming)
+  {
+    Timer::GetInstance().UseRealTime();
+
+    const TcpAddress addr0("127.0.0.1", 33348);
+    TcpEdgeListener te0(addr0);
+    MockEdgeHandler meh0(&te0);
+    te0.Start();
+
+    const TcpAddress addr1("127.0.0.1", 33349);
+    TcpEdgeListener te1(addr1);
+    MockEdgeHandler meh1(&te1);
+    te1.Start();
+
+    SignalCounter edges(2);
+    QObject::connect(&te0, SIGNAL(NewEdge(const QSharedPointer<Edge> &)),
+        &edges, SLOT(Counter()));
+    QObject::connect(&te1, SIGNAL(NewEdge(const QSharedPointer<Edge> &)),
+        &edges, SLOT(Counter()));
+
+    te1.CreateEdgeTo(addr0);
+    MockExecLoop(edges);
+
+    BufferSink sink;
+    meh0.edge->SetSink(&sink);
+    SignalCounter received(4);
+    QObject::connect(&sink, SIGNAL(DataReceived()), &received, SLOT(Counter()));
+
+    // Spans both the coalesced and the in place write paths
+    CppRandom rand;
+    QList<QByteArray> msgs;
+    msgs.append(QByteArray(100, 0));
+    msgs.append(QByteArray());
+    msgs.append(QByteArray(TcpEdgeWorker::CoalesceLimit + 1, 0));
+    msgs.append(QByteArray(4 * 1024 * 1024, 0));
+    for(int idx = 0; idx < msgs.count(); idx++) {
+      rand.GenerateBlock(msgs[idx]);
+      meh1.edge->Send(msgs[idx]);
+    }
+
+    MockExecLoop(received);
+    ASSERT_EQ(sink.Count(), msgs.count());
+    for(int idx = 0; idx < msgs.count(); idx++) {
+      EXPECT_EQ(sink.At(idx).second, msgs[idx]);
+    }
+
+    te0.Stop();
+    te1.Stop();
+  }
+
+  TEST(EdgeTest, TcpReadBudget)
+  {
+    Timer::GetInstance().UseRealTime();
+
+    const TcpAddress addr0("127.0.0.1", 33350);
+    TcpEdgeListener te0(addr0);
+    MockEdgeHandler meh0(&te0);
+    te0.Start();
+
+    const TcpAddress addr1("127.0.0.1", 33351);
+    TcpEdgeListener te1(addr1);
+    MockEdgeHandler meh1(&te1);
+    te1.Start();
+
+    SignalCounter edges(2);
+    QObject::connect(&te0, SIGNAL(NewEdge(const QSharedPointer<Edge> &)),
+        &edges, SLOT(Counter()));
+    QObject::connect(&te1, SIGNAL(NewEdge(const QSharedPointer<Edge> &)),
+        &edges, SLOT(Counter()));
+
+    te1.CreateEdgeTo(addr0);
+    MockExecLoop(edges);
+
+    QSharedPointer<TcpEdge> edge0 = meh0.edge.dynamicCast<TcpEdge>();
+    ASSERT_TRUE(edge0);
+    BufferSink sink;
+    edge0->SetSink(&sink);
+
+    // Sent in one event, so more than a budget's worth arrive together
+    const int count = 10 * TcpEdge::ReadMessageBudget;
+    SignalCounter received(count);
+    QObject::connect(&sink, SIGNAL(DataReceived()), &received, SLOT(Counter()));
+
+    QList<QByteArray> msgs;
+    for(int idx = 0; idx < count; idx++) {
+      QByteArray msg(4, 0);
+      Serialization::WriteInt(idx, msg, 0);
+      msgs.append(msg);
+      meh1.edge->Send(msg);
+    }
+
+    MockExecLoop(received);
+    ASSERT_EQ(sink.Count(), count);
+    for(int idx = 0; idx < count; idx++) {
+      EXPECT_EQ(sink.At(idx).second, msgs[idx]);
+    }
+    EXPECT_GT(edge0->GetDeferredReads(), 0);
+
+    te0.Stop();
+    te1.Stop();
+  }
+
   TEST(EdgeTest, TcpFail)
   {
     Timer::GetInstance().UseRealTime();
@@ -35,5 +35,28 @@ namespace Tests {
     QScopedPointer<Hash> hashalgo(new CppHash());
     HashTest(hashalgo.data());
   }
+
+  TEST(Crypto, CppHmacTest)
+  {
+    // RFC 2202 test case 2
+    Hmac hmac("Jefe", QSharedPointer<Hash>(new CppHash()));
+    QByteArray data("what do ya want for nothing?");
+    QByteArray mac = hmac.ComputeMac(data);
+    EXPECT_EQ(mac.toHex(),
+        QByteArray("effcdf6ae5eb2fa2d27416d5f184df9c259a7c79"));
+    EXPECT_EQ(mac.size(), hmac.GetMacLength());
+    EXPECT_TRUE(hmac.VerifyMac(data, mac));
+
+    mac[0] = mac[0] ^ 0x01;
+    EXPECT_FALSE(hmac.VerifyMac(data, mac));
+    EXPECT_FALSE(hmac.VerifyMac(data, mac.left(4)));
+
+    // Keys longer than a block are hashed first
+    Hmac long_key(QByteArray(80, char(0xaa)),
+        QSharedPointer<Hash>(new CppHash()));
+    EXPECT_EQ(long_key.ComputeMac("Test Using Larger Than Block-Size Key - "
+          "Hash Key First").toHex(),
+        QByteArray("aa4ae5e15272d00e95705637ce8a3b55ed402112"));
+  }
 }
 }
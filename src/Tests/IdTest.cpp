@@ -67,6 +67,31 @@ namespace Tests {
     EXPECT_EQ(test0, test0_out);
   }
 
+  TEST(Id, FixedSize)
+  {
+    QByteArray small(1, 5);
+    Id id0(QByteArray(Id::ByteSize - 1, 0) + small);
+    Id id1(id0.GetByteArray());
+
+    EXPECT_EQ(id0, id1);
+    EXPECT_EQ(qHash(id0), qHash(id1));
+    EXPECT_EQ(id0.GetByteArray().size(), int(Id::ByteSize));
+    EXPECT_EQ(id0, Id(id0.ToString()));
+    EXPECT_EQ(id0, Id(id0.GetInteger()));
+    EXPECT_TRUE(Id::Zero() < id0);
+
+    Id id2(QByteArray(1, 1) + QByteArray(Id::ByteSize - 1, 0));
+    EXPECT_TRUE(id0 < id2);
+    EXPECT_TRUE(id2 > id0);
+    EXPECT_EQ(id2, Id(id2.ToString()));
+
+    // Arrays of any other size are rejected rather than padded or truncated
+    EXPECT_EQ(Id::Zero(), Id(small));
+    EXPECT_EQ(Id::Zero(), Id(QByteArray()));
+    EXPECT_EQ(Id::Zero(), Id(id2.GetByteArray() + small));
+    EXPECT_EQ(Id::Zero(), Id(small + id2.GetByteArray()));
+  }
+
   TEST(Id, InvalidString)
   {
     Id id;
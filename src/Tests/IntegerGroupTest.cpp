@@ -20,6 +20,18 @@ namespace Tests {
     AbstractGroup_RandomExponent(group);
   }
 
+  TEST_P(IntegerGroupTest, MultiExponentiate)
+  {
+    const QSharedPointer<IntegerGroup> group = IntegerGroup::GetGroup((IntegerGroup::GroupSize)GetParam());
+    AbstractGroup_MultiExponentiate(group);
+  }
+
+  TEST_P(IntegerGroupTest, FixedBase)
+  {
+    const QSharedPointer<IntegerGroup> group = IntegerGroup::GetGroup((IntegerGroup::GroupSize)GetParam());
+    AbstractGroup_FixedBase(group);
+  }
+
   TEST_P(IntegerGroupTest, NotElement) 
   {
     const QSharedPointer<IntegerGroup> group = IntegerGroup::GetGroup((IntegerGroup::GroupSize)GetParam());
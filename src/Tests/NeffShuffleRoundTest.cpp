@@ -39,6 +39,33 @@ namespace Tests {
         Group::ManagedSubgroup);
   }
 
+  TEST(NeffShuffle, PipelinedBasic)
+  {
+    RoundTest_Basic(SessionCreator(CreatePipelinedNeffShuffle),
+        Group::ManagedSubgroup);
+  }
+
+  TEST(NeffShuffle, PipelinedMultiRound)
+  {
+    RoundTest_MultiRound(SessionCreator(CreatePipelinedNeffShuffle),
+        Group::ManagedSubgroup);
+  }
+
+  // Messages must fit into a single P-256 point
+  static const int EC_MESSAGE_LENGTH = 24;
+
+  TEST(NeffShuffle, ECBasic)
+  {
+    RoundTest_Basic(SessionCreator(CreateECNeffShuffle),
+        Group::ManagedSubgroup, EC_MESSAGE_LENGTH);
+  }
+
+  TEST(NeffShuffle, ECMultiRound)
+  {
+    RoundTest_MultiRound(SessionCreator(CreateECNeffShuffle),
+        Group::ManagedSubgroup, EC_MESSAGE_LENGTH);
+  }
+
   /*
    * Has bugs do not test for now
   TEST(NeffShuffle, PeerTransientIssueMiddle)
@@ -33,6 +33,16 @@ namespace Tests {
     AbstractGroup_Exponentiation(OpenECGroup::GetGroup((ECParams::CurveName)GetParam()));
   }
 
+  TEST_P(OpenECGroupTest, MultiExponentiate)
+  {
+    AbstractGroup_MultiExponentiate(OpenECGroup::GetGroup((ECParams::CurveName)GetParam()));
+  }
+
+  TEST_P(OpenECGroupTest, FixedBase)
+  {
+    AbstractGroup_FixedBase(OpenECGroup::GetGroup((ECParams::CurveName)GetParam()));
+  }
+
   TEST_P(OpenECGroupTest, Serialize)
   {
     AbstractGroup_Serialize(OpenECGroup::GetGroup((ECParams::CurveName)GetParam()));
@@ -43,6 +53,11 @@ namespace Tests {
     AbstractGroup_Encode(OpenECGroup::GetGroup((ECParams::CurveName)GetParam()));
   }
 
+  TEST_P(OpenECGroupTest, NeffShuffle)
+  {
+    AbstractGroup_NeffShuffle(OpenECGroup::GetGroup((ECParams::CurveName)GetParam()));
+  }
+
   INSTANTIATE_TEST_CASE_P(OpenECGroupTest, OpenECGroupTest,
       ::testing::Range(0, (int)ECParams::INVALID));
 
@@ -56,6 +56,96 @@ namespace Tests {
     }
   }
 
+  TEST(Random, CppCtrRandomTest)
+  {
+    QScopedPointer<Library> lib(new CppLibrary());
+    QScopedPointer<Random> rng(lib->GetRandomNumberGenerator());
+    QByteArray seed(lib->RngOptimalSeedSize(), 0);
+    rng->GenerateBlock(seed);
+
+    QScopedPointer<Random> rand(lib->GetRandomNumberGenerator(seed, 0,
+          Library::CounterRng));
+    RandomTest(rand.data());
+
+    QScopedPointer<Random> rng0(lib->GetRandomNumberGenerator(seed, 0,
+          Library::CounterRng));
+    QScopedPointer<Random> rng1(lib->GetRandomNumberGenerator(seed, 0,
+          Library::CounterRng));
+    QScopedPointer<Random> rng_x917(lib->GetRandomNumberGenerator(seed));
+
+    QByteArray msg0(4096, 0);
+    QByteArray msg1(4096, 0);
+    QByteArray msg_x917(4096, 0);
+    rng0->GenerateBlock(msg0);
+    rng1->GenerateBlock(msg1);
+    rng_x917->GenerateBlock(msg_x917);
+    EXPECT_EQ(msg0, msg1);
+    EXPECT_NE(msg0, msg_x917);
+
+    for(int idx = 0; idx < 10; idx++) {
+      uint index = rng->GetInt(0, msg0.size() - 64);
+      QScopedPointer<Random> rng2(lib->GetRandomNumberGenerator(seed, index,
+            Library::CounterRng));
+      QByteArray msg2(64, 0);
+      rng2->GenerateBlock(msg2);
+      EXPECT_EQ(msg2, msg0.mid(index, 64));
+      EXPECT_EQ(rng2->BytesGenerated(), index + 64);
+    }
+
+    // Integers, including rejected draws, advance the keystream exactly
+    // BytesGenerated bytes
+    QScopedPointer<Random> rng3(lib->GetRandomNumberGenerator(seed, 0,
+          Library::CounterRng));
+    for(int idx = 0; idx < 100; idx++) {
+      int value = rng3->GetInt(0, (1 << 30) + 1);
+      EXPECT_TRUE(0 <= value && value <= (1 << 30));
+    }
+    EXPECT_EQ(rng3->BytesGenerated() % 4, uint(0));
+
+    uint index = rng3->BytesGenerated();
+    QByteArray msg3(64, 0);
+    rng3->GenerateBlock(msg3);
+    QScopedPointer<Random> rng4(lib->GetRandomNumberGenerator(seed, index,
+          Library::CounterRng));
+    QByteArray msg4(64, 0);
+    rng4->GenerateBlock(msg4);
+    EXPECT_EQ(msg3, msg4);
+  }
+
+  void XorBlockTest(Library *lib, Library::RngType type)
+  {
+    QScopedPointer<Random> rng(lib->GetRandomNumberGenerator());
+    QByteArray seed(lib->RngOptimalSeedSize(), 0);
+    rng->GenerateBlock(seed);
+
+    QScopedPointer<Random> rng0(lib->GetRandomNumberGenerator(seed, 0, type));
+    QScopedPointer<Random> rng1(lib->GetRandomNumberGenerator(seed, 0, type));
+
+    for(int idx = 0; idx < 5; idx++) {
+      QByteArray data(rng->GetInt(1, 3 * Random::XorChunkSize), 0);
+      rng->GenerateBlock(data);
+
+      QByteArray pad(data.size(), 0);
+      rng0->GenerateBlock(pad);
+      QByteArray expected(data.size(), 0);
+      BaseBulkRound::Xor(expected, data, pad);
+
+      rng1->XorBlock(data);
+      EXPECT_EQ(data, expected);
+      EXPECT_EQ(rng0->BytesGenerated(), rng1->BytesGenerated());
+    }
+  }
+
+  TEST(Random, XorBlockTest)
+  {
+    QScopedPointer<Library> null_lib(new NullLibrary());
+    XorBlockTest(null_lib.data(), Library::DefaultRng);
+
+    QScopedPointer<Library> cpp_lib(new CppLibrary());
+    XorBlockTest(cpp_lib.data(), Library::DefaultRng);
+    XorBlockTest(cpp_lib.data(), Library::CounterRng);
+  }
+
   TEST(Random, BaseRandomTest)
   {
     RandomTest(&Random::GetInstance());
@@ -0,0 +1,205 @@
+#include "DissentTest.hpp"
+
+namespace Dissent {
+namespace Tests {
+  class TestRelayForwarder : public RelayForwarder {
+    public:
+      TestRelayForwarder(const Id &local_id, const ConnectionTable &ct,
+          const QSharedPointer<RpcHandler> &rpc) :
+        RelayForwarder(local_id, ct, rpc)
+      {
+      }
+
+      QSharedPointer<Connection> GetRoute(const Id &to, const QList<Id> &been)
+      {
+        return GetCachedRoute(to, been);
+      }
+
+      void SetRoute(const Id &to, const QSharedPointer<Connection> &con)
+      {
+        CacheRoute(to, con);
+      }
+  };
+
+  static QList<Id> RandomIds(int count)
+  {
+    QList<Id> ids;
+    for(int idx = 0; idx < count; idx++) {
+      ids.append(Id());
+    }
+    return ids;
+  }
+
+  TEST(RelayForwarder, BatchRoundTrip)
+  {
+    CppRandom rand;
+    QList<Id> tos = RandomIds(3);
+    QList<QList<Id> > beens;
+    QList<QList<Id> > reverses;
+    QList<QByteArray> datas;
+
+    beens.append(RandomIds(1));
+    reverses.append(QList<Id>());
+    datas.append(QByteArray(100, 0));
+
+    beens.append(RandomIds(4));
+    reverses.append(RandomIds(3));
+    datas.append(QByteArray());
+
+    beens.append(RandomIds(2));
+    reverses.append(RandomIds(1));
+    datas.append(QByteArray(5000, 0));
+
+    QByteArray batch;
+    for(int idx = 0; idx < tos.count(); idx++) {
+      rand.GenerateBlock(datas[idx]);
+      RelayForwarder::AppendMessage(batch, tos[idx], datas[idx],
+          beens[idx], reverses[idx]);
+    }
+
+    int offset = 0;
+    for(int idx = 0; idx < tos.count(); idx++) {
+      Id to(Id::Zero());
+      QByteArray data;
+      QList<Id> been, reverse;
+      ASSERT_TRUE(RelayForwarder::ReadMessage(batch, offset, to, data,
+            been, reverse));
+      EXPECT_EQ(to, tos[idx]);
+      EXPECT_EQ(data, datas[idx]);
+      EXPECT_EQ(been, beens[idx]);
+      EXPECT_EQ(reverse, reverses[idx]);
+    }
+    EXPECT_EQ(offset, batch.size());
+  }
+
+  TEST(RelayForwarder, BatchTruncated)
+  {
+    QByteArray batch;
+    RelayForwarder::AppendMessage(batch, Id(), QByteArray(64, 1),
+        RandomIds(2), RandomIds(1));
+    int size = batch.size();
+    RelayForwarder::AppendMessage(batch, Id(), QByteArray(64, 2),
+        RandomIds(2), RandomIds(1));
+
+    Id to(Id::Zero());
+    QByteArray data;
+    QList<Id> been, reverse;
+
+    // The header itself is cut short
+    int offset = 0;
+    QByteArray header = batch.left(Id::ByteSize + 8);
+    EXPECT_FALSE(RelayForwarder::ReadMessage(header, offset, to, data,
+          been, reverse));
+
+    // The header is complete, but the ids and data are not
+    for(int length = Id::ByteSize + 12; length < size; length += 7) {
+      offset = 0;
+      EXPECT_FALSE(RelayForwarder::ReadMessage(batch.left(length), offset,
+            to, data, been, reverse));
+    }
+
+    // The first message survives when only the second is cut short
+    QByteArray partial = batch.left(batch.size() - 1);
+    offset = 0;
+    EXPECT_TRUE(RelayForwarder::ReadMessage(partial, offset, to, data,
+          been, reverse));
+    EXPECT_EQ(offset, size);
+    EXPECT_EQ(data, QByteArray(64, 1));
+    EXPECT_FALSE(RelayForwarder::ReadMessage(partial, offset, to, data,
+          been, reverse));
+  }
+
+  TEST(RelayForwarder, BatchMalformed)
+  {
+    QByteArray batch;
+    RelayForwarder::AppendMessage(batch, Id(), QByteArray(64, 1),
+        RandomIds(2), RandomIds(1));
+
+    Id to(Id::Zero());
+    QByteArray data;
+    QList<Id> been, reverse;
+
+    // Negative counts and lengths
+    for(int field = 0; field < 3; field++) {
+      QByteArray bad = batch;
+      Serialization::WriteInt(-1, bad, Id::ByteSize + 4 * field);
+      int offset = 0;
+      EXPECT_FALSE(RelayForwarder::ReadMessage(bad, offset, to, data,
+            been, reverse));
+    }
+
+    // Counts and lengths that would overflow or run past the batch
+    int counts[] = { 3, 0x7fffffff, 0x10000000 };
+    int lengths[] = { 65, 0x7fffffff, 0x10000000 };
+    for(int field = 0; field < 3; field++) {
+      for(int idx = 0; idx < 3; idx++) {
+        QByteArray bad = batch;
+        Serialization::WriteInt(field == 2 ? lengths[idx] : counts[idx], bad,
+            Id::ByteSize + 4 * field);
+        int offset = 0;
+        EXPECT_FALSE(RelayForwarder::ReadMessage(bad, offset, to, data,
+              been, reverse));
+      }
+    }
+  }
+
+  TEST(RelayForwarder, RouteDroppedOnDisconnect)
+  {
+    ConnectionManager::UseTimer = false;
+    Timer::GetInstance().UseVirtualTime();
+
+    const BufferAddress addr0(1000);
+    EdgeListener *be0 = EdgeListenerFactory::GetInstance().CreateEdgeListener(addr0);
+    QSharedPointer<RpcHandler> rpc0(new RpcHandler());
+    Id id0;
+    ConnectionManager cm0(id0, rpc0);
+    cm0.AddEdgeListener(QSharedPointer<EdgeListener>(be0));
+    be0->Start();
+
+    const BufferAddress addr1(10001);
+    EdgeListener *be1 = EdgeListenerFactory::GetInstance().CreateEdgeListener(addr1);
+    QSharedPointer<RpcHandler> rpc1(new RpcHandler());
+    Id id1;
+    ConnectionManager cm1(id1, rpc1);
+    cm1.AddEdgeListener(QSharedPointer<EdgeListener>(be1));
+    be1->Start();
+
+    cm0.ConnectTo(addr1);
+
+    qint64 next = Timer::GetInstance().VirtualRun();
+    while(next != -1) {
+      Time::GetInstance().IncrementVirtualClock(next);
+      next = Timer::GetInstance().VirtualRun();
+    }
+
+    QSharedPointer<Connection> con = cm0.GetConnectionTable().GetConnection(id1);
+    ASSERT_TRUE(con);
+
+    TestRelayForwarder rf0(id0, cm0.GetConnectionTable(), rpc0);
+    Id to;
+    rf0.SetRoute(to, con);
+    EXPECT_EQ(rf0.GetCachedRouteCount(), 1);
+    EXPECT_EQ(rf0.GetRoute(to, QList<Id>()), con);
+
+    // A hop already visited is not reused, but the route is kept
+    EXPECT_FALSE(rf0.GetRoute(to, QList<Id>() << id1));
+    EXPECT_EQ(rf0.GetCachedRouteCount(), 1);
+
+    cm1.Stop();
+
+    next = Timer::GetInstance().VirtualRun();
+    while(next != -1) {
+      Time::GetInstance().IncrementVirtualClock(next);
+      next = Timer::GetInstance().VirtualRun();
+    }
+
+    // Dropped on Disconnected, before any lookup
+    ASSERT_FALSE(cm0.GetConnectionTable().GetConnection(id1));
+    EXPECT_EQ(rf0.GetCachedRouteCount(), 0);
+    EXPECT_FALSE(rf0.GetRoute(to, QList<Id>()));
+
+    cm0.Stop();
+    ConnectionManager::UseTimer = true;
+  }
+}
+}
@@ -42,7 +42,7 @@ namespace Tests {
   }
 
   void RoundTest_Basic(SessionCreator callback,
-      Group::SubgroupPolicy sg_policy)
+      Group::SubgroupPolicy sg_policy, int msg_length)
   {
     ConnectionManager::UseTimer = false;
     Timer::GetInstance().UseVirtualTime();
@@ -59,7 +59,7 @@ namespace Tests {
     QScopedPointer<Dissent::Utils::Random> rand(lib->GetRandomNumberGenerator());
 
     // Reducing message size so that it can fit in a BlogDrop group element
-    QByteArray msg(TEST_MESSAGE_LENGTH, 0);
+    QByteArray msg(msg_length, 0);
     rand->GenerateBlock(msg);
     nodes[sender]->session->Send(msg);
 
@@ -144,7 +144,7 @@ namespace Tests {
   }
 
   void RoundTest_MultiRound(SessionCreator callback,
-      Group::SubgroupPolicy sg_policy)
+      Group::SubgroupPolicy sg_policy, int msg_length)
   {
     ConnectionManager::UseTimer = false;
     Timer::GetInstance().UseVirtualTime();
@@ -164,7 +164,7 @@ namespace Tests {
     Library *lib = CryptoFactory::GetInstance().GetLibrary();
     QScopedPointer<Dissent::Utils::Random> rand(lib->GetRandomNumberGenerator());
 
-    QByteArray msg(TEST_MESSAGE_LENGTH, 0);
+    QByteArray msg(msg_length, 0);
     rand->GenerateBlock(msg);
     nodes[sender0]->session->Send(msg);
 
@@ -68,11 +68,11 @@ namespace Tests {
   void RoundTest_Null(SessionCreator callback,
       Group::SubgroupPolicy sg_policy);
   void RoundTest_Basic(SessionCreator callback,
-      Group::SubgroupPolicy sg_policy);
+      Group::SubgroupPolicy sg_policy, int msg_length = TEST_MESSAGE_LENGTH);
   void RoundTest_Basic_SessionTest(SessionCreator callback, 
       Group::SubgroupPolicy sg_policy, SessionTestCallback session_cb);
   void RoundTest_MultiRound(SessionCreator callback,
-      Group::SubgroupPolicy sg_policy);
+      Group::SubgroupPolicy sg_policy, int msg_length = TEST_MESSAGE_LENGTH);
   void RoundTest_AddOne(SessionCreator callback,
       Group::SubgroupPolicy sg_policy);
   void RoundTest_PeerDisconnectEnd(SessionCreator callback,
@@ -63,5 +63,109 @@ namespace Tests {
     EXPECT_EQ(test1.GetResponse().GetErrorType(), Response::InvalidMethod);
     qWarning() << test1.GetResponse().GetError() << test1.GetResponse().GetErrorType();
   }
+
+  TEST(Rpc, BinaryNotification)
+  {
+    RpcHandler rpc0;
+    QSharedPointer<MockSource> ms0(new MockSource());;
+    ms0->SetSink(&rpc0);
+    QSharedPointer<MockSender> to_ms0(new MockSender(ms0));
+
+    RpcHandler rpc1;
+    QSharedPointer<MockSource> ms1(new MockSource());;
+    ms1->SetSink(&rpc1);
+    QSharedPointer<MockSender> to_ms1(new MockSender(ms1));
+    to_ms0->SetReturnPath(to_ms1);
+    to_ms1->SetReturnPath(to_ms0);
+
+    TestRpc test0;
+    EXPECT_TRUE(rpc0.Register("store", &test0, "Store"));
+    EXPECT_FALSE(rpc0.Register("store", &test0, "Store"));
+
+    CppRandom rand;
+    QByteArray payload(100000, 0);
+    rand.GenerateBlock(payload);
+
+    rpc1.SendBinaryNotification(to_ms0, "store", payload);
+    EXPECT_EQ(test0.GetLast().GetMethod(), QString("store"));
+    EXPECT_EQ(test0.GetLast().GetType(), Request::NotificationType);
+    EXPECT_EQ(test0.GetLast().GetData().toByteArray(), payload);
+
+    QVariantHash headers;
+    headers["round"] = 5;
+    rpc1.SendBinaryNotification(to_ms0, "store", headers, payload);
+    QVariantHash received = test0.GetLast().GetData().toHash();
+    EXPECT_EQ(received.value("round").toInt(), 5);
+    EXPECT_EQ(received.value("data").toByteArray(), payload);
+
+    rpc1.SendBinaryNotification(to_ms0, "store", QVariantHash(), QByteArray());
+    received = test0.GetLast().GetData().toHash();
+    EXPECT_TRUE(received.contains("data"));
+    EXPECT_TRUE(received.value("data").toByteArray().isEmpty());
+
+    // Legacy messages are still accepted
+    rpc1.SendNotification(to_ms0, "store", payload);
+    EXPECT_EQ(test0.GetLast().GetData().toByteArray(), payload);
+
+    // Frames of an unknown version are dropped
+    QByteArray frame(16, 0);
+    frame[0] = char(0x81);
+    frame[3] = 2;
+    Utils::Serialization::WriteInt(1, frame, 4);
+    Utils::Serialization::WriteUInt(RpcHandler::GetMethodId("store"), frame, 8);
+    frame.append("frame");
+    rpc0.HandleData(to_ms1, frame);
+    EXPECT_EQ(test0.GetLast().GetData().toByteArray(), payload);
+
+    frame[3] = 1;
+    rpc0.HandleData(to_ms1, frame);
+    EXPECT_EQ(test0.GetLast().GetData().toByteArray(), QByteArray("frame"));
+
+    EXPECT_TRUE(rpc0.Unregister("store"));
+    rpc0.HandleData(to_ms1, frame);
+    EXPECT_EQ(test0.GetLast().GetData().toByteArray(), QByteArray("frame"));
+    EXPECT_NE(RpcHandler::GetMethodId("store"), RpcHandler::GetMethodId("add"));
+  }
+
+  TEST(Rpc, MultipleDestinationNotification)
+  {
+    RpcHandler rpc0;
+    QSharedPointer<MockSource> ms0(new MockSource());;
+    ms0->SetSink(&rpc0);
+    QSharedPointer<MockSender> to_ms0(new MockSender(ms0));
+
+    RpcHandler rpc1;
+    QSharedPointer<MockSource> ms1(new MockSource());;
+    ms1->SetSink(&rpc1);
+    QSharedPointer<MockSender> to_ms1(new MockSender(ms1));
+
+    RpcHandler rpc2;
+    QSharedPointer<MockSource> ms2(new MockSource());;
+    ms2->SetSink(&rpc2);
+    QSharedPointer<MockSender> to_ms2(new MockSender(ms2));
+    to_ms0->SetReturnPath(to_ms2);
+    to_ms1->SetReturnPath(to_ms2);
+
+    TestRpc test0, test1;
+    EXPECT_TRUE(rpc0.Register("store", &test0, "Store"));
+    EXPECT_TRUE(rpc1.Register("store", &test1, "Store"));
+
+    QList<QSharedPointer<ISender> > targets;
+    targets.append(to_ms0);
+    targets.append(to_ms1);
+
+    QVariantList data;
+    data.append(QString("broadcast"));
+    data.append(5);
+    rpc2.SendNotification(targets, "store", data);
+
+    EXPECT_EQ(test0.GetLast().GetMethod(), QString("store"));
+    EXPECT_EQ(test0.GetLast().GetData().toList(), data);
+    EXPECT_EQ(test1.GetLast().GetMethod(), QString("store"));
+    EXPECT_EQ(test1.GetLast().GetData().toList(), data);
+
+    EXPECT_TRUE(rpc0.Unregister("store"));
+    EXPECT_TRUE(rpc1.Unregister("store"));
+  }
 }
 }
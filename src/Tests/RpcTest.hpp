@@ -31,6 +31,17 @@ namespace Tests {
 
         request.Respond(x + y);
       }
+
+      void Store(const Request &request)
+      {
+        _last = request;
+      }
+
+    public:
+      Request GetLast() const { return _last; }
+
+    private:
+      Request _last;
   };
 
   class TestResponse : public QObject {
@@ -0,0 +1,30 @@
+#include "DissentTest.hpp"
+
+namespace Dissent {
+namespace Tests {
+  TEST(SpillFile, Basic)
+  {
+    SpillFile spill;
+    ASSERT_TRUE(spill.IsValid());
+    EXPECT_EQ(spill.Size(), 0);
+
+    CppRandom rand;
+    QList<QByteArray> blocks;
+    QList<qint64> positions;
+    for(int idx = 0; idx < 10; idx++) {
+      QByteArray block(rand.GetInt(1, 100000), 0);
+      rand.GenerateBlock(block);
+      blocks.append(block);
+      positions.append(spill.Append(block));
+      EXPECT_EQ(spill.Read(positions[idx], block.size()), block);
+    }
+
+    for(int idx = 0; idx < blocks.count(); idx++) {
+      EXPECT_EQ(spill.Read(positions[idx], blocks[idx].size()), blocks[idx]);
+    }
+
+    EXPECT_TRUE(spill.Read(spill.Size(), 1).isEmpty());
+    EXPECT_TRUE(spill.Read(-1, 1).isEmpty());
+  }
+}
+}
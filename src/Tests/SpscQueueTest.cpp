@@ -0,0 +1,56 @@
+#include <QtConcurrentRun>
+
+#include "DissentTest.hpp"
+
+namespace Dissent {
+namespace Tests {
+namespace {
+  const int Count = 100000;
+
+  void Produce(SpscQueue<int> *queue)
+  {
+    for(int idx = 0; idx < Count; idx++) {
+      queue->Enqueue(idx);
+    }
+  }
+}
+
+  TEST(SpscQueue, Basic)
+  {
+    SpscQueue<QByteArray> queue;
+    QByteArray value;
+    EXPECT_TRUE(queue.IsEmpty());
+    EXPECT_FALSE(queue.Dequeue(value));
+
+    queue.Enqueue("a");
+    queue.Enqueue("b");
+    EXPECT_FALSE(queue.IsEmpty());
+    EXPECT_TRUE(queue.Dequeue(value));
+    EXPECT_EQ(value, QByteArray("a"));
+    EXPECT_TRUE(queue.Dequeue(value));
+    EXPECT_EQ(value, QByteArray("b"));
+    EXPECT_FALSE(queue.Dequeue(value));
+
+    // Values left behind are released with the queue
+    queue.Enqueue("c");
+  }
+
+  TEST(SpscQueue, Threaded)
+  {
+    SpscQueue<int> queue;
+    QFuture<void> producer = QtConcurrent::run(Produce, &queue);
+
+    int expected = 0;
+    while(expected < Count) {
+      int value;
+      if(queue.Dequeue(value)) {
+        EXPECT_EQ(value, expected);
+        expected++;
+      }
+    }
+
+    producer.waitForFinished();
+    EXPECT_TRUE(queue.IsEmpty());
+  }
+}
+}
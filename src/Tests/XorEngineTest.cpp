@@ -0,0 +1,109 @@
+#include "DissentTest.hpp"
+
+namespace Dissent {
+namespace Tests {
+  QByteArray SlowXor(const QByteArray &t1, const QByteArray &t2)
+  {
+    QByteArray dst(std::min(t1.size(), t2.size()), 0);
+    for(int idx = 0; idx < dst.size(); idx++) {
+      dst[idx] = t1[idx] ^ t2[idx];
+    }
+    return dst;
+  }
+
+  TEST(XorEngine, Implementations)
+  {
+    Random &rand = Random::GetInstance();
+
+    for(int impl = XorEngine::Portable; impl < XorEngine::Automatic; impl++) {
+      XorEngine::Implementation ximpl = static_cast<XorEngine::Implementation>(impl);
+      if(!XorEngine::IsSupported(ximpl)) {
+        continue;
+      }
+      XorEngine::SetImplementation(ximpl);
+      EXPECT_EQ(XorEngine::GetImplementation(), ximpl);
+
+      for(int count = 0; count < 20; count++) {
+        int length = rand.GetInt(0, 3 * XorEngine::ChunkSize);
+        QByteArray t1(length, 0);
+        QByteArray t2(length, 0);
+        rand.GenerateBlock(t1);
+        rand.GenerateBlock(t2);
+
+        QByteArray expected = SlowXor(t1, t2);
+        QByteArray dst(length, 0);
+        XorEngine::Xor(dst.data(), t1.constData(), t2.constData(), length);
+        EXPECT_EQ(dst, expected);
+
+        // Unaligned, in place
+        int offset = rand.GetInt(0, 16);
+        if(offset < length) {
+          QByteArray t3 = t1;
+          XorEngine::Xor(t3.data() + offset, t3.constData() + offset,
+              t2.constData() + offset, length - offset);
+          EXPECT_EQ(t3.mid(offset), expected.mid(offset));
+          EXPECT_EQ(t3.left(offset), t1.left(offset));
+        }
+      }
+    }
+
+    XorEngine::SetImplementation(XorEngine::Automatic);
+  }
+
+  TEST(XorEngine, Fold)
+  {
+    Random &rand = Random::GetInstance();
+    int length = 2 * XorEngine::ChunkSize + rand.GetInt(1, 1024);
+
+    QList<QByteArray> sources;
+    QByteArray expected(length, 0);
+    for(int idx = 0; idx < 10; idx++) {
+      QByteArray source(length, 0);
+      rand.GenerateBlock(source);
+      sources.append(source);
+      expected = SlowXor(expected, source);
+    }
+
+    QByteArray dst(length, 0);
+    XorEngine::Fold(dst, sources);
+    EXPECT_EQ(dst, expected);
+
+    // Shorter sources only modify their prefix
+    QByteArray shorter(length / 2, 0);
+    rand.GenerateBlock(shorter);
+    QByteArray partial = SlowXor(expected, shorter) + expected.mid(shorter.size());
+    XorEngine::Fold(dst, QList<QByteArray>() << shorter << QByteArray());
+    EXPECT_EQ(dst, partial);
+
+    // Every implementation folds all sources in one pass, at any offset
+    QVector<const char *> csources;
+    foreach(const QByteArray &source, sources) {
+      csources.append(source.constData());
+    }
+
+    for(int impl = XorEngine::Portable; impl < XorEngine::Automatic; impl++) {
+      XorEngine::Implementation ximpl = static_cast<XorEngine::Implementation>(impl);
+      if(!XorEngine::IsSupported(ximpl)) {
+        continue;
+      }
+      XorEngine::SetImplementation(ximpl);
+
+      QByteArray folded(length, 0);
+      XorEngine::Fold(folded.data(), csources, length);
+      EXPECT_EQ(folded, expected);
+
+      int offset = rand.GetInt(1, 128);
+      QVector<const char *> offset_sources;
+      foreach(const char *source, csources) {
+        offset_sources.append(source + offset);
+      }
+      folded.fill(0);
+      XorEngine::Fold(folded.data() + offset, offset_sources, length - offset);
+      EXPECT_EQ(folded.mid(offset), expected.mid(offset));
+      EXPECT_EQ(folded.left(offset), QByteArray(offset, 0));
+    }
+
+    XorEngine::SetImplementation(XorEngine::Automatic);
+  }
+}
+}
@@ -1,33 +1,31 @@
 #include "TcpEdge.hpp"
-#include "Utils/Serialization.hpp"
+#include "TcpEdgeWorker.hpp"
 #include "Utils/Time.hpp"
 
-using Dissent::Utils::Serialization;
-
 namespace Dissent {
 namespace Transports {
-  const QByteArray TcpEdge::Zero = QByteArray(4, 0);
-
   TcpEdge::TcpEdge(const Address &local, const Address &remote, bool outgoing,
       QTcpSocket *socket) :
     Edge(local, remote, outgoing),
-    _socket(socket, &QObject::deleteLater),
-    _connected(true)
+    _worker(new TcpEdgeWorker(socket)),
+    _deferred_reads(0),
+    _total_queueing_delay(0),
+    _max_queueing_delay(0)
   {
-    socket->setParent(0);
-
-    socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
-
-    QObject::connect(socket, SIGNAL(readyRead()), this, SLOT(Read()));
+    QObject::connect(_worker, SIGNAL(MessagesAvailable()), this, SLOT(Read()),
+        Qt::QueuedConnection);
     QObject::connect(this, SIGNAL(DelayedRead()), this, SLOT(Read()),
         Qt::QueuedConnection);
-    QObject::connect(socket, SIGNAL(disconnected()), this, SLOT(HandleDisconnect()));
-    QObject::connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
-        this, SLOT(HandleError(QAbstractSocket::SocketError)));
+    QObject::connect(_worker, SIGNAL(Disconnected()), this,
+        SLOT(HandleDisconnect()), Qt::QueuedConnection);
+    QObject::connect(_worker, SIGNAL(Error(const QString &)),
+        this, SLOT(HandleError(const QString &)), Qt::QueuedConnection);
   }
 
   TcpEdge::~TcpEdge()
   {
+    // The worker lives on the I/O thread and must be deleted there
+    _worker->deleteLater();
   }
 
   void TcpEdge::Send(const QByteArray &data)
@@ -37,90 +35,85 @@ namespace Transports {
       return;
     }
 
-    QByteArray length(4, 0);
-    Serialization::WriteInt(data.size(), length, 0);
-    if((_socket->write(length) != 4) ||
-        (_socket->write(data) != data.size()) ||
-        (_socket->write(Zero) != 4))
-    {
-      qCritical() << "Didn't write all data to the socket!!!!!";
-    }
+    _worker->Send(data);
     Sent();
   }
 
   void TcpEdge::Read()
   {
-    int total_length = _socket->bytesAvailable();
-    qint64 stime = Utils::Time::GetInstance().MSecsSinceEpoch();
-    qint64 ntime = stime;
-    bool delay = false;
-
-    while(total_length >= 8 && !delay) {
-      QByteArray length_arr = _socket->peek(4);
-      if(length_arr.isEmpty()) {
-        qCritical() << "Error reading Tcp socket in" << ToString();
-        Stop("Error reading Tcp socket");
-        return;
-      }
-
-      int length = Serialization::ReadInt(length_arr, 0);
-      if(length + 8 > total_length) {
-        break;
-      }
-
-      if(length < 0) {
-        Stop("Error reading Tcp socket");
-        return;
-      }
+    // A deferred read may still be queued behind the disconnect, which
+    // already delivered everything the remote side sent
+    if(Stopped()) {
+      return;
+    }
 
-      QByteArray msg = _socket->read(length + 8);
-      if(msg.isEmpty()) {
-        Stop("Error reading Tcp socket");
-        qCritical() << "Error reading Tcp socket in" << ToString();
-        return;
-      }
+    int byte_budget = ReadByteBudget;
+    int msg_budget = ReadMessageBudget;
 
-      if(Serialization::ReadInt(msg, length + 4) != 0) {
-        qCritical() << "Mismatch on byte array!";
-      }
+    // Rearm before draining, so a message arriving afterwards notifies again
+    _worker->ClearNotification();
 
-      PushData(GetSharedPointer(), msg.mid(4, length));
-      total_length = _socket->bytesAvailable();
-      ntime = Utils::Time::GetInstance().MSecsSinceEpoch();
-      delay = (ntime - stime) > 1000;
+    // Draining below the worker's high-water mark resumes its socket reads
+    TcpEdgeWorker::Incoming incoming;
+    while(byte_budget > 0 && msg_budget > 0 && _worker->Receive(incoming)) {
+      byte_budget -= incoming.msg.size();
+      msg_budget--;
+      Deliver(incoming.msg, incoming.received);
+      incoming = TcpEdgeWorker::Incoming();
     }
 
-    if(delay) {
-      QObject::disconnect(_socket.data(), SIGNAL(readyRead()), this, SLOT(Read()));
+    // Out of budget: yield to the other edges and resume behind them
+    if(byte_budget <= 0 || msg_budget <= 0) {
+      _deferred_reads++;
       emit DelayedRead();
-      _connected = false;
-    } else if(!_connected) {
-      QObject::connect(_socket.data(), SIGNAL(readyRead()), this, SLOT(Read()));
-      _connected = true;
     }
   }
 
+  void TcpEdge::Deliver(const QByteArray &msg, qint64 received)
+  {
+    qint64 delay = Utils::Time::GetInstance().MSecsSinceEpoch() - received;
+    _total_queueing_delay += delay;
+    _max_queueing_delay = qMax(_max_queueing_delay, delay);
+
+    PushData(GetSharedPointer(), msg);
+  }
+
   void TcpEdge::OnStop()
   {
     Edge::OnStop();
+    if(_deferred_reads) {
+      qDebug() << ToString() << "deferred reads:" << _deferred_reads <<
+        "queueing delay total:" << _total_queueing_delay << "max:" <<
+        _max_queueing_delay;
+    }
+
     // The following is somewhat dangerous but we do not have a clear definition of
     // the effect on what a Stop call has on an Edge.
-    _socket->abort();
-//    _socket->disconnectFromHost();
+    _worker->Close();
   }
 
-  void TcpEdge::HandleError(QAbstractSocket::SocketError)
+  void TcpEdge::HandleError(const QString &reason)
   {
     // If the close reason isn't empty, it was closed by the other side, no
     // need to report anything
-    if(Stop(_socket->errorString())) {
+    if(Stop(reason)) {
       qWarning() << "Received warning from TcpEdge (" << ToString() << "):" <<
-        _socket->errorString();
+        reason;
     }
   }
 
   void TcpEdge::HandleDisconnect()
   {
+    // Deliver whatever the remote side sent before closing, while the edge
+    // is still up. Any deferred read then finds the edge stopped.
+    if(!Stopped()) {
+      TcpEdgeWorker::Incoming incoming;
+      while(_worker->Receive(incoming)) {
+        Deliver(incoming.msg, incoming.received);
+        incoming = TcpEdgeWorker::Incoming();
+      }
+    }
+
     // This will only succeed if Stop hasn't been called, so no loss...
     Stop("Disconnected");
     StopCompleted();
@@ -1,21 +1,32 @@
 #ifndef DISSENT_TRANSPORTS_TCP_EDGE_H_GUARD
 #define DISSENT_TRANSPORTS_TCP_EDGE_H_GUARD
 
-#include <QSharedPointer>
 #include <QTcpSocket>
 #include "Edge.hpp"
 #include "TcpAddress.hpp"
 
 namespace Dissent {
 namespace Transports {
+  class TcpEdgeWorker;
+
   /**
-   * Uses reliable IP networking: Tcp
+   * Uses reliable IP networking: Tcp.  Socket I/O and framing happen on the
+   * network I/O thread, see TcpEdgeWorker, while the edge delivers complete
+   * messages on the protocol thread.
    */
   class TcpEdge : public Edge {
     Q_OBJECT
 
     public:
-      static const QByteArray Zero;
+      /**
+       * Bytes delivered per turn before yielding to other edges
+       */
+      static const int ReadByteBudget = 256 * 1024;
+
+      /**
+       * Messages delivered per turn before yielding to other edges
+       */
+      static const int ReadMessageBudget = 32;
 
       /**
        * Constructor
@@ -55,6 +66,26 @@ namespace Transports {
         Edge::SetRemotePersistentAddress(TcpAddress(ha.toString(), new_ta.GetPort()));
       }
 
+      /**
+       * Returns how often the edge yielded with messages still waiting
+       */
+      inline int GetDeferredReads() const { return _deferred_reads; }
+
+      /**
+       * Returns the total time in ms received messages waited before being
+       * delivered, that is, behind the protocol thread and other edges
+       */
+      inline qint64 GetTotalQueueingDelay() const
+      {
+        return _total_queueing_delay;
+      }
+
+      /**
+       * Returns the longest time in ms a received message waited before
+       * being delivered
+       */
+      inline qint64 GetMaxQueueingDelay() const { return _max_queueing_delay; }
+
     protected:
       virtual bool RequiresCleanup() { return true; }
 
@@ -65,12 +96,22 @@ namespace Transports {
 
     private slots:
       void HandleDisconnect();
-      void HandleError(QAbstractSocket::SocketError error);
+      void HandleError(const QString &reason);
       void Read();
 
     private:
-      QSharedPointer<QTcpSocket> _socket;
-      bool _connected;
+      /**
+       * Records how long a received message waited and passes it up
+       * @param msg the message
+       * @param received when the worker received the message, in ms
+       */
+      void Deliver(const QByteArray &msg, qint64 received);
+
+      TcpEdgeWorker *_worker;
+
+      int _deferred_reads;
+      qint64 _total_queueing_delay;
+      qint64 _max_queueing_delay;
 
     signals:
       void DelayedRead();
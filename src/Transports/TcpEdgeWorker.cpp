@@ -0,0 +1,247 @@
+#include <QDebug>
+#include <QMetaObject>
+
+#include "Utils/Serialization.hpp"
+#include "Utils/Time.hpp"
+
+#include "TcpEdgeWorker.hpp"
+
+using Dissent::Utils::Serialization;
+
+namespace Dissent {
+namespace Transports {
+namespace {
+  /**
+   * Runs the I/O thread for the lifetime of the process
+   */
+  class IoThread : public QThread {
+    public:
+      IoThread()
+      {
+        setObjectName("Network I/O");
+        start();
+      }
+
+      virtual ~IoThread()
+      {
+        quit();
+        wait();
+      }
+  };
+}
+
+  const QByteArray TcpEdgeWorker::Zero = QByteArray(4, 0);
+  bool TcpEdgeWorker::_use_io_thread = true;
+
+  TcpEdgeWorker::TcpEdgeWorker(QTcpSocket *socket) :
+    _socket(socket),
+    _notify_pending(0),
+    _flush_pending(0),
+    _queued_bytes(0),
+    _read_paused(0),
+    _read_length(0),
+    _read_offset(0),
+    _read_pending(false)
+  {
+    socket->setParent(this);
+    socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    socket->setReadBufferSize(SocketReadBufferSize);
+
+    QObject::connect(socket, SIGNAL(readyRead()), this, SLOT(Read()));
+    QObject::connect(socket, SIGNAL(disconnected()), this, SLOT(HandleDisconnect()));
+    QObject::connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
+        this, SLOT(HandleError(QAbstractSocket::SocketError)));
+
+    if(_use_io_thread) {
+      moveToThread(GetIoThread());
+    }
+
+    // Data may have arrived before the worker was listening
+    QMetaObject::invokeMethod(this, "Read", Qt::QueuedConnection);
+  }
+
+  TcpEdgeWorker::~TcpEdgeWorker()
+  {
+  }
+
+  QThread *TcpEdgeWorker::GetIoThread()
+  {
+    static IoThread thread;
+    return &thread;
+  }
+
+  void TcpEdgeWorker::SetUseIoThread(bool enabled)
+  {
+    _use_io_thread = enabled;
+  }
+
+  void TcpEdgeWorker::Send(const QByteArray &msg)
+  {
+    _outgoing.Enqueue(msg);
+    if(_flush_pending.testAndSetOrdered(0, 1)) {
+      QMetaObject::invokeMethod(this, "Flush", Qt::QueuedConnection);
+    }
+  }
+
+  bool TcpEdgeWorker::Receive(Incoming &incoming)
+  {
+    if(!_incoming.Dequeue(incoming)) {
+      return false;
+    }
+
+    int queued = _queued_bytes.fetchAndAddOrdered(-incoming.msg.size()) -
+      incoming.msg.size();
+    if(queued < HighWaterMark / 2 && _read_paused.testAndSetOrdered(1, 0)) {
+      QMetaObject::invokeMethod(this, "Read", Qt::QueuedConnection);
+    }
+    return true;
+  }
+
+  void TcpEdgeWorker::Close()
+  {
+    QMetaObject::invokeMethod(this, "Abort", Qt::QueuedConnection);
+  }
+
+  void TcpEdgeWorker::Flush()
+  {
+    _flush_pending.fetchAndStoreOrdered(0);
+
+    QByteArray data;
+    while(_outgoing.Dequeue(data)) {
+      // QTcpSocket copies every write into its own buffer, so a large
+      // message is cheapest written in place between its header and trailer
+      bool written;
+      if(data.size() <= CoalesceLimit) {
+        QByteArray frame;
+        frame.reserve(data.size() + 8);
+        frame.resize(4);
+        Serialization::WriteInt(data.size(), frame, 0);
+        frame.append(data);
+        frame.append(Zero);
+        written = (_socket->write(frame) == frame.size());
+      } else {
+        QByteArray length(4, 0);
+        Serialization::WriteInt(data.size(), length, 0);
+        written = (_socket->write(length) == 4) &&
+          (_socket->write(data) == data.size()) &&
+          (_socket->write(Zero) == 4);
+      }
+
+      if(!written) {
+        qCritical() << "Didn't write all data to the socket!!!!!";
+      }
+    }
+  }
+
+  bool TcpEdgeWorker::ReadHeader()
+  {
+    char header[4];
+    if(_socket->read(header, 4) != 4) {
+      return false;
+    }
+
+    int length = Serialization::ReadInt(QByteArray::fromRawData(header, 4), 0);
+    if(length < 0 || length > MaxMessageSize) {
+      qWarning() << "Invalid Tcp frame length:" << length;
+      return false;
+    }
+
+    // The trailer is read into the message and dropped once it is complete
+    _read_msg = QByteArray();
+    _read_length = length;
+    _read_offset = 0;
+    _read_pending = true;
+    return true;
+  }
+
+  void TcpEdgeWorker::Read()
+  {
+    bool received = false;
+
+    while(true) {
+      // Leave the rest in the kernel until the protocol thread catches up,
+      // rechecking after pausing in case it drained the queue meanwhile
+      if(_queued_bytes.fetchAndAddOrdered(0) >= HighWaterMark) {
+        _read_paused.fetchAndStoreOrdered(1);
+        if(_queued_bytes.fetchAndAddOrdered(0) >= HighWaterMark) {
+          break;
+        }
+        _read_paused.testAndSetOrdered(1, 0);
+      }
+
+      if(!_read_pending) {
+        if(_socket->bytesAvailable() < 4) {
+          break;
+        }
+
+        if(!ReadHeader()) {
+          emit Error("Error reading Tcp socket");
+          return;
+        }
+      }
+
+      // Drain whatever has arrived, so the socket's own buffer never holds
+      // more than a fraction of a large message
+      qint64 available = _socket->bytesAvailable();
+      if(available <= 0) {
+        break;
+      }
+
+      // Bounded by MaxMessageSize, so adding the trailer cannot overflow
+      int wanted = _read_length + 4 - _read_offset;
+      int count = int(qMin(available, qint64(wanted)));
+      _read_msg.resize(_read_offset + count);
+      qint64 read = _socket->read(_read_msg.data() + _read_offset, count);
+      if(read < 0) {
+        emit Error("Error reading Tcp socket");
+        return;
+      }
+
+      _read_offset += read;
+      if(read < count) {
+        _read_msg.resize(_read_offset);
+      }
+
+      if(_read_offset < _read_length + 4) {
+        break;
+      }
+
+      int length = _read_length;
+      if(Serialization::ReadInt(_read_msg, length) != 0) {
+        qCritical() << "Mismatch on byte array!";
+      }
+
+      // Dropping the trailer shrinks in place, the message is not copied
+      Incoming incoming;
+      incoming.msg = _read_msg;
+      _read_msg = QByteArray();
+      _read_pending = false;
+      incoming.msg.resize(length);
+      incoming.received = Utils::Time::GetInstance().MSecsSinceEpoch();
+
+      _queued_bytes.fetchAndAddOrdered(length);
+      _incoming.Enqueue(incoming);
+      received = true;
+    }
+
+    if(received && _notify_pending.testAndSetOrdered(0, 1)) {
+      emit MessagesAvailable();
+    }
+  }
+
+  void TcpEdgeWorker::Abort()
+  {
+    _socket->abort();
+  }
+
+  void TcpEdgeWorker::HandleDisconnect()
+  {
+    emit Disconnected();
+  }
+
+  void TcpEdgeWorker::HandleError(QAbstractSocket::SocketError)
+  {
+    emit Error(_socket->errorString());
+  }
+}
+}
@@ -0,0 +1,165 @@
+#ifndef DISSENT_TRANSPORTS_TCP_EDGE_WORKER_H_GUARD
+#define DISSENT_TRANSPORTS_TCP_EDGE_WORKER_H_GUARD
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QObject>
+#include <QTcpSocket>
+#include <QThread>
+
+#include "Utils/SpscQueue.hpp"
+
+namespace Dissent {
+namespace Transports {
+  /**
+   * Owns a TcpEdge's socket on the network I/O thread and performs the
+   * framing there.  Complete messages and outgoing messages cross between
+   * the I/O thread and the protocol thread through a pair of single
+   * producer, single consumer queues, so a long computation on the
+   * protocol thread does not stall reception.  Each message is framed as a
+   * 4 byte length, the message, and a 4 byte zero trailer.
+   */
+  class TcpEdgeWorker : public QObject {
+    Q_OBJECT
+
+    public:
+      static const QByteArray Zero;
+
+      /**
+       * Messages up to this size are framed into a single socket write,
+       * larger ones are written in place to avoid copying them twice
+       */
+      static const int CoalesceLimit = 65536;
+
+      /**
+       * Frames claiming a longer message are treated as a corrupt stream
+       */
+      static const int MaxMessageSize = 256 * 1024 * 1024;
+
+      /**
+       * Once this many received bytes wait for the protocol thread the
+       * socket is no longer read, so TCP flow control slows the sender.
+       * Reading resumes when the protocol thread drains below half of it.
+       */
+      static const int HighWaterMark = 16 * 1024 * 1024;
+
+      /**
+       * Bounds what the socket pulls from the kernel ahead of the framing,
+       * otherwise QTcpSocket buffers without limit while reading is paused
+       */
+      static const int SocketReadBufferSize = 1024 * 1024;
+
+      /**
+       * A received message and the time it was received
+       */
+      struct Incoming {
+        Incoming() : received(0) {}
+
+        QByteArray msg;
+        qint64 received;
+      };
+
+      /**
+       * Constructor, called on the protocol thread, moves itself and the
+       * socket onto the I/O thread
+       * @param socket the connected socket
+       */
+      explicit TcpEdgeWorker(QTcpSocket *socket);
+
+      /**
+       * Destructor
+       */
+      virtual ~TcpEdgeWorker();
+
+      /**
+       * Queues a message for sending, called on the protocol thread
+       * @param msg the message
+       */
+      void Send(const QByteArray &msg);
+
+      /**
+       * Takes the next received message, called on the protocol thread,
+       * resumes reading the socket once the queue has drained
+       * @param incoming set to the message
+       * @returns false if there are none
+       */
+      bool Receive(Incoming &incoming);
+
+      /**
+       * Rearms MessagesAvailable, called on the protocol thread before it
+       * drains the received messages
+       */
+      inline void ClearNotification() { _notify_pending.fetchAndStoreOrdered(0); }
+
+      /**
+       * Aborts the connection, called on the protocol thread
+       */
+      void Close();
+
+      /**
+       * Enables or disables the I/O thread for workers created afterwards,
+       * when disabled the socket remains on the protocol thread
+       */
+      static void SetUseIoThread(bool enabled);
+
+    signals:
+      /**
+       * Emitted once, on the I/O thread, when messages become available
+       * after a ClearNotification
+       */
+      void MessagesAvailable();
+
+      /**
+       * Emitted when the remote side disconnects
+       */
+      void Disconnected();
+
+      /**
+       * Emitted on a socket error
+       * @param reason the socket's error description
+       */
+      void Error(const QString &reason);
+
+    private slots:
+      void Read();
+      void Flush();
+      void Abort();
+      void HandleDisconnect();
+      void HandleError(QAbstractSocket::SocketError error);
+
+    private:
+      /**
+       * Reads the next frame header, returns false if the stream is corrupt
+       */
+      bool ReadHeader();
+
+      static QThread *GetIoThread();
+
+      QTcpSocket *_socket;
+
+      Utils::SpscQueue<Incoming> _incoming;
+      Utils::SpscQueue<QByteArray> _outgoing;
+      QAtomicInt _notify_pending;
+      QAtomicInt _flush_pending;
+
+      /**
+       * Bytes in _incoming, and whether reading stopped at HighWaterMark
+       */
+      QAtomicInt _queued_bytes;
+      QAtomicInt _read_paused;
+
+      /**
+       * The message being received, filled directly from the socket and
+       * grown as its bytes arrive rather than sized by the untrusted header
+       */
+      QByteArray _read_msg;
+      int _read_length;
+      int _read_offset;
+      bool _read_pending;
+
+      static bool _use_io_thread;
+  };
+}
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "Random.hpp"
 #include "Serialization.hpp"
+#include "XorEngine.hpp"
 
 namespace Dissent {
 namespace Utils {
@@ -74,5 +75,19 @@ namespace Utils {
       data[idx] = GetInt(0, 0x100);
     }
   }
+
+  void Random::XorBlock(QByteArray &data)
+  {
+    QByteArray tmp(qMin(data.size(), int(XorChunkSize)), 0);
+    char *cdata = data.data();
+    for(int offset = 0; offset < data.size(); offset += tmp.size()) {
+      if(data.size() - offset < tmp.size()) {
+        tmp.resize(data.size() - offset);
+      }
+      GenerateBlock(tmp);
+      XorEngine::Xor(cdata + offset, cdata + offset, tmp.constData(),
+          tmp.size());
+    }
+  }
 }
 }
@@ -44,6 +44,19 @@ namespace Utils {
        */
       virtual void GenerateBlock(QByteArray &data);
 
+      /**
+       * Xors the next data.size() random bytes into data, equivalent to
+       * calling GenerateBlock on a temporary and xoring it into data but
+       * without materializing the full temporary
+       * @param data QByteArray to xor random data into
+       */
+      virtual void XorBlock(QByteArray &data);
+
+      /**
+       * Size of the temporary used by the default XorBlock implementation
+       */
+      static const int XorChunkSize = 4096;
+
       /**
        * Returns the amount of bytes generated thus far
        */
@@ -60,7 +73,7 @@ namespace Utils {
        * Moves the rng to specified position
        * @param index the position
        */
-      void MoveRngPosition(uint index);
+      virtual void MoveRngPosition(uint index);
 
     private:
       uint _seed;
@@ -0,0 +1,78 @@
+#include <QDebug>
+
+#include "SpillFile.hpp"
+
+namespace Dissent {
+namespace Utils {
+  SpillFile::SpillFile() :
+    _size(0),
+    _map(0),
+    _mapped(0)
+  {
+    _valid = _file.open();
+    if(!_valid) {
+      qWarning() << "Unable to create a spill file:" << _file.errorString();
+    }
+  }
+
+  SpillFile::~SpillFile()
+  {
+    if(_map) {
+      _file.unmap(_map);
+    }
+  }
+
+  qint64 SpillFile::Append(const QByteArray &data)
+  {
+    if(!_valid) {
+      return -1;
+    }
+
+    qint64 position = _size;
+    if(!_file.seek(position) || _file.write(data) != data.size()) {
+      qWarning() << "Unable to write to a spill file:" << _file.errorString();
+      return -1;
+    }
+
+    _size += data.size();
+    return position;
+  }
+
+  QByteArray SpillFile::Read(qint64 position, int length)
+  {
+    if(position < 0 || length < 0 || position + length > _size) {
+      return QByteArray();
+    } else if(length == 0) {
+      return QByteArray("");
+    }
+
+    if(position + length > _mapped && !Map()) {
+      return QByteArray();
+    }
+
+    return QByteArray(reinterpret_cast<const char *>(_map + position), length);
+  }
+
+  bool SpillFile::Map()
+  {
+    if(_map) {
+      _file.unmap(_map);
+      _map = 0;
+      _mapped = 0;
+    }
+
+    if(!_file.flush()) {
+      return false;
+    }
+
+    _map = _file.map(0, _size);
+    if(!_map) {
+      qWarning() << "Unable to map a spill file:" << _file.errorString();
+      return false;
+    }
+
+    _mapped = _size;
+    return true;
+  }
+}
+}
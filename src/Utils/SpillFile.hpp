@@ -0,0 +1,66 @@
+#ifndef DISSENT_UTILS_SPILL_FILE_H_GUARD
+#define DISSENT_UTILS_SPILL_FILE_H_GUARD
+
+#include <QByteArray>
+#include <QTemporaryFile>
+
+namespace Dissent {
+namespace Utils {
+  /**
+   * An append-only temporary file for data that must be retained but is
+   * rarely read back.  Reads go through a memory mapping of the file that
+   * is extended as the file grows.  The file is removed upon destruction.
+   */
+  class SpillFile {
+    public:
+      /**
+       * Constructor, creates the backing file
+       */
+      explicit SpillFile();
+
+      /**
+       * Destructor
+       */
+      ~SpillFile();
+
+      /**
+       * Returns true if the backing file could be created
+       */
+      bool IsValid() const { return _valid; }
+
+      /**
+       * Appends data to the end of the file
+       * @param data the data to append
+       * @returns the position of data in the file or -1 on failure
+       */
+      qint64 Append(const QByteArray &data);
+
+      /**
+       * Returns a copy of previously appended data
+       * @param position the position returned by Append
+       * @param length the number of bytes to read
+       * @returns the data or an empty array on failure
+       */
+      QByteArray Read(qint64 position, int length);
+
+      /**
+       * Returns the number of bytes appended
+       */
+      qint64 Size() const { return _size; }
+
+    private:
+      SpillFile(const SpillFile &);
+      void operator=(const SpillFile &);
+
+      bool Map();
+
+      QTemporaryFile _file;
+      bool _valid;
+      qint64 _size;
+      uchar *_map;
+      qint64 _mapped;
+  };
+}
+}
+
+#endif
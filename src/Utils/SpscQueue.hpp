@@ -0,0 +1,87 @@
+#ifndef DISSENT_UTILS_SPSC_QUEUE_H_GUARD
+#define DISSENT_UTILS_SPSC_QUEUE_H_GUARD
+
+#include <QAtomicPointer>
+
+namespace Dissent {
+namespace Utils {
+  /**
+   * An unbounded lock-free queue for exactly one producer thread and one
+   * consumer thread.  The producer only touches the tail and the consumer
+   * only the head, the sole shared state is each node's next pointer.
+   */
+  template<typename T> class SpscQueue {
+    public:
+      SpscQueue() :
+        _head(new Node()),
+        _tail(_head)
+      {
+      }
+
+      ~SpscQueue()
+      {
+        while(_head) {
+          Node *next = _head->next;
+          delete _head;
+          _head = next;
+        }
+      }
+
+      /**
+       * Appends a value, only called by the producer
+       * @param value the value
+       */
+      void Enqueue(const T &value)
+      {
+        Node *node = new Node();
+        node->value = value;
+        // Publishes the value along with the node
+        _tail->next.fetchAndStoreRelease(node);
+        _tail = node;
+      }
+
+      /**
+       * Removes the oldest value, only called by the consumer
+       * @param value set to the oldest value
+       * @returns false if the queue was empty
+       */
+      bool Dequeue(T &value)
+      {
+        Node *next = _head->next.fetchAndAddAcquire(0);
+        if(!next) {
+          return false;
+        }
+
+        // next becomes the new placeholder, drop its value's reference
+        value = next->value;
+        next->value = T();
+        delete _head;
+        _head = next;
+        return true;
+      }
+
+      /**
+       * Returns true if the queue is empty, only called by the consumer
+       */
+      bool IsEmpty()
+      {
+        return _head->next.fetchAndAddAcquire(0) == 0;
+      }
+
+    private:
+      struct Node {
+        Node() : next(0) {}
+
+        T value;
+        QAtomicPointer<Node> next;
+      };
+
+      Node *_head;
+      Node *_tail;
+
+      Q_DISABLE_COPY(SpscQueue)
+  };
+}
+}
+
+#endif
@@ -0,0 +1,335 @@
+#include <string.h>
+#include <QtGlobal>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DISSENT_XOR_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#include "XorEngine.hpp"
+
+namespace Dissent {
+namespace Utils {
+namespace {
+  void XorPortable(char *dst, const char *t1, const char *t2, int length)
+  {
+    int idx = 0;
+    for(; idx + 32 <= length; idx += 32) {
+      quint64 a[4], b[4];
+      memcpy(a, t1 + idx, 32);
+      memcpy(b, t2 + idx, 32);
+      a[0] ^= b[0];
+      a[1] ^= b[1];
+      a[2] ^= b[2];
+      a[3] ^= b[3];
+      memcpy(dst + idx, a, 32);
+    }
+
+    for(; idx + 8 <= length; idx += 8) {
+      quint64 a, b;
+      memcpy(&a, t1 + idx, 8);
+      memcpy(&b, t2 + idx, 8);
+      a ^= b;
+      memcpy(dst + idx, &a, 8);
+    }
+
+    for(; idx < length; idx++) {
+      dst[idx] = t1[idx] ^ t2[idx];
+    }
+  }
+
+  // Folds count sources into dst over [offset, offset + length), loading and
+  // storing each block of dst once regardless of the number of sources
+  void FoldPortable(char *dst, const char *const *sources, int count,
+      int offset, int length)
+  {
+    int idx = offset;
+    int end = offset + length;
+    for(; idx + 32 <= end; idx += 32) {
+      quint64 a[4], b[4];
+      memcpy(a, dst + idx, 32);
+      for(int src = 0; src < count; src++) {
+        memcpy(b, sources[src] + idx, 32);
+        a[0] ^= b[0];
+        a[1] ^= b[1];
+        a[2] ^= b[2];
+        a[3] ^= b[3];
+      }
+      memcpy(dst + idx, a, 32);
+    }
+
+    for(; idx < end; idx++) {
+      char a = dst[idx];
+      for(int src = 0; src < count; src++) {
+        a ^= sources[src][idx];
+      }
+      dst[idx] = a;
+    }
+  }
+
+#ifdef DISSENT_XOR_X86
+  __attribute__((target("sse2")))
+  void XorSSE2(char *dst, const char *t1, const char *t2, int length)
+  {
+    int idx = 0;
+    for(; idx + 64 <= length; idx += 64) {
+      __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t1 + idx));
+      __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t1 + idx + 16));
+      __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t1 + idx + 32));
+      __m128i a3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t1 + idx + 48));
+      __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t2 + idx));
+      __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t2 + idx + 16));
+      __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t2 + idx + 32));
+      __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t2 + idx + 48));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx), _mm_xor_si128(a0, b0));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx + 16), _mm_xor_si128(a1, b1));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx + 32), _mm_xor_si128(a2, b2));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx + 48), _mm_xor_si128(a3, b3));
+    }
+
+    for(; idx + 16 <= length; idx += 16) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t1 + idx));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t2 + idx));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx), _mm_xor_si128(a, b));
+    }
+
+    XorPortable(dst + idx, t1 + idx, t2 + idx, length - idx);
+  }
+
+  __attribute__((target("sse2")))
+  void FoldSSE2(char *dst, const char *const *sources, int count,
+      int offset, int length)
+  {
+    int idx = offset;
+    int end = offset + length;
+    for(; idx + 64 <= end; idx += 64) {
+      __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + idx));
+      __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + idx + 16));
+      __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + idx + 32));
+      __m128i a3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + idx + 48));
+      for(int src = 0; src < count; src++) {
+        const char *t = sources[src] + idx;
+        a0 = _mm_xor_si128(a0, _mm_loadu_si128(reinterpret_cast<const __m128i *>(t)));
+        a1 = _mm_xor_si128(a1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(t + 16)));
+        a2 = _mm_xor_si128(a2, _mm_loadu_si128(reinterpret_cast<const __m128i *>(t + 32)));
+        a3 = _mm_xor_si128(a3, _mm_loadu_si128(reinterpret_cast<const __m128i *>(t + 48)));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx), a0);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx + 16), a1);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx + 32), a2);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + idx + 48), a3);
+    }
+
+    FoldPortable(dst, sources, count, idx, end - idx);
+  }
+
+  __attribute__((target("avx2")))
+  void XorAVX2(char *dst, const char *t1, const char *t2, int length)
+  {
+    int idx = 0;
+    for(; idx + 128 <= length; idx += 128) {
+      __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t1 + idx));
+      __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t1 + idx + 32));
+      __m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t1 + idx + 64));
+      __m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t1 + idx + 96));
+      __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t2 + idx));
+      __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t2 + idx + 32));
+      __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t2 + idx + 64));
+      __m256i b3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t2 + idx + 96));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx), _mm256_xor_si256(a0, b0));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx + 32), _mm256_xor_si256(a1, b1));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx + 64), _mm256_xor_si256(a2, b2));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx + 96), _mm256_xor_si256(a3, b3));
+    }
+
+    for(; idx + 32 <= length; idx += 32) {
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t1 + idx));
+      __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t2 + idx));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx), _mm256_xor_si256(a, b));
+    }
+
+    XorPortable(dst + idx, t1 + idx, t2 + idx, length - idx);
+  }
+  __attribute__((target("avx2")))
+  void FoldAVX2(char *dst, const char *const *sources, int count,
+      int offset, int length)
+  {
+    int idx = offset;
+    int end = offset + length;
+    for(; idx + 128 <= end; idx += 128) {
+      __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + idx));
+      __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + idx + 32));
+      __m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + idx + 64));
+      __m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + idx + 96));
+      for(int src = 0; src < count; src++) {
+        const char *t = sources[src] + idx;
+        a0 = _mm256_xor_si256(a0, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t)));
+        a1 = _mm256_xor_si256(a1, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t + 32)));
+        a2 = _mm256_xor_si256(a2, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t + 64)));
+        a3 = _mm256_xor_si256(a3, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t + 96)));
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx), a0);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx + 32), a1);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx + 64), a2);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + idx + 96), a3);
+    }
+
+    FoldPortable(dst, sources, count, idx, end - idx);
+  }
+#endif
+}
+
+  void XorEngine::Xor(char *dst, const char *t1, const char *t2, int length)
+  {
+    if(length <= 0) {
+      return;
+    }
+    GetKernel()(dst, t1, t2, length);
+  }
+
+  void XorEngine::Fold(char *dst, const QVector<const char *> &sources,
+      int length)
+  {
+    if(sources.isEmpty() || length <= 0) {
+      return;
+    }
+    GetFoldKernel()(dst, sources.constData(), sources.count(), 0, length);
+  }
+
+  void XorEngine::Fold(QByteArray &dst, const QList<QByteArray> &sources)
+  {
+    if(sources.isEmpty()) {
+      return;
+    }
+
+    FoldKernel fold = GetFoldKernel();
+    char *cdst = dst.data();
+    int length = dst.size();
+    QVector<const char *> whole;
+    for(int offset = 0; offset < length; offset += ChunkSize) {
+      int count = qMin(ChunkSize, length - offset);
+
+      // Sources covering the whole chunk are folded in a single pass, only
+      // the tails of shorter sources are xored on their own
+      whole.clear();
+      foreach(const QByteArray &source, sources) {
+        int scount = qMin(count, source.size() - offset);
+        if(scount == count) {
+          whole.append(source.constData());
+        } else if(scount > 0) {
+          const char *csource = source.constData();
+          fold(cdst, &csource, 1, offset, scount);
+        }
+      }
+
+      if(!whole.isEmpty()) {
+        fold(cdst, whole.constData(), whole.count(), offset, count);
+      }
+    }
+  }
+
+  XorEngine::Implementation XorEngine::GetImplementation()
+  {
+    GetKernel();
+    return CurrentImplementation();
+  }
+
+  void XorEngine::SetImplementation(Implementation impl)
+  {
+    Kernel &kernel = GetKernel();
+    kernel = SelectKernel(impl);
+    GetFoldKernel() = SelectFoldKernel(CurrentImplementation());
+  }
+
+  bool XorEngine::IsSupported(Implementation impl)
+  {
+    switch(impl) {
+      case Portable:
+      case Automatic:
+        return true;
+#ifdef DISSENT_XOR_X86
+      case SSE2:
+        return __builtin_cpu_supports("sse2");
+      case AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+      default:
+        return false;
+    }
+  }
+
+  QString XorEngine::ImplementationToString(Implementation impl)
+  {
+    switch(impl) {
+      case Portable:
+        return "Portable";
+      case SSE2:
+        return "SSE2";
+      case AVX2:
+        return "AVX2";
+      case Automatic:
+        return "Automatic";
+      default:
+        return "Unknown";
+    }
+  }
+
+  XorEngine::Kernel &XorEngine::GetKernel()
+  {
+    static Kernel kernel = SelectKernel(Automatic);
+    return kernel;
+  }
+
+  XorEngine::FoldKernel &XorEngine::GetFoldKernel()
+  {
+    static FoldKernel kernel = SelectFoldKernel(GetImplementation());
+    return kernel;
+  }
+
+  XorEngine::Implementation &XorEngine::CurrentImplementation()
+  {
+    static Implementation impl = Portable;
+    return impl;
+  }
+
+  XorEngine::Kernel XorEngine::SelectKernel(Implementation impl)
+  {
+    if(impl == Automatic || !IsSupported(impl)) {
+      if(IsSupported(AVX2)) {
+        impl = AVX2;
+      } else if(IsSupported(SSE2)) {
+        impl = SSE2;
+      } else {
+        impl = Portable;
+      }
+    }
+
+    CurrentImplementation() = impl;
+    switch(impl) {
+#ifdef DISSENT_XOR_X86
+      case AVX2:
+        return &XorAVX2;
+      case SSE2:
+        return &XorSSE2;
+#endif
+      default:
+        return &XorPortable;
+    }
+  }
+
+  XorEngine::FoldKernel XorEngine::SelectFoldKernel(Implementation impl)
+  {
+    switch(impl) {
+#ifdef DISSENT_XOR_X86
+      case AVX2:
+        return &FoldAVX2;
+      case SSE2:
+        return &FoldSSE2;
+#endif
+      default:
+        return &FoldPortable;
+    }
+  }
+}
+}
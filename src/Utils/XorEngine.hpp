@@ -0,0 +1,100 @@
+#ifndef DISSENT_UTILS_XOR_ENGINE_H_GUARD
+#define DISSENT_UTILS_XOR_ENGINE_H_GUARD
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace Dissent {
+namespace Utils {
+  /**
+   * Xor over large blocks of memory, the inner loop of all DC-net
+   * exchanges.  The widest implementation supported by the running
+   * processor (AVX2, SSE2, or portable 64-bit words) is selected the first
+   * time the engine is used.
+   */
+  class XorEngine {
+    public:
+      /**
+       * The available xor implementations
+       */
+      enum Implementation {
+        Portable = 0,
+        SSE2,
+        AVX2,
+        Automatic
+      };
+
+      /**
+       * Sets dst to t1 ^ t2, dst may be t1 or t2
+       * @param dst the destination
+       * @param t1 lhs of the xor operation
+       * @param t2 rhs of the xor operation
+       * @param length amount of bytes to xor
+       */
+      static void Xor(char *dst, const char *t1, const char *t2, int length);
+
+      /**
+       * Xors every source into dst, i.e., dst ^= s0 ^ s1 ^ ..., making a
+       * single pass over dst, each block of dst is loaded and stored once
+       * @param dst the destination
+       * @param sources the byte arrays to fold into dst
+       * @param length amount of bytes to xor from each source
+       */
+      static void Fold(char *dst, const QVector<const char *> &sources,
+          int length);
+
+      /**
+       * Xors every source into dst, i.e., dst ^= s0 ^ s1 ^ ..., each source
+       * contributes its first min(dst.size(), source.size()) bytes
+       * @param dst the destination
+       * @param sources the byte arrays to fold into dst
+       */
+      static void Fold(QByteArray &dst, const QList<QByteArray> &sources);
+
+      /**
+       * Returns the implementation currently in use
+       */
+      static Implementation GetImplementation();
+
+      /**
+       * Overrides the selected implementation, falling back to the best
+       * supported implementation if the requested one is not available on
+       * this processor
+       * @param impl the implementation to use
+       */
+      static void SetImplementation(Implementation impl);
+
+      /**
+       * Returns true if the processor supports the implementation
+       */
+      static bool IsSupported(Implementation impl);
+
+      /**
+       * Converts an Implementation into a QString
+       */
+      static QString ImplementationToString(Implementation impl);
+
+      /**
+       * Size of the chunks used when folding sources of differing lengths
+       */
+      static const int ChunkSize = 16384;
+
+    private:
+      typedef void (*Kernel)(char *, const char *, const char *, int);
+      typedef void (*FoldKernel)(char *, const char *const *, int, int, int);
+
+      static Kernel &GetKernel();
+      static FoldKernel &GetFoldKernel();
+      static Implementation &CurrentImplementation();
+      static Kernel SelectKernel(Implementation impl);
+      static FoldKernel SelectFoldKernel(Implementation impl);
+
+      XorEngine() {}
+      Q_DISABLE_COPY(XorEngine)
+  };
+}
+}
+
+#endif
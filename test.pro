@@ -90,16 +90,20 @@ SOURCES += ext/googletest/src/gtest-all.cc \
            src/Tests/PairingGroupTest.cpp \
            src/Tests/PeerReviewTest.cpp \
            src/Tests/RandomTest.cpp \
+           src/Tests/RelayForwarderTest.cpp \
            src/Tests/RepeatingBulkRoundTest.cpp \
            src/Tests/RpcTest.cpp \
            src/Tests/RoundTest.cpp \
            src/Tests/SerializationTest.cpp \
            src/Tests/SettingsTest.cpp \
            src/Tests/ShuffleRoundTest.cpp \
+           src/Tests/SpillFileTest.cpp \
+           src/Tests/SpscQueueTest.cpp \
            src/Tests/TcpTest.cpp \
            src/Tests/TestNode.cpp \
            src/Tests/TestWebClient.cpp \
            src/Tests/TimeTest.cpp \
            src/Tests/TripleTest.cpp \
            src/Tests/WebServerTest.cpp \
-           src/Tests/WebServicesTest.cpp
+           src/Tests/WebServicesTest.cpp \
+           src/Tests/XorEngineTest.cpp
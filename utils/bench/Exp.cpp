@@ -57,6 +57,49 @@ namespace Benchmarks {
     }
   }
 
+  template<typename G> void FixedBaseBench(QSharedPointer<G> g)
+  {
+    Element v = g->RandomElement();
+    FixedBase fixed = g->PrecomputeFixedBase(v);
+    Element gen = g->GetGenerator();
+
+    int variable = 0;
+    int fixed_total = 0;
+    int generator = 0;
+
+    for(int i=0; i<1000; i++) {
+      Integer e = g->RandomExponent();
+
+      int start = QDateTime::currentMSecsSinceEpoch();
+      g->Exponentiate(v, e);
+      int end = QDateTime::currentMSecsSinceEpoch();
+      variable += (end-start);
+
+      start = QDateTime::currentMSecsSinceEpoch();
+      g->FixedBaseExponentiate(fixed, e);
+      end = QDateTime::currentMSecsSinceEpoch();
+      fixed_total += (end-start);
+
+      start = QDateTime::currentMSecsSinceEpoch();
+      g->Exponentiate(gen, e);
+      end = QDateTime::currentMSecsSinceEpoch();
+      generator += (end-start);
+    }
+
+    qDebug() << g->ToString() << g->GetSecurityParameter() << "variable" <<
+      variable << "fixed" << fixed_total << "generator" << generator;
+  }
+
+  TEST(Exp, FixedBase) {
+    for(int i=0; i<ECParams::INVALID; i++) {
+      FixedBaseBench(CppECGroup::GetGroup((ECParams::CurveName)i));
+      FixedBaseBench(OpenECGroup::GetGroup((ECParams::CurveName)i));
+      FixedBaseBench(BotanECGroup::GetGroup((ECParams::CurveName)i));
+    }
+
+    FixedBaseBench(IntegerGroup::GetGroup(IntegerGroup::PRODUCTION_2048));
+  }
+
   TEST(Exp, VaryPairing) {
     QSharedPointer<PairingG1Group> g1 = PairingG1Group::GetGroup(PairingGroup::PRODUCTION_512);
     QSharedPointer<PairingGTGroup> gT = PairingGTGroup::GetGroup(PairingGroup::PRODUCTION_512);
@@ -0,0 +1,97 @@
+#include <QDateTime>
+#include "Benchmark.hpp"
+
+namespace Dissent {
+namespace Benchmarks {
+
+  // The byte at a time xor used by the bulk rounds prior to XorEngine
+  void BytewiseXor(QByteArray &dst, const QByteArray &t1, const QByteArray &t2)
+  {
+    int count = std::min(dst.size(), t1.size());
+    count = std::min(count, t2.size());
+
+    for(int idx = 0; idx < count; idx++) {
+      dst[idx] = t1[idx] ^ t2[idx];
+    }
+  }
+
+  double ToGBps(qint64 bytes, qint64 msecs)
+  {
+    if(msecs == 0) {
+      msecs = 1;
+    }
+    return (bytes / (1024.0 * 1024.0 * 1024.0)) / (msecs / 1000.0);
+  }
+
+  // Server side fold of n client ciphertexts of the given length
+  void XorFold(int length, int count)
+  {
+    QScopedPointer<Dissent::Utils::Random> rand(
+        CryptoFactory::GetInstance().GetLibrary()->GetRandomNumberGenerator());
+
+    QList<QByteArray> ciphertexts;
+    for(int idx = 0; idx < count; idx++) {
+      QByteArray ciphertext(length, 0);
+      rand->GenerateBlock(ciphertext);
+      ciphertexts.append(ciphertext);
+    }
+
+    qint64 bytes = qint64(length) * count;
+
+    QByteArray base(length, 0);
+    qint64 start = QDateTime::currentMSecsSinceEpoch();
+    foreach(const QByteArray &ciphertext, ciphertexts) {
+      BytewiseXor(base, base, ciphertext);
+    }
+    qint64 end = QDateTime::currentMSecsSinceEpoch();
+    qDebug() << "," << length << "," << count << ", Bytewise, pairwise," <<
+      ToGBps(bytes, end - start);
+
+    for(int impl = XorEngine::Portable; impl < XorEngine::Automatic; impl++) {
+      XorEngine::Implementation ximpl = static_cast<XorEngine::Implementation>(impl);
+      if(!XorEngine::IsSupported(ximpl)) {
+        continue;
+      }
+      XorEngine::SetImplementation(ximpl);
+      QString name = XorEngine::ImplementationToString(ximpl);
+
+      QByteArray pairwise(length, 0);
+      start = QDateTime::currentMSecsSinceEpoch();
+      foreach(const QByteArray &ciphertext, ciphertexts) {
+        XorEngine::Xor(pairwise.data(), pairwise.constData(),
+            ciphertext.constData(), length);
+      }
+      end = QDateTime::currentMSecsSinceEpoch();
+      qDebug() << "," << length << "," << count << "," << name <<
+        ", pairwise," << ToGBps(bytes, end - start);
+
+      QByteArray folded(length, 0);
+      start = QDateTime::currentMSecsSinceEpoch();
+      XorEngine::Fold(folded, ciphertexts);
+      end = QDateTime::currentMSecsSinceEpoch();
+      qDebug() << "," << length << "," << count << "," << name <<
+        ", fold," << ToGBps(bytes, end - start);
+
+      EXPECT_EQ(pairwise, base);
+      EXPECT_EQ(folded, base);
+    }
+
+    XorEngine::SetImplementation(XorEngine::Automatic);
+  }
+
+  TEST(Xor, VaryLength) {
+    qDebug() << ", length, sources, implementation, mode, GB/s";
+    for(int length = 1024; length <= 16 * 1024 * 1024; length *= 4) {
+      XorFold(length, 64);
+    }
+  }
+
+  TEST(Xor, VarySources) {
+    qDebug() << ", length, sources, implementation, mode, GB/s";
+    for(int count = 2; count <= 512; count *= 2) {
+      XorFold(1024 * 1024, count);
+    }
+  }
+
+}
+}